@@ -2,8 +2,44 @@
 // #include "stm32f401xc.h"
 #include <stddef.h>  // Include for NULL definition
 #include <stdbool.h>
+#include <string.h>
+#include "Dma.h"
+#include "Irq.h"
+#include "Rcc.h"
 
 static bool adc_initialized = false;
+static bool adc_triggered = false;
+static volatile uint16_t adc_dma_buffer[ADC_MAX_SCAN_CHANNELS * ADC_SCAN_DEPTH];
+static uint8_t adc_scan_channels[ADC_MAX_SCAN_CHANNELS];
+static uint8_t adc_scan_count = 0;
+static uint16_t adc_dma_length = 0;
+
+typedef struct {
+    uint32_t acc;
+    uint16_t count;
+    uint16_t value;
+    uint8_t extra_bits;     // 0: disabled
+    bool ready;
+} ADC_Decimator_t;
+
+static ADC_Decimator_t adc_decimators[ADC_MAX_SCAN_CHANNELS];
+static uint8_t adc_decimation_frame = 0;   // next DMA frame to consume
+
+static ADC_WatchdogCallback_t adc_watchdog_callback = NULL;
+static volatile uint32_t adc_watchdog_trips = 0;
+
+static ADC_Status_t ADC_StartTriggered(uint32_t rate_hz);
+static void ADC_RecoverOverrun(void);
+// Newest complete frame: the one before the frame DMA is writing now
+static uint16_t ADC_PeekLatest(uint8_t index) {
+    uint32_t written = adc_dma_length - Dma_GetRemaining(DMA_2, ADC_DMA_STREAM);
+    uint32_t frame = (written / adc_scan_count + ADC_SCAN_DEPTH - 1) % ADC_SCAN_DEPTH;
+    return adc_dma_buffer[frame * adc_scan_count + index] & ADC_DR_DATA;
+}
+
+static void ADC_SetSampleTime(uint8_t channel, uint8_t sampling_time);
+static int8_t ADC_ScanIndex(uint8_t channel);
+static uint16_t ADC_PeekLatest(uint8_t index);
 
 ADC_Status_t ADC_Init(void) {
     if (adc_initialized) {
@@ -18,6 +54,13 @@ ADC_Status_t ADC_Init(void) {
     for (volatile int i = 0; i < 1000; i++);
 
 
+    // Smallest PCLK2 prescaler that keeps ADCCLK within spec
+    uint32_t prescaler = 0;
+    while (prescaler < 3 && Rcc_GetPclk2Hz() / (2 * (prescaler + 1)) > ADC_MAX_CLOCK_HZ) {
+        prescaler++;
+    }
+    ADC_COMMON->CCR = (ADC_COMMON->CCR & ~ADC_CCR_ADCPRE) | (prescaler << ADC_CCR_ADCPRE_Pos);
+
     // ADC configuration
     ADC1->CR1 &= ~ADC_CR1_RES;       // 12-bit resolution (bits 24:25 = 00)
     ADC1->CR2 &= ~ADC_CR2_ALIGN;     // Right alignment
@@ -50,15 +93,7 @@ ADC_Status_t ADC_Configure(ADC_Config_t *config) {
     }
 
     // Configure sampling time for the requested channel
-    if (config->channel <= 9) {
-        uint32_t shift = config->channel * 3;
-        ADC1->SMPR2 &= ~(0x7UL << shift);
-        ADC1->SMPR2 |= ((uint32_t)config->sampling_time << shift);
-    } else {
-        uint32_t shift = (config->channel - 10) * 3;
-        ADC1->SMPR1 &= ~(0x7UL << shift);
-        ADC1->SMPR1 |= ((uint32_t)config->sampling_time << shift);
-    }
+    ADC_SetSampleTime(config->channel, config->sampling_time);
 
     if (config->continuous_mode) {
         ADC1->CR2 |= ADC_CR2_CONT;
@@ -66,41 +101,361 @@ ADC_Status_t ADC_Configure(ADC_Config_t *config) {
         ADC1->CR2 &= ~ADC_CR2_CONT;
     }
 
+    if (config->trigger_rate_hz != 0) {
+        return ADC_ConfigureScan(&config->channel, 1, config->trigger_rate_hz);
+    }
+
+    return ADC_OK;
+}
+
+// One trigger converts the whole sequence (SCAN); DMA lays the results out
+// as frames of `count` samples, ADC_SCAN_DEPTH frames deep.
+ADC_Status_t ADC_ConfigureScan(const uint8_t *channels, uint8_t count, uint32_t frame_rate_hz) {
+    if (!adc_initialized || channels == NULL || count == 0 || count > ADC_MAX_SCAN_CHANNELS) {
+        return ADC_ERROR;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        if (channels[i] > ADC_CHANNEL_TEMPSENSOR) {
+            return ADC_ERROR;
+        }
+    }
+
+    ADC_StopTriggered();
+
+    uint32_t sqr[3] = {0, 0, 0};   // SQR3, SQR2, SQR1: six 5-bit slots each
+    bool internal = false;
+    for (uint8_t i = 0; i < count; i++) {
+        sqr[i / 6] |= (uint32_t)channels[i] << ((i % 6) * 5);
+        adc_scan_channels[i] = channels[i];
+
+        if (channels[i] == ADC_CHANNEL_VREFINT || channels[i] == ADC_CHANNEL_TEMPSENSOR) {
+            ADC_SetSampleTime(channels[i], ADC_SAMPLE_480_CYCLES);   // needs >= 10us
+            internal = true;
+        }
+    }
+    adc_scan_count = count;
+    adc_dma_length = (uint16_t)count * ADC_SCAN_DEPTH;
+    memset(adc_decimators, 0, sizeof(adc_decimators));
+    adc_decimation_frame = 0;
+
+    if (internal) {
+        ADC_COMMON->CCR &= ~ADC_CCR_VBATE;    // VBAT shares channel 18 with the sensor
+        ADC_COMMON->CCR |= ADC_CCR_TSVREFE;
+    }
+
+    ADC1->SQR3 = sqr[0];
+    ADC1->SQR2 = sqr[1];
+    ADC1->SQR1 = (sqr[2] & ~ADC_SQR1_L) | ((uint32_t)(count - 1) << ADC_SQR1_L_Pos);
+
+    if (count > 1) {
+        ADC1->CR1 |= ADC_CR1_SCAN;
+    } else {
+        ADC1->CR1 &= ~ADC_CR1_SCAN;
+    }
+
+    return ADC_StartTriggered(frame_rate_hz);
+}
+
+uint16_t ADC_GetChannelLatest(uint8_t channel) {
+    int8_t index = ADC_ScanIndex(channel);
+    if (index < 0) {
+        return 0;
+    }
+    ADC_RecoverOverrun();
+    return ADC_PeekLatest((uint8_t)index);
+}
+
+uint16_t ADC_GetChannelAverage(uint8_t channel) {
+    int8_t index = ADC_ScanIndex(channel);
+    if (index < 0) {
+        return 0;
+    }
+    ADC_RecoverOverrun();
+
+    uint32_t sum = 0;
+    for (uint32_t i = (uint8_t)index; i < adc_dma_length; i += adc_scan_count) {
+        sum += adc_dma_buffer[i] & ADC_DR_DATA;
+    }
+    return (uint16_t)((sum + ADC_SCAN_DEPTH / 2) / ADC_SCAN_DEPTH);
+}
+
+// VDDA from the factory VREFINT reading taken at 3.3V; 0 if VREFINT isn't scanned
+uint16_t ADC_GetVddaMillivolts(void) {
+    uint16_t vrefint = ADC_GetChannelAverage(ADC_CHANNEL_VREFINT);
+    if (vrefint == 0) {
+        return 0;
+    }
+    return (uint16_t)((ADC_VREFINT_CAL_MV * (uint32_t)ADC_VREFINT_CAL + vrefint / 2) / vrefint);
+}
+
+// Internal sensor in 0.1 degC, two-point factory calibration at 30 and 110 degC
+int16_t ADC_GetTemperatureDeciC(void) {
+    uint16_t raw = ADC_GetChannelAverage(ADC_CHANNEL_TEMPSENSOR);
+    uint16_t vdda = ADC_GetVddaMillivolts();
+    if (raw == 0) {
+        return 0;
+    }
+
+    // Calibration values were taken at VDDA = 3.3V
+    int32_t scaled = vdda ? (int32_t)(((uint32_t)raw * vdda + ADC_VREFINT_CAL_MV / 2) / ADC_VREFINT_CAL_MV) : raw;
+    int32_t span = (int32_t)ADC_TS_CAL2 - (int32_t)ADC_TS_CAL1;
+    if (span <= 0) {
+        return 0;
+    }
+    return (int16_t)(300 + ((scaled - (int32_t)ADC_TS_CAL1) * 800) / span);
+}
+
+ADC_Status_t ADC_EnableDecimation(uint8_t channel, uint8_t extra_bits) {
+    int8_t index = ADC_ScanIndex(channel);
+    if (index < 0 || extra_bits == 0 || extra_bits > ADC_DECIMATION_MAX_BITS) {
+        return ADC_ERROR;
+    }
+
+    ADC_Decimator_t *dec = &adc_decimators[(uint8_t)index];
+    memset(dec, 0, sizeof(*dec));
+    dec->extra_bits = extra_bits;
     return ADC_OK;
 }
 
-ADC_Status_t ADC_StartConversion(uint8_t channel) {
-    if (!adc_initialized || channel > 18) {
+// Consume the DMA frames completed since the last call. Must run at least
+// once per ADC_SCAN_DEPTH frames or DMA laps the read position.
+void ADC_PollDecimation(void) {
+    if (!adc_triggered) {
+        return;
+    }
+    ADC_RecoverOverrun();
+
+    uint32_t written = adc_dma_length - Dma_GetRemaining(DMA_2, ADC_DMA_STREAM);
+    uint8_t complete = (uint8_t)(written / adc_scan_count);   // frames DMA has finished
+
+    while (adc_decimation_frame != complete) {
+        volatile uint16_t *frame = &adc_dma_buffer[adc_decimation_frame * adc_scan_count];
+
+        for (uint8_t i = 0; i < adc_scan_count; i++) {
+            ADC_Decimator_t *dec = &adc_decimators[i];
+            if (dec->extra_bits == 0) {
+                continue;
+            }
+            dec->acc += frame[i] & ADC_DR_DATA;
+            if (++dec->count == (1U << (2 * dec->extra_bits))) {
+                dec->value = (uint16_t)(dec->acc >> dec->extra_bits);
+                dec->ready = true;
+                dec->acc = 0;
+                dec->count = 0;
+            }
+        }
+
+        adc_decimation_frame = (uint8_t)((adc_decimation_frame + 1) % ADC_SCAN_DEPTH);
+    }
+}
+
+// Latest decimated value, 0..ADC_DECIMATED_MAX(extra_bits)
+bool ADC_GetDecimated(uint8_t channel, uint32_t *value) {
+    int8_t index = ADC_ScanIndex(channel);
+    if (index < 0 || !adc_decimators[(uint8_t)index].ready) {
+        return false;
+    }
+    *value = adc_decimators[(uint8_t)index].value;
+    return true;
+}
+
+// The output only moves once the input leaves its rounding step by more
+// than band_permille; all math in permille of full_scale.
+uint8_t ADC_HysteresisPercent(ADC_Hysteresis_t *hyst, uint32_t value, uint32_t full_scale) {
+    if (full_scale == 0) {
+        return hyst->percent;
+    }
+    if (value > full_scale) {
+        value = full_scale;
+    }
+
+    uint32_t permille = (uint32_t)(((uint64_t)value * 1000U) / full_scale);
+    uint32_t centre = (uint32_t)hyst->percent * 10U;
+    uint32_t reach = 5U + hyst->band_permille;
+
+    if (!hyst->valid || permille > centre + reach || permille + reach < centre) {
+        hyst->percent = (uint8_t)(((uint64_t)value * 100U + full_scale / 2) / full_scale);
+        hyst->valid = true;
+    }
+    return hyst->percent;
+}
+
+ADC_Status_t ADC_ConfigureWatchdog(const ADC_Watchdog_Config_t *config) {
+    if (!adc_initialized || config == NULL || config->low > config->high ||
+        config->high > ADC_MAX_VALUE) {
         return ADC_ERROR;
     }
+    if (config->channel != ADC_WATCHDOG_ALL_CHANNELS && config->channel > ADC_CHANNEL_TEMPSENSOR) {
+        return ADC_ERROR;
+    }
+
+    ADC_DisableWatchdog();
+
+    ADC1->LTR = config->low;
+    ADC1->HTR = config->high;
+    adc_watchdog_callback = config->on_trip;
+
+    uint32_t cr1 = ADC1->CR1 & ~(ADC_CR1_AWDCH | ADC_CR1_AWDSGL);
+    if (config->channel != ADC_WATCHDOG_ALL_CHANNELS) {
+        cr1 |= ADC_CR1_AWDSGL | config->channel;
+    }
+    ADC1->CR1 = cr1 | ADC_CR1_AWDEN;
+
+    ADC_RearmWatchdog();
+    Irq_Enable(ADC_IRQ_NUM);
+    return ADC_OK;
+}
+
+// The interrupt is masked after a trip, since the flag would be set again
+// on every conversion while the input stays out of range
+void ADC_RearmWatchdog(void) {
+    ADC1->SR = (uint32_t)~ADC_SR_AWD;   // rc_w0: a plain store leaves EOC/OVR alone
+    ADC1->CR1 |= ADC_CR1_AWDIE;
+}
+
+void ADC_DisableWatchdog(void) {
+    ADC1->CR1 &= ~(ADC_CR1_AWDIE | ADC_CR1_AWDEN);
+    ADC1->SR = (uint32_t)~ADC_SR_AWD;
+}
+
+uint32_t ADC_GetWatchdogTrips(void) {
+    return adc_watchdog_trips;
+}
+
+void ADC_IRQHandler(void) {
+    uint32_t cr1 = ADC1->CR1;
+    if ((ADC1->SR & ADC_SR_AWD) && (cr1 & ADC_CR1_AWDIE)) {
+        // DR belongs to DMA; report the last sample it stored instead. Overrun
+        // recovery is left to the main loop, which owns the DMA stream.
+        uint8_t channel = ADC_WATCHDOG_ALL_CHANNELS;
+        uint16_t value = 0;
+        if (cr1 & ADC_CR1_AWDSGL) {
+            channel = (uint8_t)(cr1 & ADC_CR1_AWDCH);
+            int8_t index = ADC_ScanIndex(channel);
+            value = (index < 0) ? 0 : ADC_PeekLatest((uint8_t)index);
+        }
+
+        // Trip before the bookkeeping
+        if (adc_watchdog_callback != NULL) {
+            adc_watchdog_callback(channel, value);
+        }
+
+        ADC1->CR1 &= ~ADC_CR1_AWDIE;
+        ADC1->SR = (uint32_t)~ADC_SR_AWD;
+        adc_watchdog_trips++;
+    }
+}
 
-    // Set the channel for the first conversion in the regular sequence
-    ADC1->SQR3 &= ~ADC_SQR3_SQ1;  // Clear bits
-    ADC1->SQR3 |= ((uint32_t)channel << ADC_SQR3_SQ1_Pos);
+static int8_t ADC_ScanIndex(uint8_t channel) {
+    if (!adc_triggered) {
+        return -1;
+    }
+    for (uint8_t i = 0; i < adc_scan_count; i++) {
+        if (adc_scan_channels[i] == channel) {
+            return (int8_t)i;
+        }
+    }
+    return -1;
+}
 
-    ADC1->SR &= ~ADC_SR_EOC; // Clear End Of Conversion flag
+static void ADC_SetSampleTime(uint8_t channel, uint8_t sampling_time) {
+    if (channel <= 9) {
+        uint32_t shift = channel * 3;
+        ADC1->SMPR2 &= ~(0x7UL << shift);
+        ADC1->SMPR2 |= ((uint32_t)sampling_time << shift);
+    } else {
+        uint32_t shift = (channel - 10) * 3;
+        ADC1->SMPR1 &= ~(0x7UL << shift);
+        ADC1->SMPR1 |= ((uint32_t)sampling_time << shift);
+    }
+}
 
-    ADC1->CR2 |= ADC_CR2_SWSTART; // Start conversion
+// TIM5 runs in PWM mode 1; each CC1 rising edge starts one regular
+// sequence and DMA (with DDS, so requests keep coming) writes DR into
+// adc_dma_buffer. The sample rate no longer depends on the main loop.
+static ADC_Status_t ADC_StartTriggered(uint32_t rate_hz) {
+    uint32_t period_ticks = (rate_hz != 0) ? ADC_TRIGGER_TICK_HZ / rate_hz : 0;
+    if (period_ticks < 2) {
+        return ADC_ERROR;
+    }
 
+    ADC1->CR2 &= ~(ADC_CR2_CONT | ADC_CR2_EXTSEL | ADC_CR2_EXTEN);
+    ADC1->CR2 |= ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTSEL_TIM5_CC1 | ADC_CR2_EXTEN_RISING;
+
+    Dma_Config dma_config = {
+        .Channel = ADC_DMA_CHANNEL,
+        .Direction = DMA_PERIPH_TO_MEM,
+        .DataSize = DMA_SIZE_16,
+        .Circular = 1,
+        .MemIncrement = 1,
+        .Priority = DMA_PRIORITY_MEDIUM,
+        .Interrupts = 0,
+    };
+    Dma_Init(DMA_2, ADC_DMA_STREAM, &dma_config);
+    Dma_Start(DMA_2, ADC_DMA_STREAM, (uint32_t)&ADC1->DR, (uint32_t)adc_dma_buffer, adc_dma_length);
+
+    Rcc_Enable(RCC_TIM5);
+    ADC_TRIGGER_TIM->CR1 = 0;
+    ADC_TRIGGER_TIM->PSC = Rcc_GetTimerClockHz(RCC_APB1) / ADC_TRIGGER_TICK_HZ - 1;
+    ADC_TRIGGER_TIM->ARR = period_ticks - 1;
+    ADC_TRIGGER_TIM->CCR1 = period_ticks / 2;
+    ADC_TRIGGER_TIM->CCMR1 = ADC_TIM_CCMR1_OC1M_PWM1;
+    ADC_TRIGGER_TIM->CCER = ADC_TIM_CCER_CC1E;   // pin stays GPIO, only the trigger is used
+    ADC_TRIGGER_TIM->EGR = ADC_TIM_EGR_UG;
+    ADC_TRIGGER_TIM->CR1 = ADC_TIM_CR1_CEN;
+
+    adc_triggered = true;
     return ADC_OK;
 }
 
-bool ADC_IsConversionComplete(void) {
-    return (ADC1->SR & ADC_SR_EOC) != 0;
+void ADC_StopTriggered(void) {
+    if (!adc_triggered) {
+        return;
+    }
+
+    ADC_TRIGGER_TIM->CR1 &= ~ADC_TIM_CR1_CEN;
+    ADC1->CR2 &= ~(ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN);
+    Dma_Stop(DMA_2, ADC_DMA_STREAM);
+    adc_triggered = false;
+}
+
+// An overrun stops DMA requests until the DMA bit is toggled
+static void ADC_RecoverOverrun(void) {
+    if (!(ADC1->SR & ADC_SR_OVR)) {
+        return;
+    }
+
+    ADC1->CR2 &= ~ADC_CR2_DMA;
+    Dma_Start(DMA_2, ADC_DMA_STREAM, (uint32_t)&ADC1->DR, (uint32_t)adc_dma_buffer, adc_dma_length);
+    ADC1->SR = (uint32_t)~ADC_SR_OVR;
+    ADC1->CR2 |= ADC_CR2_DMA;
+    adc_decimation_frame = 0;   // DMA restarted at the top of the buffer
 }
 
-uint16_t ADC_ReadValue(void) {
-    return (uint16_t)(ADC1->DR & 0xFFF); // 12-bit data is lower 12 bits
+// First channel of the sequence
+uint16_t ADC_GetLatest(void) {
+    return adc_triggered ? ADC_GetChannelLatest(adc_scan_channels[0]) : 0;
 }
 
+uint16_t ADC_GetAverage(void) {
+    return adc_triggered ? ADC_GetChannelAverage(adc_scan_channels[0]) : 0;
+}
 
 uint16_t ADC_ReadBlocking(uint8_t channel) {
+    // The timer owns the sequencer in triggered mode
+    if (adc_triggered) {
+        return ADC_GetLatest();
+    }
+
     // Clear sequence register and set channel
+    ADC1->CR1 &= ~ADC_CR1_SCAN;
+    ADC1->SQR1 &= ~ADC_SQR1_L;
     ADC1->SQR3 = 0;
     ADC1->SQR3 |= (channel << 0);
 
-    // Clear any previous EOC flag
-    ADC1->SR &= ~ADC_SR_EOC;
+    // Clear any previous EOC flag (rc_w0: a plain store leaves the other flags alone)
+    ADC1->SR = (uint32_t)~ADC_SR_EOC;
 
     // Start conversion
     ADC1->CR2 |= ADC_CR2_SWSTART;
@@ -113,7 +468,11 @@ uint16_t ADC_ReadBlocking(uint8_t channel) {
 }
 float ADC_RawToVoltage(uint16_t raw_value) {
     if(raw_value > ADC_MAX_VALUE) raw_value = ADC_MAX_VALUE;
-    return ((float)raw_value * ADC_REFERENCE_VOLTAGE) / (float)ADC_MAX_VALUE;
+
+    // Use the measured supply when VREFINT is part of the scan
+    uint16_t vdda_mv = ADC_GetVddaMillivolts();
+    float reference = vdda_mv ? (float)vdda_mv / 1000.0f : ADC_REFERENCE_VOLTAGE;
+    return ((float)raw_value * reference) / (float)ADC_MAX_VALUE;
 }
 
 uint8_t ADC_RawToPercentage(uint16_t raw_value) {
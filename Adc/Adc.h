@@ -11,6 +11,16 @@
 
 // ADC Channel Definitions
 // #define ADC_POTENTIOMETER_CHANNEL   0   // Channel 0 for potentiometer
+#define ADC_CHANNEL_VREFINT     17
+#define ADC_CHANNEL_TEMPSENSOR  18
+
+#define ADC_SAMPLE_480_CYCLES   0x7
+
+// Factory calibration (system memory), taken at VDDA = 3.3V
+#define ADC_VREFINT_CAL_MV      3300UL
+#define ADC_VREFINT_CAL         (*(const volatile uint16_t *)0x1FFF7A2AUL)
+#define ADC_TS_CAL1             (*(const volatile uint16_t *)0x1FFF7A2CUL)  // 30 degC
+#define ADC_TS_CAL2             (*(const volatile uint16_t *)0x1FFF7A2EUL)  // 110 degC
 
 // ADC Status
 typedef enum {
@@ -25,8 +35,41 @@ typedef struct {
     uint8_t channel;        // ADC channel number
     uint8_t sampling_time; 
     bool continuous_mode;  
+    uint32_t trigger_rate_hz; // 0: software start, else timer-triggered with DMA
 } ADC_Config_t;
 
+// Decimation: 4^n samples summed and shifted right by n give 12+n bits
+#define ADC_DECIMATION_MAX_BITS 4
+#define ADC_DECIMATED_MAX(bits) ((uint32_t)ADC_MAX_VALUE << (bits))
+
+// Analog watchdog: the hardware compares every conversion of the guarded
+// channel (or of all channels) against one threshold pair
+#define ADC_WATCHDOG_ALL_CHANNELS 0xFF
+
+typedef void (*ADC_WatchdogCallback_t)(uint8_t channel, uint16_t value);
+
+typedef struct {
+    uint8_t channel;        // or ADC_WATCHDOG_ALL_CHANNELS
+    uint16_t low;           // trips below this...
+    uint16_t high;          // ...or above this (12-bit raw)
+    ADC_WatchdogCallback_t on_trip;   // called from ADC_IRQHandler
+} ADC_Watchdog_Config_t;
+
+// Percentage with a dead band so noise at a boundary doesn't toggle it
+typedef struct {
+    uint16_t band_permille; // extra margin beyond the rounding half-step
+    uint8_t percent;
+    bool valid;
+} ADC_Hysteresis_t;
+
+// Timer-triggered sampling: TIM5 CC1 starts each sequence and DMA2
+// stream 0 (channel 0) copies DR into a circular buffer of frames
+#define ADC_MAX_SCAN_CHANNELS   6
+#define ADC_SCAN_DEPTH          16      // frames kept per channel
+#define ADC_DMA_STREAM          0
+#define ADC_DMA_CHANNEL         0
+#define ADC_TRIGGER_TICK_HZ     1000000UL
+
 #define ADC1_BASE       (0x40012000UL)
 #define ADC1            ((ADC_TypeDef *)ADC1_BASE)
 
@@ -34,16 +77,30 @@ typedef struct {
 #define ADC_CR1_RES_Pos        24
 #define ADC_CR1_RES_Msk        (0x3UL << ADC_CR1_RES_Pos)
 #define ADC_CR1_RES            ADC_CR1_RES_Msk
+#define ADC_CR1_SCAN           (1UL << 8)
+#define ADC_CR1_AWDCH          (0x1FUL << 0)
+#define ADC_CR1_AWDIE          (1UL << 6)
+#define ADC_CR1_AWDSGL         (1UL << 9)
+#define ADC_CR1_AWDEN          (1UL << 23)
 
 #define ADC_CR2_ALIGN          (1UL << 11)
 #define ADC_CR2_CONT           (1UL << 1)
 #define ADC_CR2_EXTEN          (0x3UL << 28)
 #define ADC_CR2_ADON           (1UL << 0)
 #define ADC_CR2_SWSTART        (1UL << 30)
-
+#define ADC_CR2_DMA            (1UL << 8)
+#define ADC_CR2_DDS            (1UL << 9)
+#define ADC_CR2_EXTSEL_Pos     24
+#define ADC_CR2_EXTSEL         (0xFUL << ADC_CR2_EXTSEL_Pos)
+#define ADC_CR2_EXTSEL_TIM5_CC1 (0xAUL << ADC_CR2_EXTSEL_Pos)
+#define ADC_CR2_EXTEN_RISING   (0x1UL << 28)
+
+#define ADC_SR_AWD             (1UL << 0)
 #define ADC_SR_EOC             (1UL << 1)
+#define ADC_SR_OVR             (1UL << 5)
 
-#define ADC_SQR1_L             (0xF << 20)
+#define ADC_SQR1_L_Pos         20
+#define ADC_SQR1_L             (0xF << ADC_SQR1_L_Pos)
 #define ADC_SQR3_SQ1_Pos       0
 #define ADC_SQR3_SQ1           (0x1F << ADC_SQR3_SQ1_Pos)
 
@@ -53,38 +110,97 @@ typedef struct {
 // ADC Registers
 typedef struct
 {
-uint32_t SR;     /*!< ADC status register,                         Address offset: 0x00 */
-uint32_t CR1;    /*!< ADC control register 1,                      Address offset: 0x04 */
-uint32_t CR2;    /*!< ADC control register 2,                      Address offset: 0x08 */
-uint32_t SMPR1;  /*!< ADC sample time register 1,                  Address offset: 0x0C */
-uint32_t SMPR2;  /*!< ADC sample time register 2,                  Address offset: 0x10 */
-uint32_t JOFR1;  /*!< ADC injected channel data offset register 1, Address offset: 0x14 */
-uint32_t JOFR2;  /*!< ADC injected channel data offset register 2, Address offset: 0x18 */
-uint32_t JOFR3;  /*!< ADC injected channel data offset register 3, Address offset: 0x1C */
-uint32_t JOFR4;  /*!< ADC injected channel data offset register 4, Address offset: 0x20 */
-uint32_t HTR;    /*!< ADC watchdog higher threshold register,      Address offset: 0x24 */
-uint32_t LTR;    /*!< ADC watchdog lower threshold register,       Address offset: 0x28 */
-uint32_t SQR1;   /*!< ADC regular sequence register 1,             Address offset: 0x2C */
-uint32_t SQR2;   /*!< ADC regular sequence register 2,             Address offset: 0x30 */
-uint32_t SQR3;   /*!< ADC regular sequence register 3,             Address offset: 0x34 */
-uint32_t JSQR;   /*!< ADC injected sequence register,              Address offset: 0x38*/
-uint32_t JDR1;   /*!< ADC injected data register 1,                Address offset: 0x3C */
-uint32_t JDR2;   /*!< ADC injected data register 2,                Address offset: 0x40 */
-uint32_t JDR3;   /*!< ADC injected data register 3,                Address offset: 0x44 */
-uint32_t JDR4;   /*!< ADC injected data register 4,                Address offset: 0x48 */
-uint32_t DR;     /*!< ADC regular data register,                   Address offset: 0x4C */
+volatile uint32_t SR;     /*!< ADC status register,                         Address offset: 0x00 */
+volatile uint32_t CR1;    /*!< ADC control register 1,                      Address offset: 0x04 */
+volatile uint32_t CR2;    /*!< ADC control register 2,                      Address offset: 0x08 */
+volatile uint32_t SMPR1;  /*!< ADC sample time register 1,                  Address offset: 0x0C */
+volatile uint32_t SMPR2;  /*!< ADC sample time register 2,                  Address offset: 0x10 */
+volatile uint32_t JOFR1;  /*!< ADC injected channel data offset register 1, Address offset: 0x14 */
+volatile uint32_t JOFR2;  /*!< ADC injected channel data offset register 2, Address offset: 0x18 */
+volatile uint32_t JOFR3;  /*!< ADC injected channel data offset register 3, Address offset: 0x1C */
+volatile uint32_t JOFR4;  /*!< ADC injected channel data offset register 4, Address offset: 0x20 */
+volatile uint32_t HTR;    /*!< ADC watchdog higher threshold register,      Address offset: 0x24 */
+volatile uint32_t LTR;    /*!< ADC watchdog lower threshold register,       Address offset: 0x28 */
+volatile uint32_t SQR1;   /*!< ADC regular sequence register 1,             Address offset: 0x2C */
+volatile uint32_t SQR2;   /*!< ADC regular sequence register 2,             Address offset: 0x30 */
+volatile uint32_t SQR3;   /*!< ADC regular sequence register 3,             Address offset: 0x34 */
+volatile uint32_t JSQR;   /*!< ADC injected sequence register,              Address offset: 0x38*/
+volatile uint32_t JDR1;   /*!< ADC injected data register 1,                Address offset: 0x3C */
+volatile uint32_t JDR2;   /*!< ADC injected data register 2,                Address offset: 0x40 */
+volatile uint32_t JDR3;   /*!< ADC injected data register 3,                Address offset: 0x44 */
+volatile uint32_t JDR4;   /*!< ADC injected data register 4,                Address offset: 0x48 */
+volatile uint32_t DR;     /*!< ADC regular data register,                   Address offset: 0x4C */
 } ADC_TypeDef;
 
+#define ADC_IRQ_NUM            18      // ADC global interrupt
+
+// ADC common registers
+#define ADC_COMMON_BASE        (0x40012300UL)
+#define ADC_COMMON             ((ADC_Common_TypeDef *)ADC_COMMON_BASE)
+
+typedef struct
+{
+volatile uint32_t CSR;   /*!< ADC common status register,          Address offset: 0x00 */
+volatile uint32_t CCR;   /*!< ADC common control register,         Address offset: 0x04 */
+volatile uint32_t CDR;   /*!< ADC common regular data register,    Address offset: 0x08 */
+} ADC_Common_TypeDef;
+
+#define ADC_CCR_ADCPRE_Pos     16
+#define ADC_CCR_ADCPRE         (0x3UL << ADC_CCR_ADCPRE_Pos)   // PCLK2 / 2, 4, 6, 8
+#define ADC_CCR_VBATE          (1UL << 22)
+#define ADC_MAX_CLOCK_HZ       36000000UL
+#define ADC_CCR_TSVREFE        (1UL << 23)
+
+// Trigger timer (TIM5) registers
+#define ADC_TRIGGER_TIM_BASE   (0x40000C00UL)
+#define ADC_TRIGGER_TIM        ((ADC_TIM_TypeDef *)ADC_TRIGGER_TIM_BASE)
+
+typedef struct
+{
+volatile uint32_t CR1;   /*!< TIM control register 1,              Address offset: 0x00 */
+volatile uint32_t CR2;   /*!< TIM control register 2,              Address offset: 0x04 */
+volatile uint32_t SMCR;  /*!< TIM slave mode control register,     Address offset: 0x08 */
+volatile uint32_t DIER;  /*!< TIM DMA/interrupt enable register,   Address offset: 0x0C */
+volatile uint32_t SR;    /*!< TIM status register,                 Address offset: 0x10 */
+volatile uint32_t EGR;   /*!< TIM event generation register,       Address offset: 0x14 */
+volatile uint32_t CCMR1; /*!< TIM capture/compare mode register 1, Address offset: 0x18 */
+volatile uint32_t CCMR2; /*!< TIM capture/compare mode register 2, Address offset: 0x1C */
+volatile uint32_t CCER;  /*!< TIM capture/compare enable register, Address offset: 0x20 */
+volatile uint32_t CNT;   /*!< TIM counter register,                Address offset: 0x24 */
+volatile uint32_t PSC;   /*!< TIM prescaler,                       Address offset: 0x28 */
+volatile uint32_t ARR;   /*!< TIM auto-reload register,            Address offset: 0x2C */
+volatile uint32_t RCR;   /*!< TIM repetition counter register,     Address offset: 0x30 */
+volatile uint32_t CCR1;  /*!< TIM capture/compare register 1,      Address offset: 0x34 */
+} ADC_TIM_TypeDef;
+
+#define ADC_TIM_CR1_CEN        (1UL << 0)
+#define ADC_TIM_EGR_UG         (1UL << 0)
+#define ADC_TIM_CCMR1_OC1M_PWM1 (0x6UL << 4)
+#define ADC_TIM_CCER_CC1E      (1UL << 0)
+
 
 ADC_Status_t ADC_Init(void);
 ADC_Status_t ADC_Configure(ADC_Config_t *config);
-ADC_Status_t ADC_StartConversion(uint8_t channel);
-uint16_t ADC_ReadValue();
 uint16_t ADC_ReadBlocking(uint8_t channel);
 float ADC_RawToVoltage(uint16_t raw_value);
 uint8_t ADC_RawToPercentage(uint16_t raw_value);
-bool ADC_IsConversionComplete(void);
 void ADC_Enable(void);
 void ADC_Disable();
+ADC_Status_t ADC_ConfigureScan(const uint8_t *channels, uint8_t count, uint32_t frame_rate_hz);
+void ADC_StopTriggered(void);
+uint16_t ADC_GetLatest(void);   // newest DMA sample of the first channel, never waits
+uint16_t ADC_GetAverage(void);  // mean over the DMA buffer of the first channel
+uint16_t ADC_GetChannelLatest(uint8_t channel);
+uint16_t ADC_GetChannelAverage(uint8_t channel);
+uint16_t ADC_GetVddaMillivolts(void);
+int16_t ADC_GetTemperatureDeciC(void);
+ADC_Status_t ADC_EnableDecimation(uint8_t channel, uint8_t extra_bits);
+void ADC_PollDecimation(void);
+bool ADC_GetDecimated(uint8_t channel, uint32_t *value);
+ADC_Status_t ADC_ConfigureWatchdog(const ADC_Watchdog_Config_t *config);
+void ADC_RearmWatchdog(void);
+void ADC_DisableWatchdog(void);
+uint32_t ADC_GetWatchdogTrips(void);
+uint8_t ADC_HysteresisPercent(ADC_Hysteresis_t *hyst, uint32_t value, uint32_t full_scale);
 
 #endif // ADC_H
\ No newline at end of file
@@ -0,0 +1,85 @@
+/**
+ * Dma.c
+ *
+ *  Minimal stream driver for DMA1/DMA2.
+ */
+
+#include "Dma.h"
+
+#include "Bit_Operations.h"
+#include "Dma_Private.h"
+#include "Rcc.h"
+#include "Std_Types.h"
+
+static DMA_Type* const dma_map[2] = {(DMA_Type*) DMA1_BASE_ADDR, (DMA_Type*) DMA2_BASE_ADDR};
+
+// Flag offsets of streams 0-3 in LISR (4-7 repeat in HISR)
+static const uint8 dma_flag_shift[4] = {0, 6, 16, 22};
+
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config) {
+    DMA_StreamType* S = &dma_map[Controller]->STREAM[Stream];
+
+    Rcc_Enable(Controller == DMA_1 ? RCC_DMA1 : RCC_DMA2);
+
+    CLEAR_BIT(S->CR, DMA_CR_EN);
+    while (READ_BIT(S->CR, DMA_CR_EN));     // wait for the stream to release
+    Dma_ClearFlags(Controller, Stream, DMA_FLAG_ALL);
+
+    uint32 Cr = ((uint32)Config->Channel << DMA_CR_CHSEL)
+              | ((uint32)Config->Priority << DMA_CR_PL)
+              | ((uint32)Config->DataSize << DMA_CR_MSIZE)
+              | ((uint32)Config->DataSize << DMA_CR_PSIZE)
+              | ((uint32)Config->Direction << DMA_CR_DIR);
+    if (Config->MemIncrement) Cr |= (1UL << DMA_CR_MINC);
+    if (Config->Circular) Cr |= (1UL << DMA_CR_CIRC);
+    if (Config->Interrupts & DMA_FLAG_TE) Cr |= (1UL << DMA_CR_TEIE);
+    if (Config->Interrupts & DMA_FLAG_HT) Cr |= (1UL << DMA_CR_HTIE);
+    if (Config->Interrupts & DMA_FLAG_TC) Cr |= (1UL << DMA_CR_TCIE);
+
+    S->CR = Cr;
+    S->FCR = 0;                             // direct mode
+}
+
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count) {
+    DMA_StreamType* S = &dma_map[Controller]->STREAM[Stream];
+
+    CLEAR_BIT(S->CR, DMA_CR_EN);
+    while (READ_BIT(S->CR, DMA_CR_EN));
+    Dma_ClearFlags(Controller, Stream, DMA_FLAG_ALL);
+
+    S->PAR = PeriphAddr;
+    S->M0AR = MemAddr;
+    S->NDTR = Count;
+    SET_BIT(S->CR, DMA_CR_EN);
+}
+
+void Dma_Stop(uint8 Controller, uint8 Stream) {
+    DMA_StreamType* S = &dma_map[Controller]->STREAM[Stream];
+
+    CLEAR_BIT(S->CR, DMA_CR_EN);
+    while (READ_BIT(S->CR, DMA_CR_EN));
+}
+
+uint8 Dma_IsEnabled(uint8 Controller, uint8 Stream) {
+    return READ_BIT(dma_map[Controller]->STREAM[Stream].CR, DMA_CR_EN);
+}
+
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream) {
+    return (uint16)dma_map[Controller]->STREAM[Stream].NDTR;
+}
+
+uint8 Dma_GetFlags(uint8 Controller, uint8 Stream) {
+    DMA_Type* D = dma_map[Controller];
+    uint32 Isr = (Stream < 4) ? D->LISR : D->HISR;
+
+    return (uint8)((Isr >> dma_flag_shift[Stream % 4]) & DMA_FLAG_ALL);
+}
+
+void Dma_ClearFlags(uint8 Controller, uint8 Stream, uint8 Flags) {
+    DMA_Type* D = dma_map[Controller];
+    uint32 Mask = (uint32)(Flags & DMA_FLAG_ALL) << dma_flag_shift[Stream % 4];
+
+    // Write-1-to-clear, plain store
+    if (Stream < 4) D->LIFCR = Mask;
+    else D->HIFCR = Mask;
+}
@@ -0,0 +1,62 @@
+/**
+ * Dma.h
+ *
+ *  Minimal stream driver for DMA1/DMA2.
+ */
+
+#ifndef DMA_H
+#define DMA_H
+#include "Std_Types.h"
+
+#define DMA_1               0
+#define DMA_2               1
+
+// Direction
+#define DMA_PERIPH_TO_MEM   0x0
+#define DMA_MEM_TO_PERIPH   0x1
+
+// DataSize (same on both sides)
+#define DMA_SIZE_8          0x0
+#define DMA_SIZE_16         0x1
+#define DMA_SIZE_32         0x2
+
+// Priority
+#define DMA_PRIORITY_LOW    0x0
+#define DMA_PRIORITY_MEDIUM 0x1
+#define DMA_PRIORITY_HIGH   0x2
+#define DMA_PRIORITY_MAX    0x3
+
+// Interrupts / Flags (normalized, independent of the stream's bit offset)
+#define DMA_FLAG_FE         (1U << 0)
+#define DMA_FLAG_DME        (1U << 2)
+#define DMA_FLAG_TE         (1U << 3)
+#define DMA_FLAG_HT         (1U << 4)
+#define DMA_FLAG_TC         (1U << 5)
+#define DMA_FLAG_ALL        (DMA_FLAG_FE | DMA_FLAG_DME | DMA_FLAG_TE | DMA_FLAG_HT | DMA_FLAG_TC)
+
+typedef struct {
+    uint8 Channel;          // request channel 0-7
+    uint8 Direction;
+    uint8 DataSize;
+    uint8 Circular;
+    uint8 MemIncrement;
+    uint8 Priority;
+    uint8 Interrupts;       // DMA_FLAG_HT | DMA_FLAG_TC | DMA_FLAG_TE
+} Dma_Config;
+
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config);
+
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count);
+
+void Dma_Stop(uint8 Controller, uint8 Stream);
+
+uint8 Dma_IsEnabled(uint8 Controller, uint8 Stream);
+
+// Items left before the end of the buffer (NDTR)
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream);
+
+uint8 Dma_GetFlags(uint8 Controller, uint8 Stream);
+
+void Dma_ClearFlags(uint8 Controller, uint8 Stream, uint8 Flags);
+
+#endif /* DMA_H */
@@ -0,0 +1,47 @@
+/**
+ * Dma_Private.h
+ *
+ *  DMA1/DMA2 register map.
+ */
+
+#ifndef DMA_PRIVATE_H
+#define DMA_PRIVATE_H
+#include "Std_Types.h"
+
+#define DMA1_BASE_ADDR      0x40026000UL
+#define DMA2_BASE_ADDR      0x40026400UL
+
+typedef struct
+{
+    volatile uint32 CR;
+    volatile uint32 NDTR;
+    volatile uint32 PAR;
+    volatile uint32 M0AR;
+    volatile uint32 M1AR;
+    volatile uint32 FCR;
+} DMA_StreamType;
+
+typedef struct
+{
+    volatile uint32 LISR;
+    volatile uint32 HISR;
+    volatile uint32 LIFCR;
+    volatile uint32 HIFCR;
+    DMA_StreamType STREAM[8];
+} DMA_Type;
+
+// DMA_SxCR bits
+#define DMA_CR_EN           0
+#define DMA_CR_TEIE         2
+#define DMA_CR_HTIE         3
+#define DMA_CR_TCIE         4
+#define DMA_CR_DIR          6
+#define DMA_CR_CIRC         8
+#define DMA_CR_PINC         9
+#define DMA_CR_MINC         10
+#define DMA_CR_PSIZE        11
+#define DMA_CR_MSIZE        13
+#define DMA_CR_PL           16
+#define DMA_CR_CHSEL        25
+
+#endif /* DMA_PRIVATE_H */
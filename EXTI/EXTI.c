@@ -1,10 +1,35 @@
 #include "EXTI.h"
 #include "GPIO.h"
 #include "EXTI_Private.h"
+#include "Rcc.h"
+#include "Irq.h"
+#include <stdint.h>
 
 SYSCFG_EXTILineConfig* EXTI_SYSCFG = (SYSCFG_EXTILineConfig*) SYSCFG_EXTI_BaseAddr;
 uint8 CFG_Options[] = {CFG_PA, CFG_PB, CFG_PC, CFG_PD, CFG_PE, CFG_PH};
-NVIC_Type* NVIC = (NVIC_Type*) NVIC_ISER_BASE_Addr;
+
+// NVIC interrupt number for each EXTI line
+static const uint8 EXTI_IrqNumber[EXTI_LINE_COUNT] = {
+    EXTI0_IRQ_NUM, EXTI0_IRQ_NUM + 1, EXTI0_IRQ_NUM + 2, EXTI0_IRQ_NUM + 3, EXTI0_IRQ_NUM + 4,
+    EXTI9_5_IRQ_NUM, EXTI9_5_IRQ_NUM, EXTI9_5_IRQ_NUM, EXTI9_5_IRQ_NUM, EXTI9_5_IRQ_NUM,
+    EXTI15_10_IRQ_NUM, EXTI15_10_IRQ_NUM, EXTI15_10_IRQ_NUM,
+    EXTI15_10_IRQ_NUM, EXTI15_10_IRQ_NUM, EXTI15_10_IRQ_NUM,
+};
+
+typedef struct
+{
+    EXTI_Callback Callback;
+    void* Context;
+    uint8 Port;
+    uint8 Trigger;
+    uint8 DebounceMode;
+    uint16 DebounceTicks;
+    uint16 Deadline;        // TIM9 count at which the window ends
+} EXTI_Handler;
+
+static EXTI_Handler EXTI_Handlers[EXTI_LINE_COUNT];
+static volatile uint32 EXTI_DebouncePending = 0;   // lines masked and waiting
+static uint8 EXTI_DebounceReady = 0;
 
 void EXTI_Init(uint8 PortName, uint8 LineNumber, uint8 TriggerType)
 {
@@ -44,30 +69,220 @@ void EXTI_Enable(uint8 LineNumber)
     // enable mask at both EXTI and NVIC
     EXTI_REGISTERS->EXTI_IMR |= (1 << LineNumber);
 
-    uint8 NVIC_line;
-    if (LineNumber < 5) NVIC_line = LineNumber + 6;
-    else if (LineNumber < 10) NVIC_line = 23;
-    else NVIC_line = 40;
-
-    if (NVIC_line == 40) NVIC->NVIC_ISER[1] |= (1 << (NVIC_line - 32));
-    else NVIC->NVIC_ISER[0] |= (1 << NVIC_line);
+    Irq_Enable(EXTI_IrqNumber[LineNumber]);
 }
 
 void EXTI_Disable(uint8 LineNumber)
 {
-    // disable mask at both EXTI and NVIC
+    // disable mask at both EXTI and NVIC; a shared vector stays on while
+    // another line of its group is still unmasked
     EXTI_REGISTERS->EXTI_IMR &= ~(1 << LineNumber);
 
-    uint8 NVIC_line;
-    if (LineNumber < 5) NVIC_line = LineNumber + 6;
-    else if (LineNumber < 10) NVIC_line = 23;
-    else NVIC_line = 40;
-
-    if (NVIC_line == 40) NVIC->NVIC_ICER[1] |= (1 << (NVIC_line - 32));
-    else NVIC->NVIC_ICER[0] |= (1 << NVIC_line);
+    uint8 irq = EXTI_IrqNumber[LineNumber];
+    uint32 group = (irq == EXTI9_5_IRQ_NUM) ? EXTI_LINES_9_5
+                 : (irq == EXTI15_10_IRQ_NUM) ? EXTI_LINES_15_10
+                 : (1UL << LineNumber);
+    if ((EXTI_REGISTERS->EXTI_IMR & group) == 0) {
+        Irq_Disable(irq);
+    }
 }
 
-// In EXTI.c
+// PR is write-1-to-clear: a read-modify-write would clear every pending line
 void EXTI_ClearPending(uint8 LineNumber) {
-    EXTI_REGISTERS->EXTI_PR |= (1 << LineNumber);
-}
\ No newline at end of file
+    EXTI_REGISTERS->EXTI_PR = (1UL << LineNumber);
+}
+
+uint8 EXTI_Register(uint8 LineNumber, uint8 PortName, uint8 TriggerType,
+                    EXTI_Callback Callback, void* Context)
+{
+    if (LineNumber >= EXTI_LINE_COUNT || Callback == 0) {
+        return EXTI_NOK;
+    }
+
+    EXTI_Disable(LineNumber);
+    EXTI_Handlers[LineNumber].Callback = Callback;
+    EXTI_Handlers[LineNumber].Context = Context;
+    EXTI_Handlers[LineNumber].Port = PortName;
+    EXTI_Handlers[LineNumber].Trigger = TriggerType;
+
+    EXTI_Init(PortName, LineNumber, TriggerType);
+    EXTI_ClearPending(LineNumber);
+    EXTI_Enable(LineNumber);
+    return EXTI_OK;
+}
+
+void EXTI_Unregister(uint8 LineNumber)
+{
+    if (LineNumber >= EXTI_LINE_COUNT) {
+        return;
+    }
+    EXTI_Disable(LineNumber);
+    EXTI_DebouncePending &= ~(1UL << LineNumber);
+    EXTI_Handlers[LineNumber].Callback = 0;
+    EXTI_Handlers[LineNumber].Context = 0;
+    EXTI_Handlers[LineNumber].DebounceMode = EXTI_DEBOUNCE_OFF;
+}
+
+static void EXTI_DebounceInit(void)
+{
+    Rcc_Enable(RCC_TIM9);
+    EXTI_DEBOUNCE_TIM->CR1 = 0;
+    EXTI_DEBOUNCE_TIM->PSC = Rcc_GetTimerClockHz(RCC_APB2) / EXTI_DEBOUNCE_TICK_HZ - 1;
+    EXTI_DEBOUNCE_TIM->ARR = 0xFFFF;
+    EXTI_DEBOUNCE_TIM->EGR = TIM_EGR_UG_BIT;
+    EXTI_DEBOUNCE_TIM->SR = 0;
+    EXTI_DEBOUNCE_TIM->DIER = 0;
+    EXTI_DEBOUNCE_TIM->CR1 = TIM_CR1_CEN_BIT;
+
+    Irq_Enable(EXTI_DEBOUNCE_IRQ_NUM);
+    EXTI_DebounceReady = 1;
+}
+
+void EXTI_SetDebounce(uint8 LineNumber, uint8 Mode, uint16 WindowMs)
+{
+    if (LineNumber >= EXTI_LINE_COUNT) {
+        return;
+    }
+    if (!EXTI_DebounceReady) {
+        EXTI_DebounceInit();
+    }
+    if (WindowMs > EXTI_DEBOUNCE_MAX_MS) {
+        WindowMs = EXTI_DEBOUNCE_MAX_MS;
+    }
+
+    uint32 primask = Irq_Save();
+    EXTI_Handlers[LineNumber].DebounceMode = (WindowMs == 0) ? EXTI_DEBOUNCE_OFF : Mode;
+    EXTI_Handlers[LineNumber].DebounceTicks = (uint16)(WindowMs * (EXTI_DEBOUNCE_TICK_HZ / 1000UL));
+    Irq_Restore(primask);
+}
+
+// Point CC1 at the earliest deadline; the compare interrupt is only on
+// while some line is waiting. Interrupts must be off.
+static void EXTI_DebounceArm(void)
+{
+    uint32 pending = EXTI_DebouncePending;
+    if (pending == 0) {
+        EXTI_DEBOUNCE_TIM->DIER &= ~TIM_DIER_CC1IE_BIT;
+        return;
+    }
+
+    uint16 now = (uint16)EXTI_DEBOUNCE_TIM->CNT;
+    int32_t soonest = 0x7FFF;
+    while (pending) {
+        uint8 line = (uint8)__builtin_ctz(pending);
+        pending &= pending - 1;
+        int32_t left = (int16_t)(EXTI_Handlers[line].Deadline - now);
+        if (left < soonest) {
+            soonest = left;
+        }
+    }
+    if (soonest < 1) {
+        soonest = 1;    // overdue: fire on the next tick
+    }
+
+    EXTI_DEBOUNCE_TIM->CCR1 = (uint16)(now + soonest);
+    EXTI_DEBOUNCE_TIM->SR = (uint32)~TIM_SR_CC1IF_BIT;   // rc_w0: a plain store leaves the other flags alone
+    EXTI_DEBOUNCE_TIM->DIER |= TIM_DIER_CC1IE_BIT;
+}
+
+static void EXTI_DebounceStart(uint8 LineNumber)
+{
+    EXTI_Handler* handler = &EXTI_Handlers[LineNumber];
+
+    uint32 primask = Irq_Save();
+    EXTI_REGISTERS->EXTI_IMR &= ~(1UL << LineNumber);
+    handler->Deadline = (uint16)(EXTI_DEBOUNCE_TIM->CNT + handler->DebounceTicks);
+    EXTI_DebouncePending |= (1UL << LineNumber);
+    EXTI_DebounceArm();
+    Irq_Restore(primask);
+}
+
+static uint8 EXTI_LevelIsActive(const EXTI_Handler* handler, uint8 LineNumber)
+{
+    uint8 level = Gpio_ReadPin(handler->Port, LineNumber);
+    switch (handler->Trigger) {
+        case FALLING_EDGE_TRIGGERED: return level == 0;
+        case RISING_EDGE_TRIGGERED:  return level == 1;
+        default:                     return 1;
+    }
+}
+
+void TIM1_BRK_TIM9_IRQHandler(void)
+{
+    EXTI_DEBOUNCE_TIM->SR = (uint32)~TIM_SR_CC1IF_BIT;
+
+    uint32 primask = Irq_Save();
+    uint16 now = (uint16)EXTI_DEBOUNCE_TIM->CNT;
+    uint32 expired = 0;
+    uint32 pending = EXTI_DebouncePending;
+    while (pending) {
+        uint8 line = (uint8)__builtin_ctz(pending);
+        pending &= pending - 1;
+        if ((int16_t)(now - EXTI_Handlers[line].Deadline) >= 0) {
+            expired |= (1UL << line);
+        }
+    }
+
+    // Drop edges latched during the window before unmasking
+    EXTI_DebouncePending &= ~expired;
+    EXTI_REGISTERS->EXTI_PR = expired;
+    EXTI_REGISTERS->EXTI_IMR |= expired;
+    EXTI_DebounceArm();
+    Irq_Restore(primask);
+
+    while (expired) {
+        uint8 line = (uint8)__builtin_ctz(expired);
+        expired &= expired - 1;
+
+        EXTI_Handler* handler = &EXTI_Handlers[line];
+        if (handler->DebounceMode == EXTI_DEBOUNCE_TRAILING && handler->Callback &&
+            EXTI_LevelIsActive(handler, line)) {
+            handler->Callback(line, handler->Context);
+        }
+    }
+}
+
+void EXTI_SetPriority(uint8 LineNumber, uint8 Priority)
+{
+    if (LineNumber >= EXTI_LINE_COUNT) {
+        return;
+    }
+    Irq_SetPriority(EXTI_IrqNumber[LineNumber], Priority);
+}
+
+void EXTI_SetDebouncePriority(uint8 Priority)
+{
+    Irq_SetPriority(EXTI_DEBOUNCE_IRQ_NUM, Priority);
+}
+
+// Each pending line costs one count-trailing-zeros (RBIT + CLZ on the M4)
+// plus its callback, whatever its position in the group
+static void EXTI_Dispatch(uint32 Lines)
+{
+    uint32 pending = EXTI_REGISTERS->EXTI_PR & EXTI_REGISTERS->EXTI_IMR & Lines;
+    EXTI_REGISTERS->EXTI_PR = pending;
+
+    while (pending) {
+        uint8 line = (uint8)__builtin_ctz(pending);
+        pending &= pending - 1;
+
+        EXTI_Handler* handler = &EXTI_Handlers[line];
+        if (handler->DebounceMode != EXTI_DEBOUNCE_OFF) {
+            EXTI_DebounceStart(line);
+            if (handler->DebounceMode != EXTI_DEBOUNCE_LEADING) {
+                continue;
+            }
+        }
+        if (handler->Callback) {
+            handler->Callback(line, handler->Context);
+        }
+    }
+}
+
+void EXTI0_IRQHandler(void)     { EXTI_Dispatch(1UL << 0); }
+void EXTI1_IRQHandler(void)     { EXTI_Dispatch(1UL << 1); }
+void EXTI2_IRQHandler(void)     { EXTI_Dispatch(1UL << 2); }
+void EXTI3_IRQHandler(void)     { EXTI_Dispatch(1UL << 3); }
+void EXTI4_IRQHandler(void)     { EXTI_Dispatch(1UL << 4); }
+void EXTI9_5_IRQHandler(void)   { EXTI_Dispatch(EXTI_LINES_9_5); }
+void EXTI15_10_IRQHandler(void) { EXTI_Dispatch(EXTI_LINES_15_10); }
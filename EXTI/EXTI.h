@@ -9,6 +9,11 @@
 #define RISING_EDGE_TRIGGERED 1
 #define EDGE_TRIGGERED 2
 
+#define EXTI_LINE_COUNT 16
+
+#define EXTI_OK  0x0
+#define EXTI_NOK 0x1
+
 typedef struct
 {
     volatile uint32 EXTI_IMR;
@@ -21,6 +26,9 @@ typedef struct
 
 #define EXTI_REGISTERS ((volatile EXTI_Type*) EXTI_BaseAddr)
 
+// Runs in interrupt context with the pending bit already cleared
+typedef void (*EXTI_Callback)(uint8 LineNumber, void* Context);
+
 void EXTI_Init(uint8 PortName, uint8 LineNumber, uint8 TriggerType);
 
 void EXTI_Enable(uint8 LineNumber);
@@ -29,4 +37,28 @@ void EXTI_Disable(uint8 LineNumber);
 
 void EXTI_ClearPending(uint8 LineNumber);
 
+// Routes the pin to the line, sets the edge and enables it. The EXTI vector
+// handlers live in EXTI.c and call back per pending line.
+uint8 EXTI_Register(uint8 LineNumber, uint8 PortName, uint8 TriggerType,
+                    EXTI_Callback Callback, void* Context);
+
+void EXTI_Unregister(uint8 LineNumber);
+
+#define EXTI_DEBOUNCE_OFF       0
+#define EXTI_DEBOUNCE_TRAILING  1   // callback once the level is still active after the window
+#define EXTI_DEBOUNCE_LEADING   2   // callback on the first edge, then ignore the line for the window
+
+// The line is masked from its first edge until the window expires, so
+// bounces never reach the callback. Every line has its own window but they
+// share one timer (TIM9). Call after EXTI_Register.
+void EXTI_SetDebounce(uint8 LineNumber, uint8 Mode, uint16 WindowMs);
+
+// 0 = most urgent. Lines 5-9 and 10-15 share a vector, so their
+// priority is set per group.
+void EXTI_SetPriority(uint8 LineNumber, uint8 Priority);
+
+// Trailing-mode callbacks run from the TIM9 interrupt, not the line's own
+// vector; this sets the priority they run at
+void EXTI_SetDebouncePriority(uint8 Priority);
+
 #endif //EXTI_H
@@ -3,21 +3,51 @@
 
 #define SYSCFG_EXTI_BaseAddr 0x40013808
 
-#define NVIC_ISER_BASE_Addr 0xE000E100
-#define NVIC_ICER_BASE 0xE000E180
-
 typedef struct
 {
     volatile uint32 EXTI_CR[4];
 } SYSCFG_EXTILineConfig;
 
 
+// EXTI vectors: lines 0-4 have their own, 5-9 and 10-15 share one each
+#define EXTI0_IRQ_NUM       6
+#define EXTI9_5_IRQ_NUM     23
+#define EXTI15_10_IRQ_NUM   40
+
+#define EXTI_LINES_9_5      0x03E0UL
+#define EXTI_LINES_15_10    0xFC00UL
+
+// Debounce timebase: TIM9 free-running at 10 kHz, CC1 as a one-shot
+// alarm for the earliest pending line
+#define EXTI_DEBOUNCE_TIM_Addr  0x40014000
+#define EXTI_DEBOUNCE_TICK_HZ   10000UL
+#define EXTI_DEBOUNCE_IRQ_NUM   24          // TIM1_BRK_TIM9
+#define EXTI_DEBOUNCE_MAX_MS    3000UL      // stays well inside the 16-bit wrap
+
 typedef struct
 {
-    volatile uint32 NVIC_ISER[8];
-    volatile uint32 NVIC_ICER[8];
-} NVIC_Type;
-
+    volatile uint32 CR1;
+    volatile uint32 CR2;
+    volatile uint32 SMCR;
+    volatile uint32 DIER;
+    volatile uint32 SR;
+    volatile uint32 EGR;
+    volatile uint32 CCMR1;
+    volatile uint32 CCMR2;
+    volatile uint32 CCER;
+    volatile uint32 CNT;
+    volatile uint32 PSC;
+    volatile uint32 ARR;
+    volatile uint32 RESERVED0;
+    volatile uint32 CCR1;
+} EXTI_DebounceTimer;
+
+#define EXTI_DEBOUNCE_TIM ((EXTI_DebounceTimer*) EXTI_DEBOUNCE_TIM_Addr)
+
+#define TIM_CR1_CEN_BIT     (1UL << 0)
+#define TIM_DIER_CC1IE_BIT  (1UL << 1)
+#define TIM_SR_CC1IF_BIT    (1UL << 1)
+#define TIM_EGR_UG_BIT      (1UL << 0)
 
 #define CFG_PA 0x0
 #define CFG_PB 0x1
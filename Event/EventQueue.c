@@ -0,0 +1,70 @@
+/**
+ * EventQueue.c
+ *
+ *  Queue of timestamped events from interrupt handlers to the main loop.
+ *  Head and tail are free-running counters owned by one side each. The
+ *  producers are ISRs at different priorities (EXTI groups, ADC watchdog,
+ *  debounce timer), so a push masks interrupts for its few instructions;
+ *  the single consumer needs no masking.
+ */
+
+#include "EventQueue.h"
+
+#include "Irq.h"
+#include "Std_Types.h"
+#include "Time.h"
+
+static Event event_buffer[EVENT_QUEUE_SIZE];
+static volatile uint32 event_head = 0;   // written by producers, interrupts masked
+static volatile uint32 event_tail = 0;   // written by the consumer only
+static volatile uint32 event_dropped[EVENT_TYPE_COUNT];
+
+// Keeps the compiler from moving the slot access across the index update
+#define EVENT_BARRIER() __asm__ volatile ("" ::: "memory")
+
+uint8 EventQueue_Push(Event_Type Type, uint8 Data) {
+    // Before masking: with PRIMASK set a SysTick reload can't be counted
+    // and the timestamp would fall back by a millisecond
+    uint32 Timestamp = Time_GetUs();
+    uint32 Primask = Irq_Save();
+    uint32 Head = event_head;
+
+    if (Head - event_tail >= EVENT_QUEUE_SIZE) {
+        event_dropped[Type]++;
+        Irq_Restore(Primask);
+        return 0;
+    }
+
+    Event* Slot = &event_buffer[Head & (EVENT_QUEUE_SIZE - 1)];
+    Slot->Timestamp = Timestamp;
+    Slot->Type = (uint8)Type;
+    Slot->Data = Data;
+
+    EVENT_BARRIER();
+    event_head = Head + 1;
+    Irq_Restore(Primask);
+    return 1;
+}
+
+uint8 EventQueue_Pop(Event* Out) {
+    uint32 Tail = event_tail;
+
+    if (Tail == event_head) {
+        return 0;
+    }
+
+    EVENT_BARRIER();
+    *Out = event_buffer[Tail & (EVENT_QUEUE_SIZE - 1)];
+
+    EVENT_BARRIER();
+    event_tail = Tail + 1;
+    return 1;
+}
+
+uint8 EventQueue_IsEmpty(void) {
+    return event_tail == event_head;
+}
+
+uint32 EventQueue_GetDropped(Event_Type Type) {
+    return event_dropped[Type];
+}
@@ -0,0 +1,43 @@
+/**
+ * EventQueue.h
+ *
+ *  Queue of timestamped events from interrupt handlers (any priority) to
+ *  the main loop, which is the only consumer.
+ */
+
+#ifndef EVENTQUEUE_H
+#define EVENTQUEUE_H
+#include "Std_Types.h"
+
+#define EVENT_QUEUE_SIZE    32UL    // power of two
+
+typedef enum {
+    EVENT_OBJECT_DETECTED = 0,
+    EVENT_EMERGENCY_STOP,
+    EVENT_RESET,
+    EVENT_TYPE_COUNT
+} Event_Type;
+
+typedef struct {
+    uint32 Timestamp;   // Time_GetUs() when the event was produced
+    uint8 Type;
+    uint8 Data;
+} Event;
+
+/*
+ * Producer side, any interrupt priority or the main loop. Each push masks
+ * interrupts (PRIMASK) for a few instructions, so producers never
+ * interleave and need no common priority. When the queue is full the
+ * event is dropped and counted per type.
+ */
+uint8 EventQueue_Push(Event_Type Type, uint8 Data);
+
+// Consumer side, main loop only. Returns 0 when the queue is empty.
+uint8 EventQueue_Pop(Event* Out);
+
+uint8 EventQueue_IsEmpty(void);
+
+// Monotonic count of events of this type dropped on overflow
+uint32 EventQueue_GetDropped(Event_Type Type);
+
+#endif /* EVENTQUEUE_H */
@@ -29,14 +29,21 @@ uint8 Gpio_WritePin(uint8 PortName, uint8 PinNumber, uint8 Data) {
     uint8 port_address_index = PortName - GPIO_A;
     GPIO_Device* Device = (GPIO_Device*) address_map[port_address_index];
 
-    uint8 pinMode = (Device -> GPIO_MODER & (0x03 << (PinNumber * 2))) >> (PinNumber * 2);
-    if (pinMode == GPIO_INPUT) return NOK;
-
-    Device -> GPIO_ODR &= ~(0x01 << PinNumber);
-    Device -> GPIO_ODR |= Data << PinNumber;
+    // Single store to BSRR: no read-modify-write of ODR, so it can't
+    // clobber a pin an interrupt changed in between
+    if (Data) Device -> GPIO_BSRR = (0x01UL << PinNumber);
+    else Device -> GPIO_BSRR = (0x01UL << (PinNumber + 16));
     return OK;
 }
 
+void Gpio_WritePortMasked(uint8 PortName, uint16 Mask, uint16 Value) {
+    uint8 port_address_index = PortName - GPIO_A;
+    GPIO_Device* Device = (GPIO_Device*) address_map[port_address_index];
+
+    // Set bits in the low half, reset bits in the high half
+    Device -> GPIO_BSRR = (uint32)(Value & Mask) | ((uint32)(~Value & Mask) << 16);
+}
+
 uint8 Gpio_ReadPin(uint8 PortName, uint8 PinNumber) {
     uint8 port_address_index = PortName - GPIO_A;
     GPIO_Device* Device = (GPIO_Device*) address_map[port_address_index];
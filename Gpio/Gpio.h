@@ -37,6 +37,9 @@ void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultStat
 
 uint8 Gpio_WritePin(uint8 PortName, uint8 PinNumber, uint8 Data);
 
+// Drives every pin in Mask to its bit in Value with one atomic store
+void Gpio_WritePortMasked(uint8 PortName, uint16 Mask, uint16 Value);
+
 uint8 Gpio_ReadPin(uint8 PortName, uint8 PinNumber);
 
 #endif //GPIO_H
\ No newline at end of file
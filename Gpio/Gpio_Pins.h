@@ -0,0 +1,47 @@
+#ifndef GPIO_PINS_H
+#define GPIO_PINS_H
+
+#include "Std_Types.h"
+#include "Gpio.h"
+#include "Gpio_Private.h"
+
+/*
+ * Compile-time pin descriptors for pins fixed at build time.
+ *
+ *   PIN_DEF(LCD_E, GPIO_A, 3)
+ *   PIN_SET(LCD_E);
+ *
+ * The port letter and pin number are constants, so each access folds to a
+ * single store to (or load from) a fixed register address instead of the
+ * address_map[] lookup and shift arithmetic in Gpio_WritePin/Gpio_ReadPin.
+ * Ports A-D are 0x400 apart.
+ */
+
+#define GPIO_PORT_ADDR(PortName)  (GPIOA_BASE_ADDR + (uint32)((PortName) - GPIO_A) * 0x400UL)
+
+// Host simulations define their own before including this header, so the
+// inline writers below reach the simulated ports too
+#ifndef GPIO_PORT_DEVICE
+#define GPIO_PORT_DEVICE(PortName) ((GPIO_Device*) GPIO_PORT_ADDR(PortName))
+#endif
+
+#define PIN_DEF(Name, PortName, PinNumber) \
+    enum { Name##_PORT = (PortName), Name##_PIN = (PinNumber), Name##_MASK = (1U << (PinNumber)) };
+
+#define PIN_INIT(Name, PinMode, DefaultState) \
+    Gpio_Init(Name##_PORT, Name##_PIN, PinMode, DefaultState)
+
+#define PIN_SET(Name)   (GPIO_PORT_DEVICE(Name##_PORT) -> GPIO_BSRR = (uint32)Name##_MASK)
+#define PIN_CLEAR(Name) (GPIO_PORT_DEVICE(Name##_PORT) -> GPIO_BSRR = (uint32)Name##_MASK << 16)
+#define PIN_WRITE(Name, Data) Gpio_FastWritePin(Name##_PORT, Name##_PIN, (Data))
+#define PIN_READ(Name)  ((uint8)((GPIO_PORT_DEVICE(Name##_PORT) -> GPIO_IDR >> Name##_PIN) & 0x01UL))
+
+static inline void Gpio_FastWritePin(uint8 PortName, uint8 PinNumber, uint8 Data) {
+    GPIO_PORT_DEVICE(PortName) -> GPIO_BSRR = Data ? (0x01UL << PinNumber) : (0x01UL << (PinNumber + 16));
+}
+
+static inline void Gpio_FastWritePortMasked(uint8 PortName, uint16 Mask, uint16 Value) {
+    GPIO_PORT_DEVICE(PortName) -> GPIO_BSRR = (uint32)(Value & Mask) | ((uint32)(~Value & Mask) << 16);
+}
+
+#endif //GPIO_PINS_H
@@ -0,0 +1,78 @@
+/**
+ * Irq.h
+ *
+ *  PRIMASK critical sections. Irq_Save() masks every configurable
+ *  interrupt and returns the previous state, so sections nest.
+ *
+ *  NVIC line control for the drivers that carry their own register maps
+ *  instead of the CMSIS device header.
+ */
+
+#ifndef IRQ_H
+#define IRQ_H
+#include "Std_Types.h"
+
+#if defined(__arm__)
+static inline uint32 Irq_Save(void) {
+    uint32 Primask;
+    __asm__ volatile ("mrs %0, primask\n\tcpsid i" : "=r" (Primask) :: "memory");
+    return Primask;
+}
+
+static inline void Irq_Restore(uint32 Primask) {
+    __asm__ volatile ("msr primask, %0" :: "r" (Primask) : "memory");
+}
+#else
+// Host build: no interrupts to mask, the tests drive "ISRs" synchronously
+static inline uint32 Irq_Save(void) {
+    __asm__ volatile ("" ::: "memory");
+    return 0;
+}
+
+static inline void Irq_Restore(uint32 Primask) {
+    (void)Primask;
+    __asm__ volatile ("" ::: "memory");
+}
+#endif
+
+// Laid out from ISER so ICER and IPR land on their real offsets
+typedef struct {
+    volatile uint32 ISER[8];        // 0xE000E100, write-1-to-set
+    uint32 RESERVED0[24];
+    volatile uint32 ICER[8];        // 0xE000E180, write-1-to-clear
+    uint32 RESERVED1[24];
+    volatile uint32 ISPR[8];        // 0xE000E200
+    uint32 RESERVED2[24];
+    volatile uint32 ICPR[8];        // 0xE000E280
+    uint32 RESERVED3[24];
+    volatile uint32 IABR[8];        // 0xE000E300
+    uint32 RESERVED4[56];
+    volatile uint8 IPR[240];        // 0xE000E400, one byte per IRQ
+} Irq_NvicRegs;
+
+#if defined(__arm__)
+#define IRQ_NVIC ((Irq_NvicRegs*)0xE000E100UL)
+#else
+// Host build: a test that enables interrupts defines the register block
+extern Irq_NvicRegs irq_host_nvic;
+#define IRQ_NVIC (&irq_host_nvic)
+#endif
+
+// The F401 implements the top 4 priority bits
+#define IRQ_PRIO_BITS 4
+
+// ISER/ICER are write-1: a plain store leaves the other lines alone
+static inline void Irq_Enable(uint8 IrqNumber) {
+    IRQ_NVIC->ISER[IrqNumber >> 5] = 1UL << (IrqNumber & 0x1F);
+}
+
+static inline void Irq_Disable(uint8 IrqNumber) {
+    IRQ_NVIC->ICER[IrqNumber >> 5] = 1UL << (IrqNumber & 0x1F);
+}
+
+// 0 is the most urgent
+static inline void Irq_SetPriority(uint8 IrqNumber, uint8 Priority) {
+    IRQ_NVIC->IPR[IrqNumber] = (uint8)(Priority << (8 - IRQ_PRIO_BITS));
+}
+
+#endif /* IRQ_H */
@@ -1,54 +1,124 @@
 #include "lcd.h"
 #include "Gpio.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+#include "Rcc.h"
+#include "Time.h"
 
-// Define pins and ports
+// Define pins and ports (RS and D4-D7 must share LCD_PORT)
 #define LCD_PORT GPIO_A
-#define RS_PIN 1
-#define RW_PIN 2
-#define E_PIN  3
-#define D4_PIN 4
-#define D5_PIN 10
-#define D6_PIN 6
-#define D7_PIN 7
+PIN_DEF(LCD_RS, LCD_PORT, 1)
+PIN_DEF(LCD_RW, LCD_PORT, 2)
+PIN_DEF(LCD_E,  LCD_PORT, 3)
+PIN_DEF(LCD_D4, LCD_PORT, 4)
+PIN_DEF(LCD_D5, LCD_PORT, 10)
+PIN_DEF(LCD_D6, LCD_PORT, 6)
+PIN_DEF(LCD_D7, LCD_PORT, 7)
+#define LCD_DATA_MASK (LCD_D4_MASK | LCD_D5_MASK | LCD_D6_MASK | LCD_D7_MASK)
 
 #define HIGH 1
 #define LOW  0
 
-// Adjust this value for your clock speed
-#define NUMBER_OF_CYCLES 1000000
+// HD44780 timings
+#define LCD_NIBBLE_DELAY_US 2    // gap between the two nibbles of a byte
+#define LCD_EXEC_DELAY_US   40   // most instructions take 37us
+#define LCD_CLEAR_DELAY_US  1600 // clear/home take 1.52ms
+#define LCD_PULSE_SPIN_HZ   8000000UL  // spin iterations per second of E high, >= 450ns
 
-static void LCD_EnablePulse(void);
-static void LCD_SendNibble(uint8_t nibble);
+// Background engine: TIM11 in one-pulse mode with 1us ticks
+#define LCD_TIMER           TIM11
+#define LCD_TIMER_IRQ       TIM1_TRG_COM_TIM11_IRQn
+#define LCD_TIMER_TICK_HZ   1000000UL
 
-void delay_ms(uint32_t delay) {
-    for (volatile uint32_t i = 0; i < (NUMBER_OF_CYCLES / 1000) * delay; i++) {
-        __asm__("nop");
-    }
-}
+#define LCD_TIM_CR1_CEN     (1UL << 0)
+#define LCD_TIM_CR1_URS     (1UL << 2)
+#define LCD_TIM_CR1_OPM     (1UL << 3)
+#define LCD_TIM_DIER_UIE    (1UL << 0)
+#define LCD_TIM_SR_UIF      (1UL << 0)
+#define LCD_TIM_EGR_UG      (1UL << 0)
+
+#define LCD_CURSOR_UNKNOWN  0xFF
+#define LCD_RUN_MERGE_GAP   1    // resending one clean cell costs the same as a cursor command
+
+// Queue entry: data byte plus flags
+#define LCD_QUEUE_SIZE      64   // power of two
+#define LCD_ENTRY_RS        (1U << 8)
+#define LCD_ENTRY_SLOW      (1U << 9)
+
+static volatile uint16_t lcd_queue[LCD_QUEUE_SIZE];
+static volatile uint8_t lcd_head = 0;   // written by producers
+static volatile uint8_t lcd_tail = 0;   // written by the timer ISR
+static volatile uint8_t lcd_low_nibble = 0;
+static volatile uint8_t lcd_running = 0;
+static volatile uint32_t lcd_dropped = 0;
+
+// Shadow framebuffer: the application draws into lcd_frame, LCD_Flush()
+// sends the cells that differ from lcd_shown (what the controller holds)
+static volatile char lcd_frame[LCD_ROWS][LCD_COLS];
+static char lcd_shown[LCD_ROWS][LCD_COLS];
+static uint8_t lcd_cursor = LCD_CURSOR_UNKNOWN;
+
+// Direct writes (LCD_PrintChar) change cells behind the framebuffer's back.
+// lcd_direct is where the next one lands; the cells they hit are marked in
+// lcd_stale (bit row * LCD_COLS + col) so the next flush rewrites them.
+static uint8_t lcd_direct = LCD_CURSOR_UNKNOWN;
+static volatile uint32_t lcd_stale = 0;
+static uint32_t lcd_pulse_spin = 1;   // set from HCLK in LCD_Init
+
+// Port pattern for each nibble value, D4-D7 are not contiguous on the port
+#define LCD_NIBBLE_BITS(n) ((((n) >> 0) & 1U) << LCD_D4_PIN | (((n) >> 1) & 1U) << LCD_D5_PIN | \
+                            (((n) >> 2) & 1U) << LCD_D6_PIN | (((n) >> 3) & 1U) << LCD_D7_PIN)
+static const uint16_t lcd_nibble_bits[16] = {
+    LCD_NIBBLE_BITS(0),  LCD_NIBBLE_BITS(1),  LCD_NIBBLE_BITS(2),  LCD_NIBBLE_BITS(3),
+    LCD_NIBBLE_BITS(4),  LCD_NIBBLE_BITS(5),  LCD_NIBBLE_BITS(6),  LCD_NIBBLE_BITS(7),
+    LCD_NIBBLE_BITS(8),  LCD_NIBBLE_BITS(9),  LCD_NIBBLE_BITS(10), LCD_NIBBLE_BITS(11),
+    LCD_NIBBLE_BITS(12), LCD_NIBBLE_BITS(13), LCD_NIBBLE_BITS(14), LCD_NIBBLE_BITS(15)
+};
+
+static void LCD_EnablePulse(void);
+static void LCD_SendNibble(uint8_t rs, uint8_t nibble);
+static void LCD_Enqueue(uint16_t entry);
+static void LCD_ArmTimer(uint16_t delay_us);
+static uint8_t LCD_QueueFree(void);
+static uint8_t LCD_CursorAddress(uint8_t row, uint8_t col);
+static uint8_t LCD_CellDirty(uint8_t row, uint8_t col);
 
 void LCD_Init(void) {
     // Configure GPIO pins as output
-    Gpio_Init(LCD_PORT, RS_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, RW_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, E_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, D4_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, D5_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, D6_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-    Gpio_Init(LCD_PORT, D7_PIN, GPIO_OUTPUT, GPIO_PUSH_PULL);
-
-    Gpio_WritePin(LCD_PORT, RS_PIN, LOW);
-    Gpio_WritePin(LCD_PORT, RW_PIN, LOW);
-    Gpio_WritePin(LCD_PORT, E_PIN, LOW);
-
-    delay_ms(20); // Wait for power stabilization
-
-    // Initialize LCD in 4-bit mode
-    LCD_SendNibble(0x03);
-    delay_ms(5);
-    LCD_SendNibble(0x03);
-    delay_ms(1);
-    LCD_SendNibble(0x03);
-    LCD_SendNibble(0x02);
+    PIN_INIT(LCD_RS, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_RW, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_E, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_D4, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_D5, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_D6, GPIO_OUTPUT, GPIO_PUSH_PULL);
+    PIN_INIT(LCD_D7, GPIO_OUTPUT, GPIO_PUSH_PULL);
+
+    PIN_CLEAR(LCD_RS);
+    PIN_CLEAR(LCD_RW);
+    PIN_CLEAR(LCD_E);
+
+    lcd_pulse_spin = Rcc_GetHclkHz() / LCD_PULSE_SPIN_HZ + 1;
+
+    // Background engine timer (TIM11 is on APB2)
+    Rcc_Enable(RCC_TIM11);
+    LCD_TIMER->CR1 = LCD_TIM_CR1_OPM | LCD_TIM_CR1_URS;
+    LCD_TIMER->PSC = Rcc_GetTimerClockHz(RCC_APB2) / LCD_TIMER_TICK_HZ - 1;
+    LCD_TIMER->EGR = LCD_TIM_EGR_UG;      // load PSC, URS keeps UIF clear
+    LCD_TIMER->SR = 0;
+    LCD_TIMER->DIER = LCD_TIM_DIER_UIE;
+    NVIC_EnableIRQ(LCD_TIMER_IRQ);
+
+    Time_DelayMs(20); // Wait for power stabilization
+
+    // Initialize LCD in 4-bit mode (blocking, before the engine runs)
+    LCD_SendNibble(LOW, 0x03);
+    Time_DelayMs(5);
+    LCD_SendNibble(LOW, 0x03);
+    Time_DelayMs(1);
+    LCD_SendNibble(LOW, 0x03);
+    Time_DelayUs(LCD_EXEC_DELAY_US);
+    LCD_SendNibble(LOW, 0x02);
+    Time_DelayUs(LCD_EXEC_DELAY_US);
 
     // Send configuration commands
     LCD_SendCommand(LCD_CMD_FUNCTION_SET);
@@ -58,19 +128,31 @@ void LCD_Init(void) {
 }
 
 void LCD_SendCommand(LCD_Command cmd) {
-    Gpio_WritePin(LCD_PORT, RS_PIN, LOW);
-    Gpio_WritePin(LCD_PORT, RW_PIN, LOW);
-
-    LCD_SendNibble(cmd >> 4);
-    LCD_SendNibble(cmd);
+    uint16_t entry = (uint8_t)cmd;
+    if (cmd == LCD_CMD_CLEAR || cmd == LCD_CMD_RETURN_HOME) {
+        entry |= LCD_ENTRY_SLOW;
+    }
+    LCD_Enqueue(entry);
 }
 
 void LCD_PrintChar(char data) {
-    Gpio_WritePin(LCD_PORT, RS_PIN, HIGH);
-    Gpio_WritePin(LCD_PORT, RW_PIN, LOW);
+    uint32_t primask = Irq_Save();
+
+    uint8_t address = (lcd_cursor != LCD_CURSOR_UNKNOWN) ? lcd_cursor : lcd_direct;
+    if (address == LCD_CURSOR_UNKNOWN) {
+        lcd_stale = 0xFFFFFFFFUL;    // could be any cell
+    } else {
+        uint8_t row = (address >= 0x40) ? LCD_ROW_1 : LCD_ROW_0;
+        uint8_t col = address - ((row == LCD_ROW_1) ? 0x40 : 0);
+        if (col < LCD_COLS) {
+            lcd_stale |= 1UL << (row * LCD_COLS + col);
+        }
+        lcd_direct = address + 1;
+    }
+    lcd_cursor = LCD_CURSOR_UNKNOWN;
+    LCD_Enqueue(LCD_ENTRY_RS | (uint8_t)data);
 
-    LCD_SendNibble(data >> 4);
-    LCD_SendNibble(data);
+    Irq_Restore(primask);
 }
 
 void LCD_PrintString(const char *str) {
@@ -80,26 +162,175 @@ void LCD_PrintString(const char *str) {
 }
 
 void LCD_SetCursor(LCD_Row row, uint8_t col) {
-    uint8_t address = (row == LCD_ROW_0) ? col : (0x40 + col);
-    LCD_SendCommand(0x80 | address);
+    uint32_t primask = Irq_Save();
+    LCD_SendCommand(0x80 | LCD_CursorAddress(row, col));
+    lcd_direct = LCD_CursorAddress(row, col);
+    lcd_cursor = LCD_CURSOR_UNKNOWN;   // direct writes bypass the framebuffer
+    Irq_Restore(primask);
 }
 
 void LCD_Clear(void) {
+    for (uint8_t row = 0; row < LCD_ROWS; row++) {
+        for (uint8_t col = 0; col < LCD_COLS; col++) {
+            lcd_frame[row][col] = ' ';
+            lcd_shown[row][col] = ' ';
+        }
+    }
     LCD_SendCommand(LCD_CMD_CLEAR);
-    delay_ms(2);
+    lcd_cursor = 0;
+    lcd_direct = 0;
+    lcd_stale = 0;
+}
+
+void LCD_FbPutChar(LCD_Row row, uint8_t col, char data) {
+    if (row < LCD_ROWS && col < LCD_COLS) {
+        lcd_frame[row][col] = data;
+    }
+}
+
+void LCD_FbWrite(LCD_Row row, uint8_t col, const char *str) {
+    while (*str && col < LCD_COLS) {
+        LCD_FbPutChar(row, col++, *str++);
+    }
+}
+
+void LCD_FbFill(LCD_Row row, uint8_t col, uint8_t len, char data) {
+    while (len-- && col < LCD_COLS) {
+        LCD_FbPutChar(row, col++, data);
+    }
+}
+
+// Sends only the cells that changed since the last flush. Dirty cells
+// separated by at most LCD_RUN_MERGE_GAP clean ones are merged into one
+// run, so each run costs a single cursor command (none if the cursor is
+// already there). Returns the number of bytes queued.
+uint8_t LCD_Flush(void) {
+    uint8_t queued = 0;
+
+    for (uint8_t row = 0; row < LCD_ROWS; row++) {
+        uint8_t col = 0;
+        while (col < LCD_COLS) {
+            if (!LCD_CellDirty(row, col)) {
+                col++;
+                continue;
+            }
+
+            // Extend the run while the next dirty cell is close enough
+            uint8_t start = col;
+            uint8_t end = col;
+            for (uint8_t next = col + 1; next < LCD_COLS && next <= end + LCD_RUN_MERGE_GAP + 1; next++) {
+                if (LCD_CellDirty(row, next)) {
+                    end = next;
+                }
+            }
+
+            // A direct write from an interrupt must not land inside the run
+            uint32_t primask = Irq_Save();
+            uint8_t address = LCD_CursorAddress(row, start);
+            uint8_t cost = (end - start + 1) + (lcd_cursor != address);
+            if (cost > LCD_QueueFree()) {
+                Irq_Restore(primask);
+                return queued;   // leave the rest dirty for the next flush
+            }
+
+            if (lcd_cursor != address) {
+                LCD_SendCommand(0x80 | address);
+            }
+            for (col = start; col <= end; col++) {
+                char data = lcd_frame[row][col];
+                LCD_Enqueue(LCD_ENTRY_RS | (uint8_t)data);
+                lcd_shown[row][col] = data;
+                lcd_stale &= ~(1UL << (row * LCD_COLS + col));
+            }
+            lcd_cursor = address + (end - start + 1);
+            Irq_Restore(primask);
+            queued += cost;
+        }
+    }
+
+    return queued;
+}
+
+uint8_t LCD_IsIdle(void) {
+    return !lcd_running;
+}
+
+uint32_t LCD_GetDroppedCount(void) {
+    return lcd_dropped;
+}
+
+// Drains one nibble per tick, then re-arms itself with the time the
+// controller needs before it accepts the next one
+void TIM1_TRG_COM_TIM11_IRQHandler(void) {
+    LCD_TIMER->SR = (uint32)~LCD_TIM_SR_UIF;   // rc_w0: a plain store leaves the other flags alone
+
+    if (lcd_tail == lcd_head) {
+        lcd_running = 0;
+        return;
+    }
+
+    uint16_t entry = lcd_queue[lcd_tail];
+    uint8_t rs = (entry & LCD_ENTRY_RS) ? HIGH : LOW;
+
+    if (!lcd_low_nibble) {
+        LCD_SendNibble(rs, (uint8_t)(entry >> 4));
+        lcd_low_nibble = 1;
+        LCD_ArmTimer(LCD_NIBBLE_DELAY_US);
+    } else {
+        LCD_SendNibble(rs, (uint8_t)entry);
+        lcd_low_nibble = 0;
+        lcd_tail = (lcd_tail + 1) & (LCD_QUEUE_SIZE - 1);
+        LCD_ArmTimer((entry & LCD_ENTRY_SLOW) ? LCD_CLEAR_DELAY_US : LCD_EXEC_DELAY_US);
+    }
+}
+
+static void LCD_Enqueue(uint16_t entry) {
+    // Producers are the main loop and EXTI handlers
+    uint32_t primask = Irq_Save();
+
+    uint8_t next = (lcd_head + 1) & (LCD_QUEUE_SIZE - 1);
+    if (next == lcd_tail) {
+        lcd_dropped++;
+    } else {
+        lcd_queue[lcd_head] = entry;
+        lcd_head = next;
+        if (!lcd_running) {
+            lcd_running = 1;
+            LCD_ArmTimer(1);
+        }
+    }
+
+    Irq_Restore(primask);
+}
+
+static uint8_t LCD_QueueFree(void) {
+    return (LCD_QUEUE_SIZE - 1) - ((lcd_head - lcd_tail) & (LCD_QUEUE_SIZE - 1));
+}
+
+static uint8_t LCD_CursorAddress(uint8_t row, uint8_t col) {
+    return (row == LCD_ROW_0) ? col : (0x40 + col);
+}
+
+static uint8_t LCD_CellDirty(uint8_t row, uint8_t col) {
+    return lcd_frame[row][col] != lcd_shown[row][col] ||
+           (lcd_stale & (1UL << (row * LCD_COLS + col))) != 0;
+}
+
+static void LCD_ArmTimer(uint16_t delay_us) {
+    LCD_TIMER->ARR = delay_us;
+    LCD_TIMER->CNT = 0;
+    LCD_TIMER->CR1 |= LCD_TIM_CR1_CEN;   // OPM clears CEN at the update event
 }
 
 static void LCD_EnablePulse(void) {
-    Gpio_WritePin(LCD_PORT, E_PIN, HIGH);
-    delay_ms(1);
-    Gpio_WritePin(LCD_PORT, E_PIN, LOW);
-    delay_ms(1);
+    PIN_SET(LCD_E);
+    for (volatile uint32_t i = 0; i < lcd_pulse_spin; i++);
+    PIN_CLEAR(LCD_E);
 }
 
-static void LCD_SendNibble(uint8_t nibble) {
-    Gpio_WritePin(LCD_PORT, D4_PIN, (nibble >> 0) & 0x01);
-    Gpio_WritePin(LCD_PORT, D5_PIN, (nibble >> 1) & 0x01);
-    Gpio_WritePin(LCD_PORT, D6_PIN, (nibble >> 2) & 0x01);
-    Gpio_WritePin(LCD_PORT, D7_PIN, (nibble >> 3) & 0x01);
+// RS and D4-D7 go out in one store, E is pulsed afterwards
+static void LCD_SendNibble(uint8_t rs, uint8_t nibble) {
+    Gpio_FastWritePortMasked(LCD_PORT, LCD_DATA_MASK | LCD_RS_MASK,
+                             lcd_nibble_bits[nibble & 0x0F] | ((uint16_t)rs << LCD_RS_PIN));
     LCD_EnablePulse();
 }
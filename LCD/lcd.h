@@ -3,6 +3,9 @@
 
 #include "stm32f4xx.h"
 
+#define LCD_ROWS 2
+#define LCD_COLS 16
+
 // Enum for LCD rows
 typedef enum {
     LCD_ROW_0 = 0,
@@ -19,11 +22,22 @@ typedef enum {
 } LCD_Command;
 
 // Function prototypes
+// Everything except LCD_Init only queues bytes; a timer interrupt
+// clocks them out to the controller in the background.
 void LCD_Init(void);
 void LCD_SendCommand(LCD_Command cmd);
+// Direct writes; LCD_Flush() restores the cells they overwrite
 void LCD_PrintChar(char data);
 void LCD_PrintString(const char *str);
 void LCD_SetCursor(LCD_Row row, uint8_t col);
 void LCD_Clear(void);
+uint8_t LCD_IsIdle(void);
+
+// Shadow framebuffer, drawn freely and sent with LCD_Flush()
+void LCD_FbPutChar(LCD_Row row, uint8_t col, char data);
+void LCD_FbWrite(LCD_Row row, uint8_t col, const char *str);
+void LCD_FbFill(LCD_Row row, uint8_t col, uint8_t len, char data);
+uint8_t LCD_Flush(void);
+uint32_t LCD_GetDroppedCount(void);
 
 #endif // LCD_H
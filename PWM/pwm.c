@@ -3,29 +3,372 @@
 #include "Gpio.h"
 #include <Rcc.h>
 #include "GPIO_Private.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+#include <stdint.h>
+
+typedef struct {
+    PWM_TypeDef* Regs;
+    uint8 RccId;
+    uint8 Bus;          // RCC_APB1/RCC_APB2, for the timer clock
+    uint8 Advanced;     // TIM1: needs BDTR.MOE
+} PWM_TimerDesc;
+
+typedef struct {
+    uint8 Timer;        // PWM_TIMx
+    uint8 Channel;      // 1..4
+    uint8 Port;
+    uint8 Pin;
+    uint8 AltFunc;
+} PWM_ChannelDesc;
+
+static const PWM_TimerDesc pwm_timers[PWM_TIMER_COUNT] = {
+    [PWM_TIM1] = { TIMER1, RCC_TIM1, RCC_APB2, 1 },
+    [PWM_TIM3] = { TIMER3, RCC_TIM3, RCC_APB1, 0 },
+    [PWM_TIM4] = { TIMER4, RCC_TIM4, RCC_APB1, 0 },
+};
+
+// TIM1's outputs (PA8-PA11) are taken by the buttons and the LCD on this
+// board, so only TIM3/TIM4 channels are wired. All four TIM3 channels are
+// out: CH1/CH2 on PB4/PB5 (PB4 is NJTRST after reset, free under SWD).
+// The ramp ISR assumes the motor stays on TIM3.
+static const PWM_ChannelDesc pwm_channels[PWM_CHANNEL_COUNT] = {
+    [PWM_CH_MOTOR]    = { PWM_TIM3, 3, GPIO_B, 0, 2 },
+    [PWM_CH_DIVERTER] = { PWM_TIM3, 4, GPIO_B, 1, 2 },
+    [PWM_CH_BELT2]    = { PWM_TIM4, 3, GPIO_B, 8, 2 },
+    [PWM_CH_AUX1]     = { PWM_TIM3, 1, GPIO_B, 4, 2 },
+    [PWM_CH_AUX2]     = { PWM_TIM3, 2, GPIO_B, 5, 2 },
+};
+
+// Per timer: ticks per period and its permille scale in Q32, set by
+// PWM_ConfigureTimer() so the duty setters need no division. The scale is
+// rounded up, which keeps every permille on the nearest tick.
+static uint32 pwm_period[PWM_TIMER_COUNT];
+static uint64_t pwm_permille_q32[PWM_TIMER_COUNT];
+static uint32 pwm_frequency[PWM_TIMER_COUNT];
+static uint8 pwm_timer_used[PWM_TIMER_COUNT];
+
+// Smoothstep 3t^2 - 2t^3 sampled at 32 segments, Q16 (65535 ~ 1.0)
+static const uint16 pwm_scurve[33] = {
+    0, 188, 736, 1620, 2816, 4300, 6048, 8036, 10240, 12636, 15200,
+    17908, 20736, 23660, 26656, 29700, 32768, 35835, 38879, 41875, 44799,
+    47627, 50335, 52899, 55295, 57499, 59487, 61235, 62719, 63915, 64799,
+    65347, 65535
+};
+
+static uint32 pwm_ramp_full_ms = 0;
+static uint8 pwm_ramp_profile = PWM_RAMP_LINEAR;
+
+// Ramp in progress: CCR = start + delta * profile(pos), pos Q24 in 0..1 so
+// the rounded-up increment keeps long ramps within a step of their length
+#define PWM_RAMP_ONE (1UL << 24)
+static volatile uint8 pwm_ramping = 0;
+static int32_t pwm_ramp_start;
+static int32_t pwm_ramp_delta;
+static uint32 pwm_ramp_target;
+static uint32 pwm_ramp_pos;
+static uint32 pwm_ramp_inc;
+
+// Set by PWM_Stop(): every channel stays at 0 until PWM_Release()
+static volatile uint8 pwm_stopped = 0;
+
+static volatile uint32* PWM_Ccr(uint8 Channel) {
+    const PWM_ChannelDesc* ch = &pwm_channels[Channel];
+    return &pwm_timers[ch->Timer].Regs->CCR1 + (ch->Channel - 1);
+}
+
+// Masked so a stop from a higher-priority interrupt can't interleave with
+// the DIER read-modify-write
+static void PWM_CancelRamp(void) {
+    uint32 Primask = Irq_Save();
+    TIMER3->DIER &= ~TIM_DIER_UIE;
+    pwm_ramping = 0;
+    Irq_Restore(Primask);
+}
+
+static void PWM_InitChannel(const PWM_ChannelDesc* ch) {
+    PWM_TypeDef* tim = pwm_timers[ch->Timer].Regs;
+
+    Gpio_Init(ch->Port, ch->Pin, GPIO_AF, GPIO_PUSH_PULL);
+    GPIO_Device* gpio = GPIO_PORT_DEVICE(ch->Port);
+    if (ch->Pin < 8) {
+        gpio->GPIO_AFRL &= ~(0xFUL << (ch->Pin * 4));
+        gpio->GPIO_AFRL |= ((uint32)ch->AltFunc << (ch->Pin * 4));
+    } else {
+        gpio->GPIO_AFRH &= ~(0xFUL << ((ch->Pin - 8) * 4));
+        gpio->GPIO_AFRH |= ((uint32)ch->AltFunc << ((ch->Pin - 8) * 4));
+    }
+
+    // PWM mode 1 with CCR preload
+    volatile uint32* ccmr = (ch->Channel <= 2) ? &tim->CCMR1 : &tim->CCMR2;
+    *ccmr = (*ccmr & ~TIM_CCMR_OC_MASK(ch->Channel)) |
+            TIM_CCMR_OCM_PWM1(ch->Channel) | TIM_CCMR_OCPE(ch->Channel);
+    *(&tim->CCR1 + (ch->Channel - 1)) = 0;   // Initial duty cycle 0%
+    tim->CCER |= TIM_CCER_CCE(ch->Channel);
+}
 
 void PWM_Init(void) {
-    // Enable clock for TIM3
-    Rcc_Enable(RCC_TIM3);
-    Rcc_Enable(RCC_GPIOB);
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        pwm_timer_used[pwm_channels[i].Timer] = 1;
+    }
+
+    for (uint8 t = 0; t < PWM_TIMER_COUNT; t++) {
+        if (!pwm_timer_used[t]) {
+            continue;
+        }
+        Rcc_Enable(pwm_timers[t].RccId);
+        // ARR preloaded: a new period only latches at an update event
+        pwm_timers[t].Regs->CR1 = TIM_CR1_ARPE;
+        pwm_period[t] = PWM_MAX_PERIOD;
+    }
+
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        Rcc_Enable(RCC_GPIOA + (pwm_channels[i].Port - GPIO_A));
+        PWM_InitChannel(&pwm_channels[i]);
+    }
+
+    for (uint8 t = 0; t < PWM_TIMER_COUNT; t++) {
+        if (!pwm_timer_used[t]) {
+            continue;
+        }
+        PWM_TypeDef* tim = pwm_timers[t].Regs;
+        PWM_ConfigureTimer(t, PWM_DEFAULT_FREQ_HZ, PWM_DEFAULT_MIN_STEPS);
+        tim->EGR = TIM_EGR_UG;      // Load the preload registers before starting
+        tim->SR = ~TIM_SR_UIF;
+        if (pwm_timers[t].Advanced) {
+            tim->BDTR |= TIM_BDTR_MOE;
+        }
+        tim->CR1 |= TIM_CR1_CEN;    // Enable timer
+    }
+
+    Irq_Enable(PWM_IRQ_NUM);
+}
+
+uint8 PWM_ConfigureTimer(uint8 Timer, uint32 FreqHz, uint32 MinSteps) {
+    if (Timer >= PWM_TIMER_COUNT || !pwm_timer_used[Timer] || FreqHz == 0) {
+        return PWM_NOK;
+    }
+
+    uint32 clock = Rcc_GetTimerClockHz(pwm_timers[Timer].Bus);
+    uint32 total = clock / FreqHz;
+    uint32 prescaler = (total + PWM_MAX_PERIOD - 1) / PWM_MAX_PERIOD;
+    if (prescaler == 0) {
+        prescaler = 1;
+    }
+    uint32 period = (clock + (prescaler * FreqHz) / 2) / (prescaler * FreqHz);
+    if (period > PWM_MAX_PERIOD) {
+        period = PWM_MAX_PERIOD;
+    }
+    if (period < 2 || period < MinSteps || prescaler > PWM_MAX_PERIOD) {
+        return PWM_NOK;
+    }
+
+    if (Timer == pwm_channels[PWM_CH_MOTOR].Timer) {
+        PWM_CancelRamp();
+    }
+
+    // UDIS keeps an update event from latching half of the new setting.
+    // Masked so a stop can't land between a CCR read and its rescaled
+    // write, and a batch already holding UDIS stays open.
+    PWM_TypeDef* tim = pwm_timers[Timer].Regs;
+    uint32 Primask = Irq_Save();
+    uint32 held = tim->CR1 & TIM_CR1_UDIS;
+    tim->CR1 |= TIM_CR1_UDIS;
+    tim->PSC = prescaler - 1;
+    tim->ARR = period - 1;
+
+    // Same duty fraction at the new period
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        if (pwm_channels[i].Timer != Timer) {
+            continue;
+        }
+        volatile uint32* ccr = PWM_Ccr(i);
+        uint32 compare = (uint32)(((uint64_t)*ccr * period + pwm_period[Timer] / 2) / pwm_period[Timer]);
+        *ccr = compare > period ? period : compare;
+    }
+    if (!held) {
+        tim->CR1 &= ~TIM_CR1_UDIS;
+    }
+
+    pwm_period[Timer] = period;
+    pwm_permille_q32[Timer] = (((uint64_t)period << 32) + 999) / 1000;
+    pwm_frequency[Timer] = clock / (prescaler * period);
+    Irq_Restore(Primask);
+    return PWM_OK;
+}
+
+// The direct setters win over a running ramp. After PWM_Stop() every
+// channel ignores them, so a write already under way when the stop lands
+// can't restart an output.
+void PWM_SetChannelRaw(uint8 Channel, uint32 compare) {
+    uint32 period = pwm_period[pwm_channels[Channel].Timer];
+    uint32 Primask = Irq_Save();
+    if (Channel == PWM_CH_MOTOR) {
+        PWM_CancelRamp();
+    }
+    if (!pwm_stopped) {
+        *PWM_Ccr(Channel) = compare > period ? period : compare;
+    }
+    Irq_Restore(Primask);
+}
+
+void PWM_SetChannelPermille(uint8 Channel, uint16 permille) {
+    if (permille > 1000) permille = 1000;
+    uint64_t scale = pwm_permille_q32[pwm_channels[Channel].Timer];
+    PWM_SetChannelRaw(Channel, (uint32)((permille * scale + 0x80000000ULL) >> 32));
+}
+
+uint32 PWM_GetChannelPeriodTicks(uint8 Channel) {
+    return pwm_period[pwm_channels[Channel].Timer];
+}
 
-    // Initialize PB0 as alternate function
-    Gpio_Init(GPIO_B, 0, GPIO_AF, GPIO_PUSH_PULL);
+uint32 PWM_GetChannelRaw(uint8 Channel) {
+    return *PWM_Ccr(Channel);
+}
 
-    GPIO_Device* gpioB = (GPIO_Device*)GPIOB_BASE_ADDR;
-    gpioB->GPIO_AFRL &= ~(0xF << (0 * 4));  // Clear bits for PB0
-    gpioB->GPIO_AFRL |=  (0x2 << (0 * 4));  // Set AF2 for TIM3_CH3
+// OCxPE already holds each CCR until the next update event; UDIS holds
+// that event off until every channel has been written. Masked, since
+// PWM_Stop() flips UDIS from interrupt context.
+void PWM_BeginUpdate(void) {
+    uint32 Primask = Irq_Save();
+    for (uint8 t = 0; t < PWM_TIMER_COUNT; t++) {
+        if (pwm_timer_used[t]) {
+            pwm_timers[t].Regs->CR1 |= TIM_CR1_UDIS;
+        }
+    }
+    Irq_Restore(Primask);
+}
 
-    TIMER3->PSC = 16 - 1;   // prescaler
-    TIMER3->ARR = 1000 - 1; // auto-reload
+void PWM_EndUpdate(void) {
+    uint32 Primask = Irq_Save();
+    for (uint8 t = 0; t < PWM_TIMER_COUNT; t++) {
+        if (pwm_timer_used[t]) {
+            pwm_timers[t].Regs->CR1 &= ~TIM_CR1_UDIS;
+        }
+    }
+    Irq_Restore(Primask);
+}
 
-    TIMER3->CCR3 = 0;         // Initial duty cycle 0% for CH3
-    TIMER3->CCMR2 |= TIM_CCMR2_OC3M_1 | TIM_CCMR2_OC3M_2; // PWM mode 1 for CH3
-    TIMER3->CCER |= TIM_CCER_CC3E;  // Enable channel 3 output
-    TIMER3->CR1 |= TIM_CR1_CEN;     // Enable timer
+uint8 PWM_Configure(uint32 FreqHz, uint32 MinSteps) {
+    return PWM_ConfigureTimer(pwm_channels[PWM_CH_MOTOR].Timer, FreqHz, MinSteps);
 }
 
 void PWM_SetDutyCycle(uint8 duty) {
     if (duty > 100) duty = 100;
-    TIMER3->CCR3 = (TIMER3->ARR + 1) * duty / 100; // Use CCR3 for channel 3
-}
\ No newline at end of file
+    PWM_SetChannelPermille(PWM_CH_MOTOR, (uint16)(duty * 10));
+}
+
+void PWM_SetDutyPermille(uint16 permille) {
+    PWM_SetChannelPermille(PWM_CH_MOTOR, permille);
+}
+
+void PWM_SetRaw(uint32 compare) {
+    PWM_SetChannelRaw(PWM_CH_MOTOR, compare);
+}
+
+uint32 PWM_GetRaw(void) {
+    return PWM_GetChannelRaw(PWM_CH_MOTOR);
+}
+
+uint32 PWM_GetPeriodTicks(void) {
+    return PWM_GetChannelPeriodTicks(PWM_CH_MOTOR);
+}
+
+uint32 PWM_GetFrequency(void) {
+    return pwm_frequency[pwm_channels[PWM_CH_MOTOR].Timer];
+}
+
+// Its own batch, so all outputs drop at the same update event. The closing
+// EndUpdate also ends a batch the stop interrupted: the zeros must latch
+// even if that batch is never finished.
+void PWM_Stop(void) {
+    uint32 Primask = Irq_Save();
+    pwm_stopped = 1;
+    PWM_CancelRamp();
+    PWM_BeginUpdate();
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        *PWM_Ccr(i) = 0;
+    }
+    PWM_EndUpdate();
+    Irq_Restore(Primask);
+}
+
+void PWM_Release(void) {
+    pwm_stopped = 0;
+}
+
+void PWM_ConfigureRamp(uint32 FullScaleMs, uint8 Profile) {
+    pwm_ramp_full_ms = FullScaleMs;
+    pwm_ramp_profile = Profile;
+}
+
+// Starts from wherever CCR is now, including part way through a ramp
+void PWM_RampTo(uint32 compare) {
+    uint32 period = PWM_GetPeriodTicks();
+    volatile uint32* ccr = PWM_Ccr(PWM_CH_MOTOR);
+    if (compare > period) compare = period;
+
+    // Update events this move takes at the configured full-scale rate. The
+    // division stays outside the masked section; a step the ISR takes in
+    // between only shortens the move slightly.
+    uint32 snapshot = *ccr;
+    uint32 distance = compare > snapshot ? compare - snapshot : snapshot - compare;
+    uint32 steps = (uint32)(((uint64_t)pwm_ramp_full_ms * PWM_GetFrequency() * distance) /
+                            (1000ULL * period));
+
+    // Atomic against TIM3_IRQHandler and against a stop from any interrupt
+    uint32 Primask = Irq_Save();
+    PWM_CancelRamp();
+    if (pwm_stopped) {
+        Irq_Restore(Primask);
+        return;
+    }
+    if (steps <= 1) {
+        *ccr = compare;
+        Irq_Restore(Primask);
+        return;
+    }
+
+    uint32 current = *ccr;
+    pwm_ramp_start = (int32_t)current;
+    pwm_ramp_delta = (int32_t)compare - (int32_t)current;
+    pwm_ramp_target = compare;
+    pwm_ramp_pos = 0;
+    pwm_ramp_inc = (PWM_RAMP_ONE + steps - 1) / steps;
+    pwm_ramping = 1;
+
+    TIMER3->SR = (uint32)~TIM_SR_UIF;
+    TIMER3->DIER |= TIM_DIER_UIE;
+    Irq_Restore(Primask);
+}
+
+uint8 PWM_IsRamping(void) {
+    return pwm_ramping;
+}
+
+void TIM3_IRQHandler(void) {
+    uint32 sr = TIMER3->SR;
+    TIMER3->SR = ~TIM_SR_UIF;   // rc_w0: a plain store leaves the other flags alone
+
+    // An update that was already pending when a stop cancelled the ramp
+    // must not write CCR3 again
+    if (!pwm_ramping || !(sr & TIM_SR_UIF)) {
+        return;
+    }
+
+    volatile uint32* ccr = PWM_Ccr(PWM_CH_MOTOR);
+    pwm_ramp_pos += pwm_ramp_inc;
+    if (pwm_ramp_pos >= PWM_RAMP_ONE) {
+        *ccr = pwm_ramp_target;
+        PWM_CancelRamp();
+        return;
+    }
+
+    uint32 shape = pwm_ramp_pos >> 8;   // linear, Q16
+    if (pwm_ramp_profile == PWM_RAMP_SCURVE) {
+        uint32 seg = pwm_ramp_pos >> 19;
+        uint32 frac = (pwm_ramp_pos >> 8) & 0x7FF;
+        shape = pwm_scurve[seg] + (((pwm_scurve[seg + 1] - pwm_scurve[seg]) * frac) >> 11);
+    }
+    *ccr = (uint32)(pwm_ramp_start + (int32_t)(((int64_t)pwm_ramp_delta * shape) >> 16));
+}
@@ -3,6 +3,8 @@
 
 #include "Std_Types.h"
 #define TIMER3_BASE  0x40000400U
+#define TIMER4_BASE  0x40000800U
+#define TIMER1_BASE  0x40010000U
 
 typedef struct {
     volatile uint32 CR1;
@@ -29,17 +31,90 @@ typedef struct {
 } PWM_TypeDef;
 
 #define TIMER3 ((PWM_TypeDef *)TIMER3_BASE)
+#define TIMER4 ((PWM_TypeDef *)TIMER4_BASE)
+#define TIMER1 ((PWM_TypeDef *)TIMER1_BASE)
 
+// Output compare mode fields: channels 1/3 at bit 0, channels 2/4 at bit 8
+// of CCMR1/CCMR2
+#define TIM_CCMR_OCPE(ch)   (1UL << (3 + (((ch) - 1) & 1) * 8))
+#define TIM_CCMR_OCM_PWM1(ch) (6UL << (4 + (((ch) - 1) & 1) * 8))
+#define TIM_CCMR_OC_MASK(ch)  (0xFFUL << ((((ch) - 1) & 1) * 8))
+#define TIM_CCER_CCE(ch)    (1UL << (((ch) - 1) * 4))
 
-#define TIM_CCMR2_OC3M_Pos 4
-#define TIM_CCMR2_OC3M_1 (1 << (TIM_CCMR2_OC3M_Pos + 1))
-#define TIM_CCMR2_OC3M_2 (1 << (TIM_CCMR2_OC3M_Pos + 2))
+#define TIM_CR1_CEN (1 << 0)
+#define TIM_CR1_UDIS (1 << 1)
+#define TIM_CR1_ARPE (1 << 7)
 
-#define TIM_CCER_CC3E (1 << 8)
+#define TIM_EGR_UG (1 << 0)
+#define TIM_DIER_UIE (1 << 0)
+#define TIM_SR_UIF (1 << 0)
+#define TIM_BDTR_MOE (1UL << 15)    // TIM1 outputs stay off without it
 
-#define TIM_CR1_CEN (1 << 0)
+#define PWM_IRQ_NUM 29     // TIM3 global interrupt, steps the motor ramp
+
+#define PWM_RAMP_LINEAR 0
+#define PWM_RAMP_SCURVE 1
+
+#define PWM_OK  0x0
+#define PWM_NOK 0x1
+
+// Timers a channel can live on
+#define PWM_TIM1 0
+#define PWM_TIM3 1
+#define PWM_TIM4 2
+#define PWM_TIMER_COUNT 3
+
+// Outputs, indexes into the channel table in pwm.c
+#define PWM_CH_MOTOR    0   // TIM3_CH3, PB0
+#define PWM_CH_DIVERTER 1   // TIM3_CH4, PB1
+#define PWM_CH_BELT2    2   // TIM4_CH3, PB8
+#define PWM_CH_AUX1     3   // TIM3_CH1, PB4
+#define PWM_CH_AUX2     4   // TIM3_CH2, PB5
+#define PWM_CHANNEL_COUNT 5
+
+#define PWM_MAX_PERIOD     65536UL      // 16-bit timers
+
+// Above the audible range; 4200 steps at 84 MHz
+#define PWM_DEFAULT_FREQ_HZ   20000UL
+#define PWM_DEFAULT_MIN_STEPS 500UL
 
 void PWM_Init(void);
-void PWM_SetDutyCycle(uint8 duty);
+// Picks the smallest prescaler for FreqHz, i.e. the most steps per period;
+// fails if that is fewer than MinSteps. Takes effect at the next update
+// event (inside a batch, the first one after PWM_EndUpdate()), keeping
+// each channel's duty. Channels on one timer share it.
+uint8 PWM_ConfigureTimer(uint8 Timer, uint32 FreqHz, uint32 MinSteps);
+void PWM_SetChannelRaw(uint8 Channel, uint32 compare);
+void PWM_SetChannelPermille(uint8 Channel, uint16 permille);
+uint32 PWM_GetChannelPeriodTicks(uint8 Channel);
+uint32 PWM_GetChannelRaw(uint8 Channel);  // preloaded CCR, including a ramp in progress
+
+// Channel writes between these latch together at each timer's next update
+// event instead of one by one
+void PWM_BeginUpdate(void);
+void PWM_EndUpdate(void);
+
+// Stop path, callable from any interrupt: cancels the ramp, zeroes every
+// channel in one batch and makes all of them ignore writes and ramps until
+// PWM_Release(). Leaves UDIS clear even if it lands inside an open batch.
+void PWM_Stop(void);
+void PWM_Release(void);
+
+// Motor channel shorthands
+uint8 PWM_Configure(uint32 FreqHz, uint32 MinSteps);
+void PWM_SetDutyCycle(uint8 duty);       // percent, kept for existing callers
+void PWM_SetDutyPermille(uint16 permille);
+void PWM_SetRaw(uint32 compare);         // CCR in timer ticks, 0..PWM_GetPeriodTicks()
+uint32 PWM_GetRaw(void);
+uint32 PWM_GetPeriodTicks(void);
+uint32 PWM_GetFrequency(void);
+
+
+// Ramps step the motor channel once per PWM period from the TIM3 update
+// interrupt, which is only enabled while a ramp is running. FullScaleMs is
+// the time for a 0..100% move (0 = no ramp); smaller moves take less.
+void PWM_ConfigureRamp(uint32 FullScaleMs, uint8 Profile);
+void PWM_RampTo(uint32 compare);
+uint8 PWM_IsRamping(void);
 
 #endif
@@ -0,0 +1,74 @@
+#include "Pid.h"
+
+static int64_t Pid_Clamp(int64_t value, int64_t low, int64_t high) {
+    if (value < low) {
+        return low;
+    }
+    if (value > high) {
+        return high;
+    }
+    return value;
+}
+
+void Pid_Init(Pid_t *pid, const Pid_Config_t *config) {
+    pid->config = *config;
+    Pid_Reset(pid, config->out_min);
+}
+
+void Pid_Reset(Pid_t *pid, int32_t output) {
+    output = (int32_t)Pid_Clamp(output, pid->config.out_min, pid->config.out_max);
+    pid->output = output;
+    pid->integral_q16 = (int64_t)output << PID_Q;
+    pid->prev_measurement = 0;
+    pid->primed = false;
+}
+
+int32_t Pid_Update(Pid_t *pid, int32_t setpoint, int32_t measurement) {
+    const Pid_Config_t *cfg = &pid->config;
+    int64_t low_q16 = (int64_t)cfg->out_min << PID_Q;
+    int64_t high_q16 = (int64_t)cfg->out_max << PID_Q;
+
+    int32_t error = setpoint - measurement;
+    int64_t p_q16 = (int64_t)cfg->kp_q16 * error;
+
+    int64_t d_q16 = 0;
+    if (pid->primed) {
+        d_q16 = -(int64_t)cfg->kd_q16 * (measurement - pid->prev_measurement);
+    }
+    pid->prev_measurement = measurement;
+    pid->primed = true;
+
+    // This tick's reachable output: the range, narrowed by the slew limit
+    int64_t reach_low = cfg->out_min;
+    int64_t reach_high = cfg->out_max;
+    if (cfg->slew_max > 0) {
+        reach_low = Pid_Clamp((int64_t)pid->output - cfg->slew_max, cfg->out_min, cfg->out_max);
+        reach_high = Pid_Clamp((int64_t)pid->output + cfg->slew_max, cfg->out_min, cfg->out_max);
+    }
+
+    // Anti-windup: integrate up to the point where the output reaches this
+    // tick's range or slew limit, not past it (but never back out of a
+    // limit the integral is already beyond), and never past the output
+    // range
+    int64_t integral_q16 = pid->integral_q16 + (int64_t)cfg->ki_q16 * error;
+    int64_t sum_q16 = p_q16 + integral_q16 + d_q16;
+    if (error > 0 && sum_q16 > (reach_high << PID_Q)) {
+        int64_t limit_q16 = (reach_high << PID_Q) - p_q16 - d_q16;
+        integral_q16 = limit_q16 > pid->integral_q16 ? limit_q16 : pid->integral_q16;
+    } else if (error < 0 && sum_q16 < (reach_low << PID_Q)) {
+        int64_t limit_q16 = (reach_low << PID_Q) - p_q16 - d_q16;
+        integral_q16 = limit_q16 < pid->integral_q16 ? limit_q16 : pid->integral_q16;
+    }
+    pid->integral_q16 = Pid_Clamp(integral_q16, low_q16, high_q16);
+    sum_q16 = p_q16 + pid->integral_q16 + d_q16;
+
+    int64_t output = (sum_q16 + (1 << (PID_Q - 1))) >> PID_Q;
+    output = Pid_Clamp(output, reach_low, reach_high);
+
+    pid->output = (int32_t)output;
+    return pid->output;
+}
+
+int32_t Pid_GetOutput(const Pid_t *pid) {
+    return pid->output;
+}
@@ -0,0 +1,36 @@
+#ifndef PID_H
+#define PID_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Fixed-point PID for a fixed-rate control task. Gains are Q16 and per tick
+// (ki and kd already include the sample period), so Pid_Update() is only
+// integer multiplies and shifts. The derivative acts on the measurement to
+// avoid a kick on setpoint steps; kd = 0 gives a PI controller.
+
+#define PID_Q 16
+
+typedef struct {
+    int32_t kp_q16;         // output units per error unit
+    int32_t ki_q16;         // output units per error unit per tick
+    int32_t kd_q16;         // output units per (measurement change per tick)
+    int32_t out_min;
+    int32_t out_max;
+    int32_t slew_max;       // largest output change per tick, 0 = unlimited
+} Pid_Config_t;
+
+typedef struct {
+    Pid_Config_t config;
+    int64_t integral_q16;   // ki already applied, so gain changes are bumpless
+    int32_t prev_measurement;
+    int32_t output;
+    bool primed;            // prev_measurement is valid
+} Pid_t;
+
+void Pid_Init(Pid_t *pid, const Pid_Config_t *config);
+void Pid_Reset(Pid_t *pid, int32_t output);   // restart holding `output`
+int32_t Pid_Update(Pid_t *pid, int32_t setpoint, int32_t measurement);
+int32_t Pid_GetOutput(const Pid_t *pid);
+
+#endif // PID_H
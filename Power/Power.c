@@ -0,0 +1,42 @@
+/**
+ * Power.c
+ *
+ *  Idle policy: WFI in Sleep mode while there is nothing to do.
+ */
+
+#include "Power.h"
+
+#include "Bit_Operations.h"
+#include "Irq.h"
+#include "Power_Private.h"
+#include "Std_Types.h"
+
+#if defined(__arm__)
+// A pending interrupt ends WFI even while PRIMASK holds it off
+static inline void Power_WaitForInterrupt(void) {
+    __asm__ volatile ("dsb\n\twfi\n\tisb" ::: "memory");
+}
+#else
+// Host build: no core to stop; a test overrides the hook to advance its
+// simulated clock to the next interrupt
+__attribute__((weak)) void Power_HostWaitForInterrupt(void) { }
+
+static inline void Power_WaitForInterrupt(void) {
+    Power_HostWaitForInterrupt();
+}
+#endif
+
+void Power_Init(void) {
+#if defined(__arm__)
+    CLEAR_BIT(SCB_SCR, SCB_SCR_SLEEPDEEP);
+    CLEAR_BIT(SCB_SCR, SCB_SCR_SLEEPONEXIT);   // handlers return to the scheduler
+#endif
+}
+
+void Power_Idle(Power_PendingFn Pending) {
+    uint32 Primask = Irq_Save();
+    if (Pending == 0 || !Pending()) {
+        Power_WaitForInterrupt();
+    }
+    Irq_Restore(Primask);
+}
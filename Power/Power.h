@@ -0,0 +1,31 @@
+/**
+ * Power.h
+ *
+ *  Idle policy: WFI in Sleep mode while there is nothing to do.
+ */
+
+#ifndef POWER_H
+#define POWER_H
+#include "Std_Types.h"
+
+// Returns non-zero while there is work the main loop has not consumed yet
+typedef uint8 (*Power_PendingFn)(void);
+
+// Selects plain Sleep (not Stop), so SysTick, EXTI, timers, ADC and DMA
+// keep running and any of their interrupts wakes the core
+void Power_Init(void);
+
+/*
+ * Sleeps until the next interrupt unless Pending reports work. Pending is
+ * evaluated with interrupts masked, so an interrupt that queues work after
+ * the check still wakes the core instead of being slept through; its
+ * handler runs once this returns.
+ */
+void Power_Idle(Power_PendingFn Pending);
+
+#if !defined(__arm__)
+// Host build only: stands in for WFI, weak no-op unless a test defines it
+void Power_HostWaitForInterrupt(void);
+#endif
+
+#endif /* POWER_H */
@@ -0,0 +1,19 @@
+/**
+ * Power_Private.h
+ *
+ *  Cortex-M4 System Control Register used to select the sleep mode.
+ */
+
+#ifndef POWER_PRIVATE_H
+#define POWER_PRIVATE_H
+#include "Std_Types.h"
+#include "Utils.h"
+
+#define SCB_SCR             REG32(0xE000ED10UL)
+
+// SCB_SCR bits
+#define SCB_SCR_SLEEPONEXIT 1
+#define SCB_SCR_SLEEPDEEP   2
+#define SCB_SCR_SEVONPEND   4
+
+#endif /* POWER_PRIVATE_H */
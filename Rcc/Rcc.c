@@ -11,9 +11,141 @@
 #include "Rcc_Private.h"
 #include "Std_Types.h"
 
+static uint32 rcc_sysclk_hz = RCC_HSI_HZ;
+static uint32 rcc_pclk1_hz = RCC_HSI_HZ;
+static uint32 rcc_pclk2_hz = RCC_HSI_HZ;
+static uint8 rcc_apb1_divided = 0;
+static uint8 rcc_apb2_divided = 0;
+
+static uint8 Rcc_WaitFlag(volatile uint32* Reg, uint8 Bit) {
+    for (uint32 i = 0; i < RCC_READY_TIMEOUT; i++) {
+        if (READ_BIT(*Reg, Bit)) {
+            return RCC_OK;
+        }
+    }
+    return RCC_NOK;
+}
+
 void Rcc_Init(void) {
-    SET_BIT(RCC_CR, 0);
-    //	 RCC_CFGR |= (0x0A << 4); // 8MHz internal
+    SET_BIT(RCC_CR, RCC_CR_HSION);
+    Rcc_WaitFlag(&RCC_CR, RCC_CR_HSIRDY);
+
+    Rcc_ClockConfig Config = {
+        .Source = RCC_CLOCK_HSI,
+        .SourceHz = RCC_HSI_HZ,
+        .SysclkHz = RCC_DEFAULT_SYSCLK_HZ,
+    };
+    Rcc_ConfigureClocks(&Config);
+}
+
+uint8 Rcc_ConfigureClocks(const Rcc_ClockConfig* Config) {
+    uint32 SourceHz = (Config->Source == RCC_CLOCK_HSE) ? Config->SourceHz : RCC_HSI_HZ;
+    uint32 SysclkHz = Config->SysclkHz;
+    if (SysclkHz == 0 || SysclkHz > RCC_MAX_SYSCLK_HZ || SourceHz < 2000000UL) {
+        return RCC_NOK;
+    }
+
+    // PLL input 2 MHz when the source allows it (less jitter), else 1 MHz
+    uint32 InputHz = (SourceHz % 2000000UL == 0) ? 2000000UL : 1000000UL;
+    if (SourceHz % InputHz != 0) {
+        return RCC_NOK;
+    }
+    uint32 M = SourceHz / InputHz;
+
+    // Lowest P whose VCO lands in range on a whole N
+    uint32 P = 0;
+    uint32 N = 0;
+    for (uint32 Div = 2; Div <= 8; Div += 2) {
+        uint32 VcoHz = SysclkHz * Div;
+        if (VcoHz >= RCC_VCO_MIN_HZ && VcoHz <= RCC_VCO_MAX_HZ && VcoHz % InputHz == 0) {
+            P = Div;
+            N = VcoHz / InputHz;
+            break;
+        }
+    }
+    if (P == 0 || M < 2 || M > 63 || N < 50 || N > 432) {
+        return RCC_NOK;
+    }
+    uint32 Q = (SysclkHz * P + RCC_USB_HZ - 1) / RCC_USB_HZ;   // USB/SDIO <= 48 MHz
+    if (Q < 2) Q = 2;
+    if (Q > 15) Q = 15;
+
+    if (Config->Source == RCC_CLOCK_HSE) {
+        SET_BIT(RCC_CR, RCC_CR_HSEON);
+        if (Rcc_WaitFlag(&RCC_CR, RCC_CR_HSERDY) != RCC_OK) {
+            CLEAR_BIT(RCC_CR, RCC_CR_HSEON);
+            return RCC_NOK;
+        }
+    }
+
+    // Run from HSI while the PLL is reprogrammed
+    RCC_CFGR &= ~RCC_CFGR_SW_MSK;
+    while ((RCC_CFGR & RCC_CFGR_SWS_MSK) != 0);
+    CLEAR_BIT(RCC_CR, RCC_CR_PLLON);
+    while (READ_BIT(RCC_CR, RCC_CR_PLLRDY));
+
+    RCC_PLLCFGR = (M << RCC_PLLCFGR_M_POS) | (N << RCC_PLLCFGR_N_POS) |
+                  (((P / 2) - 1) << RCC_PLLCFGR_P_POS) | (Q << RCC_PLLCFGR_Q_POS) |
+                  ((uint32)(Config->Source == RCC_CLOCK_HSE) << RCC_PLLCFGR_SRC);
+    SET_BIT(RCC_CR, RCC_CR_PLLON);
+    if (Rcc_WaitFlag(&RCC_CR, RCC_CR_PLLRDY) != RCC_OK) {
+        CLEAR_BIT(RCC_CR, RCC_CR_PLLON);
+        if (Config->Source == RCC_CLOCK_HSE) {
+            CLEAR_BIT(RCC_CR, RCC_CR_HSEON);   // nothing runs from it any more
+        }
+        rcc_sysclk_hz = RCC_HSI_HZ;
+        rcc_pclk1_hz = rcc_apb1_divided ? RCC_HSI_HZ / 2 : RCC_HSI_HZ;
+        rcc_pclk2_hz = RCC_HSI_HZ;
+        return RCC_NOK;
+    }
+
+    // Wait states must be in place before the clock goes up; read back to
+    // make sure the new latency is active
+    uint32 Latency = (SysclkHz - 1) / RCC_FLASH_WS_STEP_HZ;
+    FLASH_ACR = (FLASH_ACR & ~FLASH_ACR_LATENCY_MSK) | Latency |
+                (1UL << FLASH_ACR_PRFTEN) | (1UL << FLASH_ACR_ICEN) | (1UL << FLASH_ACR_DCEN);
+    while ((FLASH_ACR & FLASH_ACR_LATENCY_MSK) != Latency);
+
+    // AHB /1; APB1 is limited to 42 MHz, APB2 runs at SYSCLK
+    uint8 Apb1Divided = SysclkHz > RCC_MAX_PCLK1_HZ;
+    uint32 Cfgr = RCC_CFGR & ~(RCC_CFGR_HPRE_MSK | (RCC_CFGR_PPRE_MSK << RCC_CFGR_PPRE1_POS) |
+                               (RCC_CFGR_PPRE_MSK << RCC_CFGR_PPRE2_POS));
+    Cfgr |= (Apb1Divided ? RCC_CFGR_PPRE_DIV2 : RCC_CFGR_PPRE_DIV1) << RCC_CFGR_PPRE1_POS;
+    Cfgr |= RCC_CFGR_PPRE_DIV1 << RCC_CFGR_PPRE2_POS;
+    RCC_CFGR = Cfgr;
+
+    RCC_CFGR = (RCC_CFGR & ~RCC_CFGR_SW_MSK) | RCC_CFGR_SW_PLL;
+    while ((RCC_CFGR & RCC_CFGR_SWS_MSK) != RCC_CFGR_SWS_PLL);
+
+    rcc_sysclk_hz = SysclkHz;
+    rcc_pclk1_hz = Apb1Divided ? SysclkHz / 2 : SysclkHz;
+    rcc_pclk2_hz = SysclkHz;
+    rcc_apb1_divided = Apb1Divided;
+    rcc_apb2_divided = 0;
+    return RCC_OK;
+}
+
+uint32 Rcc_GetSysclkHz(void) {
+    return rcc_sysclk_hz;
+}
+
+uint32 Rcc_GetHclkHz(void) {
+    return rcc_sysclk_hz;
+}
+
+uint32 Rcc_GetPclk1Hz(void) {
+    return rcc_pclk1_hz;
+}
+
+uint32 Rcc_GetPclk2Hz(void) {
+    return rcc_pclk2_hz;
+}
+
+uint32 Rcc_GetTimerClockHz(uint8 Bus) {
+    if (Bus == RCC_APB1) {
+        return rcc_apb1_divided ? rcc_pclk1_hz * 2 : rcc_pclk1_hz;
+    }
+    return rcc_apb2_divided ? rcc_pclk2_hz * 2 : rcc_pclk2_hz;
 }
 
 void Rcc_Enable(uint8 PeripheralId) {
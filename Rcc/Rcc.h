@@ -51,8 +51,36 @@
 #define RCC_TIM10           (RCC_APB2*32 + 17UL)
 #define RCC_TIM11           (RCC_APB2*32 + 18UL)
 
+#define RCC_OK  0x0
+#define RCC_NOK 0x1
+
+#define RCC_CLOCK_HSI 0U
+#define RCC_CLOCK_HSE 1U
+#define RCC_HSI_HZ          16000000UL
+#define RCC_DEFAULT_SYSCLK_HZ 84000000UL
+
+typedef struct {
+    uint8 Source;       // RCC_CLOCK_HSI or RCC_CLOCK_HSE, fed to the PLL
+    uint32 SourceHz;    // crystal frequency for HSE, ignored for HSI
+    uint32 SysclkHz;    // up to 84 MHz
+} Rcc_ClockConfig;
+
+// HSI -> PLL -> RCC_DEFAULT_SYSCLK_HZ; stays on plain HSI if that fails
 void Rcc_Init(void);
 
+// Sets flash wait states and APB prescalers for the target, then switches
+// SYSCLK to the PLL. Returns RCC_OK/RCC_NOK. An unreachable target or an HSE
+// that does not start keeps the previous clock; a PLL that does not lock
+// leaves SYSCLK on plain HSI, which the Rcc_Get*Hz() getters then report.
+uint8 Rcc_ConfigureClocks(const Rcc_ClockConfig* Config);
+
+uint32 Rcc_GetSysclkHz(void);
+uint32 Rcc_GetHclkHz(void);
+uint32 Rcc_GetPclk1Hz(void);
+uint32 Rcc_GetPclk2Hz(void);
+// Timers run at twice PCLK when their APB prescaler is not 1
+uint32 Rcc_GetTimerClockHz(uint8 Bus);
+
 void Rcc_Enable(uint8 PeripheralId);
 
 void Rcc_Disable(uint8 PeripheralId);
@@ -35,5 +35,51 @@
 #define RCC_SSCGR           REG32(RCC_BASE_ADDR + 0x80UL)
 #define RCC_PLLI2SCFGR      REG32(RCC_BASE_ADDR + 0x84UL)
 
+#define FLASH_BASE_ADDR     0x40023C00
+#define FLASH_ACR           REG32(FLASH_BASE_ADDR + 0x00UL)
+
+// RCC_CR
+#define RCC_CR_HSION        0
+#define RCC_CR_HSIRDY       1
+#define RCC_CR_HSEON        16
+#define RCC_CR_HSERDY       17
+#define RCC_CR_PLLON        24
+#define RCC_CR_PLLRDY       25
+
+// RCC_PLLCFGR
+#define RCC_PLLCFGR_M_POS   0
+#define RCC_PLLCFGR_N_POS   6
+#define RCC_PLLCFGR_P_POS   16
+#define RCC_PLLCFGR_SRC     22
+#define RCC_PLLCFGR_Q_POS   24
+
+// RCC_CFGR
+#define RCC_CFGR_SW_MSK     (0x3UL << 0)
+#define RCC_CFGR_SW_PLL     (0x2UL << 0)
+#define RCC_CFGR_SWS_MSK    (0x3UL << 2)
+#define RCC_CFGR_SWS_PLL    (0x2UL << 2)
+#define RCC_CFGR_HPRE_MSK   (0xFUL << 4)
+#define RCC_CFGR_PPRE1_POS  10
+#define RCC_CFGR_PPRE2_POS  13
+#define RCC_CFGR_PPRE_MSK   0x7UL
+#define RCC_CFGR_PPRE_DIV1  0x0UL
+#define RCC_CFGR_PPRE_DIV2  0x4UL
+
+// FLASH_ACR
+#define FLASH_ACR_LATENCY_MSK 0xFUL
+#define FLASH_ACR_PRFTEN    8
+#define FLASH_ACR_ICEN      9
+#define FLASH_ACR_DCEN      10
+
+// F401 limits (VDD 2.7-3.6V)
+#define RCC_MAX_SYSCLK_HZ   84000000UL
+#define RCC_MAX_PCLK1_HZ    42000000UL
+#define RCC_FLASH_WS_STEP_HZ 30000000UL   // one wait state per 30 MHz
+#define RCC_VCO_MIN_HZ      192000000UL
+#define RCC_VCO_MAX_HZ      432000000UL
+#define RCC_USB_HZ          48000000UL
+
+#define RCC_READY_TIMEOUT   100000UL      // polling iterations
+
 
 #endif /* RCC_PRIVATE_H */
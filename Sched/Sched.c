@@ -0,0 +1,163 @@
+#include "Sched.h"
+#include <stddef.h>
+
+static Sched_Task_t sched_tasks[SCHED_MAX_TASKS];
+static uint8_t sched_count = 0;
+static Sched_ClockFn_t sched_clock = NULL;
+static Sched_IdleFn_t sched_idle = NULL;
+static uint32_t sched_last_now = 0;
+static uint32_t sched_epoch = 0;
+static uint64_t sched_elapsed_us = 0;
+static uint64_t sched_idle_us = 0;
+
+// Wrap-safe "a is at or after b"
+static bool Sched_Reached(uint32_t a, uint32_t b) {
+    return (int32_t)(a - b) >= 0;
+}
+
+void Sched_Init(Sched_ClockFn_t clock) {
+    sched_clock = clock;
+    sched_count = 0;
+    sched_idle = NULL;
+    sched_last_now = clock();
+    sched_epoch = sched_last_now;
+    sched_elapsed_us = 0;
+    sched_idle_us = 0;
+}
+
+void Sched_SetEpoch(uint32_t epoch_us) {
+    sched_epoch = epoch_us;
+}
+
+void Sched_SetIdleHook(Sched_IdleFn_t idle) {
+    sched_idle = idle;
+}
+
+int8_t Sched_AddTask(const char *name, Sched_TaskFn_t run, uint32_t period_us, uint32_t offset_us) {
+    if (sched_clock == NULL || run == NULL || period_us == 0 || sched_count >= SCHED_MAX_TASKS) {
+        return -1;
+    }
+
+    Sched_Task_t *task = &sched_tasks[sched_count];
+    *task = (Sched_Task_t){0};
+    task->name = name;
+    task->run = run;
+    task->period_us = period_us;
+    task->release_us = sched_epoch + offset_us;
+    return (int8_t)sched_count++;
+}
+
+bool Sched_RunOnce(void) {
+    uint32_t now = sched_clock();
+    sched_elapsed_us += now - sched_last_now;
+    sched_last_now = now;
+
+    for (uint8_t i = 0; i < sched_count; i++) {
+        Sched_Task_t *task = &sched_tasks[i];
+        if (!Sched_Reached(now, task->release_us)) {
+            continue;
+        }
+
+        uint32_t start = sched_clock();
+        task->run();
+        uint32_t end = sched_clock();
+
+        uint32_t exec = end - start;
+        task->runs++;
+        task->exec_last_us = exec;
+        task->exec_total_us += exec;
+        if (exec > task->exec_max_us) {
+            task->exec_max_us = exec;
+        }
+
+        uint32_t deadline = task->release_us + task->period_us;
+        if (!Sched_Reached(deadline, end)) {
+            task->deadline_misses++;
+        }
+
+        // Keep the phase: skip, and count, any releases already gone by
+        task->release_us = deadline;
+        while (Sched_Reached(end, task->release_us)) {
+            task->release_us += task->period_us;
+            task->overruns++;
+        }
+        return true;
+    }
+
+    if (sched_idle != NULL) {
+        sched_idle();
+        uint32_t woke = sched_clock();
+        sched_idle_us += woke - now;
+        sched_elapsed_us += woke - now;
+        sched_last_now = woke;
+    }
+    return false;
+}
+
+uint32_t Sched_TimeToNextRelease(void) {
+    if (sched_count == 0) {
+        return UINT32_MAX;
+    }
+
+    uint32_t now = sched_clock();
+    uint32_t soonest = UINT32_MAX;
+    for (uint8_t i = 0; i < sched_count; i++) {
+        if (Sched_Reached(now, sched_tasks[i].release_us)) {
+            return 0;
+        }
+        uint32_t left = sched_tasks[i].release_us - now;
+        if (left < soonest) {
+            soonest = left;
+        }
+    }
+    return soonest;
+}
+
+const Sched_Task_t *Sched_GetTask(int8_t id) {
+    if (id < 0 || id >= sched_count) {
+        return NULL;
+    }
+    return &sched_tasks[id];
+}
+
+uint8_t Sched_GetTaskCount(void) {
+    return sched_count;
+}
+
+uint32_t Sched_GetAverageExecUs(int8_t id) {
+    const Sched_Task_t *task = Sched_GetTask(id);
+    if (task == NULL || task->runs == 0) {
+        return 0;
+    }
+    return (uint32_t)(task->exec_total_us / task->runs);
+}
+
+uint64_t Sched_GetIdleUs(void) {
+    return sched_idle_us;
+}
+
+uint64_t Sched_GetElapsedUs(void) {
+    return sched_elapsed_us;
+}
+
+uint16_t Sched_GetUtilizationPermille(void) {
+    if (sched_elapsed_us == 0) {
+        return 0;
+    }
+    return (uint16_t)((sched_elapsed_us - sched_idle_us) * 1000U / sched_elapsed_us);
+}
+
+void Sched_ResetStats(void) {
+    sched_last_now = sched_clock();
+    sched_elapsed_us = 0;
+    sched_idle_us = 0;
+    for (uint8_t i = 0; i < sched_count; i++) {
+        Sched_Task_t *task = &sched_tasks[i];
+        task->runs = 0;
+        task->overruns = 0;
+        task->deadline_misses = 0;
+        task->exec_max_us = 0;
+        task->exec_last_us = 0;
+        task->exec_total_us = 0;
+    }
+}
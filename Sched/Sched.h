@@ -0,0 +1,64 @@
+/**
+ * Sched.h
+ *
+ *  Cooperative fixed-period task scheduler with deadline, overrun and
+ *  execution-time accounting.
+ */
+
+#ifndef SCHED_H
+#define SCHED_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+// Tasks run to completion in registration order (first registered =
+// highest priority) once their release time has passed. The clock is
+// injected, so this file has no hardware dependency and builds unchanged
+// against a simulated clock.
+
+#define SCHED_MAX_TASKS 8
+
+typedef void (*Sched_TaskFn_t)(void);
+typedef uint32_t (*Sched_ClockFn_t)(void);   // free-running microseconds, may wrap
+typedef void (*Sched_IdleFn_t)(void);
+
+typedef struct {
+    const char *name;
+    Sched_TaskFn_t run;
+    uint32_t period_us;
+    uint32_t release_us;        // next release; its deadline is one period later
+    uint32_t runs;
+    uint32_t overruns;          // releases skipped because the task started too late
+    uint32_t deadline_misses;   // runs that finished after their deadline
+    uint32_t exec_max_us;
+    uint32_t exec_last_us;
+    uint64_t exec_total_us;
+} Sched_Task_t;
+
+void Sched_Init(Sched_ClockFn_t clock);
+// Releases are laid out from the epoch, which defaults to the clock at
+// Sched_Init. Put it on a wakeup tick so every release coincides with one
+// instead of landing just after it. Call before adding tasks.
+void Sched_SetEpoch(uint32_t epoch_us);
+// Returns the task id, or -1 when the table is full. The first release is
+// at epoch + offset_us; offset_us staggers tasks that share a period.
+int8_t Sched_AddTask(const char *name, Sched_TaskFn_t run, uint32_t period_us, uint32_t offset_us);
+// Called by Sched_RunOnce when no task is due; must return on the next
+// interrupt. Time spent inside it is accounted as idle.
+void Sched_SetIdleHook(Sched_IdleFn_t idle);
+// Runs the highest-priority due task, or the idle hook; false if nothing was due
+bool Sched_RunOnce(void);
+// Microseconds until the next release (0 if one is already due)
+uint32_t Sched_TimeToNextRelease(void);
+
+const Sched_Task_t *Sched_GetTask(int8_t id);
+uint8_t Sched_GetTaskCount(void);
+uint32_t Sched_GetAverageExecUs(int8_t id);
+// CPU load since Sched_Init or the last Sched_ResetStats: the share of
+// time not spent in the idle hook
+uint64_t Sched_GetIdleUs(void);
+uint64_t Sched_GetElapsedUs(void);
+uint16_t Sched_GetUtilizationPermille(void);
+void Sched_ResetStats(void);
+
+#endif // SCHED_H
@@ -0,0 +1,70 @@
+#include "Speed.h"
+
+#include <stddef.h>
+
+// Numerators are fixed per configuration, only the period varies:
+//   mHz  = tick_hz * 1000             / period
+//   rpm  = tick_hz * 60               / (period * ppr)
+//   mm/s = tick_hz * circumference_um / (period * ppr * 1000)
+static uint64_t speed_mhz_num = 0;
+static uint64_t speed_rpm_num = 0;
+static uint64_t speed_mms_num = 0;
+static uint32_t speed_rpm_den = 1;
+static uint32_t speed_mms_den = 1;
+
+static uint64_t Speed_Gcd(uint64_t a, uint64_t b) {
+    while (b != 0) {
+        uint64_t t = a % b;
+        a = b;
+        b = t;
+    }
+    return a;
+}
+
+// Round-to-nearest num / den. The Cortex-M4 divides 32-bit values in one
+// instruction; 64-bit division is a library call, so only fall back to it
+// when an operand doesn't fit.
+static uint32_t Speed_DivRound(uint64_t num, uint64_t den) {
+    uint64_t q;
+
+    if (den == 0) {
+        return 0;
+    }
+    if ((num >> 32) == 0 && (den >> 31) == 0 && num + (den >> 1) <= 0xFFFFFFFFUL) {
+        q = ((uint32_t)num + ((uint32_t)den >> 1)) / (uint32_t)den;
+    } else {
+        q = (num + (den >> 1)) / den;
+    }
+    return (q > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)q;
+}
+
+void Speed_Init(const Speed_Config_t *config) {
+    if (config == NULL || config->pulses_per_rev == 0) {
+        return;
+    }
+
+    speed_mhz_num = (uint64_t)config->tick_hz * 1000U;
+
+    // Reduce the constant fractions once so the per-sample path stays
+    // in 32-bit arithmetic for as long as possible
+    uint64_t g = Speed_Gcd((uint64_t)config->tick_hz * 60U, config->pulses_per_rev);
+    speed_rpm_num = (uint64_t)config->tick_hz * 60U / g;
+    speed_rpm_den = (uint32_t)(config->pulses_per_rev / g);
+
+    uint64_t mms_den = (uint64_t)config->pulses_per_rev * 1000U;
+    g = Speed_Gcd((uint64_t)config->tick_hz * config->circumference_um, mms_den);
+    speed_mms_num = (uint64_t)config->tick_hz * config->circumference_um / g;
+    speed_mms_den = (uint32_t)(mms_den / g);
+}
+
+uint32_t Speed_PeriodToMilliHz(uint32_t period) {
+    return Speed_DivRound(speed_mhz_num, period);
+}
+
+uint32_t Speed_PeriodToRpm(uint32_t period) {
+    return Speed_DivRound(speed_rpm_num, (uint64_t)period * speed_rpm_den);
+}
+
+uint32_t Speed_PeriodToMmPerSec(uint32_t period) {
+    return Speed_DivRound(speed_mms_num, (uint64_t)period * speed_mms_den);
+}
@@ -0,0 +1,20 @@
+#ifndef SPEED_H
+#define SPEED_H
+
+#include <stdint.h>
+
+// Integer-only conversion of capture periods (in timer ticks) to belt speed.
+// Every result is the exact quotient rounded to nearest, saturated to 32 bits.
+
+typedef struct {
+    uint32_t tick_hz;           // capture timer tick rate, see TimeCapture_GetTickHz()
+    uint16_t pulses_per_rev;    // encoder edges per pulley revolution
+    uint32_t circumference_um;  // pulley circumference in micrometres
+} Speed_Config_t;
+
+void Speed_Init(const Speed_Config_t *config);
+uint32_t Speed_PeriodToMilliHz(uint32_t period);
+uint32_t Speed_PeriodToRpm(uint32_t period);
+uint32_t Speed_PeriodToMmPerSec(uint32_t period);
+
+#endif // SPEED_H
@@ -0,0 +1,134 @@
+#include "SpeedFilter.h"
+
+#include <stddef.h>
+
+// First index in sorted[0..count) whose value is >= value
+static uint8_t SpeedFilter_LowerBound(const uint32_t *sorted, uint8_t count, uint32_t value) {
+    uint8_t lo = 0;
+    uint8_t hi = count;
+
+    while (lo < hi) {
+        uint8_t mid = (uint8_t)((lo + hi) / 2);
+        if (sorted[mid] < value) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo;
+}
+
+static uint32_t SpeedFilter_Median(SpeedFilter_t *filter, uint32_t sample) {
+    uint8_t window = filter->config.window;
+    uint32_t *sorted = filter->sorted;
+
+    if (filter->count < window) {
+        // Still filling: plain sorted insert
+        uint8_t pos = SpeedFilter_LowerBound(sorted, filter->count, sample);
+        for (uint8_t i = filter->count; i > pos; i--) {
+            sorted[i] = sorted[i - 1];
+        }
+        sorted[pos] = sample;
+        filter->count++;
+    } else {
+        // Replace the evicted sample in place, then slide the new one into order
+        uint32_t old = filter->history[filter->next];
+        uint8_t pos = SpeedFilter_LowerBound(sorted, window, old);
+        sorted[pos] = sample;
+        while (pos > 0 && sorted[pos - 1] > sample) {
+            sorted[pos] = sorted[pos - 1];
+            sorted[--pos] = sample;
+        }
+        while (pos + 1 < window && sorted[pos + 1] < sample) {
+            sorted[pos] = sorted[pos + 1];
+            sorted[++pos] = sample;
+        }
+    }
+
+    filter->history[filter->next] = sample;
+    filter->next = (uint8_t)((filter->next + 1) % window);
+
+    return sorted[filter->count / 2];
+}
+
+static uint32_t SpeedFilter_Ema(SpeedFilter_t *filter, uint32_t sample) {
+    uint64_t sample_q8 = (uint64_t)sample << 8;
+    uint8_t shift = filter->config.ema_shift;
+
+    if (filter->count == 0) {
+        filter->ema_q8 = sample_q8;
+        filter->count = 1;
+    } else if (sample_q8 >= filter->ema_q8) {
+        filter->ema_q8 += (sample_q8 - filter->ema_q8) >> shift;
+    } else {
+        filter->ema_q8 -= (filter->ema_q8 - sample_q8) >> shift;
+    }
+    return (uint32_t)((filter->ema_q8 + 0x80U) >> 8);
+}
+
+static uint8_t SpeedFilter_IsOutlier(const SpeedFilter_t *filter, uint32_t sample) {
+    uint32_t estimate = filter->estimate;
+
+    if (filter->config.outlier_pct == 0 || estimate == 0) {
+        return 0;
+    }
+    uint32_t diff = (sample > estimate) ? sample - estimate : estimate - sample;
+    return (uint64_t)diff * 100U > (uint64_t)estimate * filter->config.outlier_pct;
+}
+
+void SpeedFilter_Init(SpeedFilter_t *filter, const SpeedFilter_Config_t *config) {
+    if (filter == NULL || config == NULL) {
+        return;
+    }
+
+    filter->config = *config;
+    if (filter->config.window == 0) {
+        filter->config.window = 1;
+    }
+    if (filter->config.window > SPEED_FILTER_MAX_WINDOW) {
+        filter->config.window = SPEED_FILTER_MAX_WINDOW;
+    }
+    if (filter->config.ema_shift == 0 || filter->config.ema_shift > 8) {
+        filter->config.ema_shift = 2;
+    }
+    filter->rejected_total = 0;
+    SpeedFilter_Reset(filter);
+}
+
+void SpeedFilter_Reset(SpeedFilter_t *filter) {
+    filter->count = 0;
+    filter->next = 0;
+    filter->ema_q8 = 0;
+    filter->estimate = 0;
+    filter->rejected_run = 0;
+}
+
+uint32_t SpeedFilter_Update(SpeedFilter_t *filter, uint32_t sample) {
+    if (SpeedFilter_IsOutlier(filter, sample)) {
+        filter->rejected_total++;
+        if (++filter->rejected_run <= filter->config.outlier_max_run) {
+            return filter->estimate;
+        }
+        // Persistent deviation: the speed really changed, restart from here
+        SpeedFilter_Reset(filter);
+    }
+    filter->rejected_run = 0;
+
+    switch (filter->config.mode) {
+        case SPEED_FILTER_MEDIAN:
+            filter->estimate = SpeedFilter_Median(filter, sample);
+            break;
+        case SPEED_FILTER_EMA:
+            filter->estimate = SpeedFilter_Ema(filter, sample);
+            break;
+        case SPEED_FILTER_NONE:
+        default:
+            filter->estimate = sample;
+            break;
+    }
+    return filter->estimate;
+}
+
+uint32_t SpeedFilter_Get(const SpeedFilter_t *filter) {
+    return filter->estimate;
+}
@@ -0,0 +1,43 @@
+#ifndef SPEEDFILTER_H
+#define SPEEDFILTER_H
+
+#include <stdint.h>
+
+// Smoothing for raw capture periods. Memory is fixed by
+// SPEED_FILTER_MAX_WINDOW; every mode is O(1) or O(log N) compares per sample
+// (the median also shifts at most N words, N <= 15).
+
+#define SPEED_FILTER_MAX_WINDOW 15
+
+typedef enum {
+    SPEED_FILTER_NONE = 0,
+    SPEED_FILTER_MEDIAN,    // sliding median of the last `window` samples
+    SPEED_FILTER_EMA        // exponential moving average, alpha = 1 / 2^ema_shift
+} SpeedFilter_Mode_t;
+
+typedef struct {
+    SpeedFilter_Mode_t mode;
+    uint8_t window;             // median window, odd, 1..SPEED_FILTER_MAX_WINDOW
+    uint8_t ema_shift;          // 1..8
+    uint8_t outlier_pct;        // drop samples this % away from the estimate, 0 = off
+    uint8_t outlier_max_run;    // after this many drops in a row take it as a real step
+} SpeedFilter_Config_t;
+
+typedef struct {
+    SpeedFilter_Config_t config;
+    uint32_t history[SPEED_FILTER_MAX_WINDOW];  // arrival order
+    uint32_t sorted[SPEED_FILTER_MAX_WINDOW];   // same samples, ascending
+    uint8_t count;
+    uint8_t next;
+    uint64_t ema_q8;            // EMA state, 8 fractional bits
+    uint32_t estimate;
+    uint8_t rejected_run;
+    uint32_t rejected_total;
+} SpeedFilter_t;
+
+void SpeedFilter_Init(SpeedFilter_t *filter, const SpeedFilter_Config_t *config);
+void SpeedFilter_Reset(SpeedFilter_t *filter);
+uint32_t SpeedFilter_Update(SpeedFilter_t *filter, uint32_t sample);  // returns the new estimate
+uint32_t SpeedFilter_Get(const SpeedFilter_t *filter);
+
+#endif // SPEEDFILTER_H
@@ -0,0 +1,129 @@
+/**
+ * Telemetry.c
+ *
+ *  Fixed-size binary status records streamed over a USART by DMA. Two
+ *  frame buffers: the DMA reads one while the main loop encodes into the
+ *  other, and the transfer-complete interrupt starts the waiting one.
+ */
+
+#include "Telemetry.h"
+
+#include "Irq.h"
+#include "Std_Types.h"
+#include "Usart.h"
+
+#define TELEMETRY_NONE  0xFF
+#define TELEMETRY_BITS_PER_BYTE 10U     // 8N1
+
+static uint8 telemetry_frames[2][TELEMETRY_FRAME_SIZE];
+static volatile uint8 telemetry_sending = TELEMETRY_NONE;  // buffer the DMA is reading
+static volatile uint8 telemetry_pending = 0;               // the other buffer holds an unsent frame
+static uint8 telemetry_usart = USART_1;
+static uint8 telemetry_sequence = 0;
+static volatile uint32 telemetry_sent = 0;
+static uint32 telemetry_replaced = 0;
+
+// CRC-16/CCITT-FALSE (poly 0x1021, init 0xFFFF), one nibble per lookup
+static const uint16 telemetry_crc_table[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+
+static uint8* Telemetry_Put16(uint8* Out, uint16 Value) {
+    Out[0] = (uint8)Value;
+    Out[1] = (uint8)(Value >> 8);
+    return Out + 2;
+}
+
+static uint8* Telemetry_Put32(uint8* Out, uint32 Value) {
+    Out = Telemetry_Put16(Out, (uint16)Value);
+    return Telemetry_Put16(Out, (uint16)(Value >> 16));
+}
+
+static void Telemetry_Start(uint8 Buffer) {
+    telemetry_sending = Buffer;
+    if (Usart_WriteDma(telemetry_usart, telemetry_frames[Buffer], TELEMETRY_FRAME_SIZE) != USART_OK) {
+        telemetry_sending = TELEMETRY_NONE;   // no completion will come: drop the frame so the next publish starts DMA again
+    }
+}
+
+// DMA interrupt
+static void Telemetry_TxDone(uint8 Usart) {
+    (void)Usart;
+    uint8 Done = telemetry_sending;
+
+    telemetry_sent++;
+    telemetry_sending = TELEMETRY_NONE;
+    if (telemetry_pending) {
+        telemetry_pending = 0;
+        Telemetry_Start(Done ^ 1U);
+    }
+}
+
+uint8 Telemetry_Init(uint8 Usart, uint32 Baud, uint32 RateHz) {
+    if (RateHz == 0 || RateHz * TELEMETRY_FRAME_SIZE * TELEMETRY_BITS_PER_BYTE > Baud) {
+        return TELEMETRY_NOK;
+    }
+
+    telemetry_usart = Usart;
+    telemetry_sending = TELEMETRY_NONE;
+    telemetry_pending = 0;
+    return (Usart_Init(Usart, Baud, Telemetry_TxDone) == USART_OK) ? TELEMETRY_OK : TELEMETRY_NOK;
+}
+
+void Telemetry_Publish(const Telemetry_Record* Record) {
+    uint32 Primask = Irq_Save();
+    if (telemetry_pending) {
+        telemetry_pending = 0;       // the ISR must not start it while it is rewritten
+        telemetry_replaced++;
+    }
+    uint8 Buffer = (telemetry_sending == 0) ? 1 : 0;
+    Irq_Restore(Primask);
+
+    Telemetry_Encode(Record, telemetry_sequence++, telemetry_frames[Buffer]);
+
+    Primask = Irq_Save();
+    if (telemetry_sending == TELEMETRY_NONE) {
+        Telemetry_Start(Buffer);
+    } else {
+        telemetry_pending = 1;
+    }
+    Irq_Restore(Primask);
+}
+
+void Telemetry_Encode(const Telemetry_Record* Record, uint8 Sequence, uint8* Out) {
+    uint8* P = Out;
+
+    *P++ = TELEMETRY_SYNC0;
+    *P++ = TELEMETRY_SYNC1;
+    *P++ = TELEMETRY_PAYLOAD_SIZE;
+    *P++ = Sequence;
+    P = Telemetry_Put32(P, Record->TimestampUs);
+    P = Telemetry_Put32(P, Record->ObjectCount);
+    P = Telemetry_Put32(P, Record->PeriodTicks);
+    P = Telemetry_Put16(P, Record->SpeedMmS);
+    P = Telemetry_Put16(P, Record->Duty);
+    P = Telemetry_Put16(P, Record->AdcRaw);
+    *P++ = Record->Faults;
+
+    Telemetry_Put16(P, Telemetry_Crc16(Out + 2, (uint16)(P - (Out + 2))));
+}
+
+uint16 Telemetry_Crc16(const uint8* Data, uint16 Length) {
+    uint16 Crc = 0xFFFF;
+
+    for (uint16 i = 0; i < Length; i++) {
+        Crc ^= (uint16)Data[i] << 8;
+        Crc = (uint16)(Crc << 4) ^ telemetry_crc_table[Crc >> 12];
+        Crc = (uint16)(Crc << 4) ^ telemetry_crc_table[Crc >> 12];
+    }
+    return Crc;
+}
+
+uint32 Telemetry_GetSent(void) {
+    return telemetry_sent;
+}
+
+uint32 Telemetry_GetReplaced(void) {
+    return telemetry_replaced;
+}
@@ -0,0 +1,60 @@
+/**
+ * Telemetry.h
+ *
+ *  Fixed-size binary status records streamed over a USART by DMA.
+ *
+ *  Frame, multi-byte fields little-endian:
+ *    0   0xA5 0x5A   sync
+ *    2   length      payload bytes (TELEMETRY_PAYLOAD_SIZE)
+ *    3   sequence    +1 per encoded frame, gaps mean frames were replaced
+ *    4   payload     see Telemetry_Record, in field order
+ *    23  crc16       CRC-16/CCITT-FALSE over length, sequence and payload
+ */
+
+#ifndef TELEMETRY_H
+#define TELEMETRY_H
+#include "Std_Types.h"
+
+#define TELEMETRY_SYNC0         0xA5
+#define TELEMETRY_SYNC1         0x5A
+#define TELEMETRY_PAYLOAD_SIZE  19U
+#define TELEMETRY_FRAME_SIZE    (4U + TELEMETRY_PAYLOAD_SIZE + 2U)
+
+#define TELEMETRY_OK            0x0
+#define TELEMETRY_NOK           0x1
+
+// Faults
+#define TELEMETRY_FAULT_ESTOP           (1U << 0)
+#define TELEMETRY_FAULT_OVERCURRENT     (1U << 1)
+#define TELEMETRY_FAULT_EVENTS_DROPPED  (1U << 2)
+#define TELEMETRY_FAULT_BELT_STALLED    (1U << 3)
+
+typedef struct {
+    uint32 TimestampUs;
+    uint32 ObjectCount;
+    uint32 PeriodTicks;     // filtered encoder period, capture ticks
+    uint16 SpeedMmS;        // filtered belt speed
+    uint16 Duty;            // motor compare value, timer ticks
+    uint16 AdcRaw;          // potentiometer, latest conversion
+    uint8 Faults;
+} Telemetry_Record;
+
+// Fails if RateHz frames per second do not fit in the link at Baud
+uint8 Telemetry_Init(uint8 Usart, uint32 Baud, uint32 RateHz);
+
+/*
+ * Never waits: the frame is encoded into the buffer the DMA is not
+ * reading and goes out as soon as the link is free. A frame still waiting
+ * there is replaced by the newer one.
+ */
+void Telemetry_Publish(const Telemetry_Record* Record);
+
+// Writes one TELEMETRY_FRAME_SIZE frame to Out
+void Telemetry_Encode(const Telemetry_Record* Record, uint8 Sequence, uint8* Out);
+
+uint16 Telemetry_Crc16(const uint8* Data, uint16 Length);
+
+uint32 Telemetry_GetSent(void);
+uint32 Telemetry_GetReplaced(void);
+
+#endif /* TELEMETRY_H */
@@ -0,0 +1,77 @@
+/**
+ * Time.c
+ *
+ *  Millisecond timebase driven by the SysTick interrupt.
+ */
+
+#include "Time.h"
+
+#include "Bit_Operations.h"
+#include "Time_Private.h"
+#include "Std_Types.h"
+#include "Rcc.h"
+
+static volatile uint32 time_ms = 0;
+static uint32 time_ticks_per_ms = RCC_HSI_HZ / TIME_TICK_HZ;
+static uint32 time_ticks_per_us = RCC_HSI_HZ / 1000000UL;
+
+void SysTick_Handler(void) {
+    time_ms++;
+}
+
+// Call after Rcc_Init so the reload matches the final HCLK
+void Time_Init(void) {
+    time_ticks_per_ms = Rcc_GetHclkHz() / TIME_TICK_HZ;
+    time_ticks_per_us = Rcc_GetHclkHz() / 1000000UL;
+
+    SYSTICK_CSR = 0;
+    SYSTICK_RVR = time_ticks_per_ms - 1;
+    SYSTICK_CVR = 0;
+    time_ms = 0;
+
+    SET_BIT(SYSTICK_CSR, SYSTICK_CLKSOURCE);  // processor clock
+    SET_BIT(SYSTICK_CSR, SYSTICK_TICKINT);
+    SET_BIT(SYSTICK_CSR, SYSTICK_ENABLE);
+}
+
+uint32 Time_GetMs(void) {
+    return time_ms;
+}
+
+uint32 Time_GetUs(void) {
+    uint32 Ms;
+    uint32 Count;
+
+    // Retry if the tick interrupt ran between the two reads
+    do {
+        Ms = time_ms;
+        Count = SYSTICK_CVR;
+    } while (Ms != time_ms);
+
+    // SysTick counts down from RVR to 0
+    return Ms * 1000UL + (time_ticks_per_ms - 1 - Count) / time_ticks_per_us;
+}
+
+uint8 Time_Elapsed(uint32 Since, uint32 IntervalMs) {
+    return (uint32)(time_ms - Since) >= IntervalMs;
+}
+
+void Time_DeadlineStart(Time_Deadline* Deadline, uint32 TimeoutMs) {
+    Deadline->Start = time_ms;
+    Deadline->Length = TimeoutMs;
+}
+
+uint8 Time_DeadlineExpired(const Time_Deadline* Deadline) {
+    return Time_Elapsed(Deadline->Start, Deadline->Length);
+}
+
+void Time_DelayMs(uint32 Delay) {
+    uint32 Start = time_ms;
+    // +1 so a partially elapsed tick never shortens the wait
+    while ((uint32)(time_ms - Start) < Delay + 1);
+}
+
+void Time_DelayUs(uint32 Delay) {
+    uint32 Start = Time_GetUs();
+    while ((uint32)(Time_GetUs() - Start) < Delay);
+}
@@ -0,0 +1,38 @@
+/**
+ * Time.h
+ *
+ *  Millisecond timebase driven by the SysTick interrupt.
+ *  Time_GetUs() interpolates inside the current tick from the SysTick counter.
+ */
+
+#ifndef TIME_H
+#define TIME_H
+#include "Std_Types.h"
+
+// SysTick runs from HCLK, read from Rcc at Time_Init
+#define TIME_TICK_HZ        1000UL
+
+typedef struct {
+    uint32 Start;
+    uint32 Length;
+} Time_Deadline;
+
+void Time_Init(void);
+
+uint32 Time_GetMs(void);
+
+uint32 Time_GetUs(void);
+
+// Wrap-safe: true once IntervalMs has passed since the Since timestamp
+uint8 Time_Elapsed(uint32 Since, uint32 IntervalMs);
+
+void Time_DeadlineStart(Time_Deadline* Deadline, uint32 TimeoutMs);
+
+uint8 Time_DeadlineExpired(const Time_Deadline* Deadline);
+
+// Blocking waits, only meant for peripheral start-up sequences
+void Time_DelayMs(uint32 Delay);
+
+void Time_DelayUs(uint32 Delay);
+
+#endif /* TIME_H */
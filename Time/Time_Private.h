@@ -0,0 +1,24 @@
+/**
+ * Time_Private.h
+ *
+ *  SysTick register map used by the timebase.
+ */
+
+#ifndef TIME_PRIVATE_H
+#define TIME_PRIVATE_H
+#include "Std_Types.h"
+#include "Utils.h"
+
+#define SYSTICK_BASE_ADDR   0xE000E010UL
+#define SYSTICK_CSR         REG32(SYSTICK_BASE_ADDR + 0x00UL)
+#define SYSTICK_RVR         REG32(SYSTICK_BASE_ADDR + 0x04UL)
+#define SYSTICK_CVR         REG32(SYSTICK_BASE_ADDR + 0x08UL)
+#define SYSTICK_CALIB       REG32(SYSTICK_BASE_ADDR + 0x0CUL)
+
+// SYSTICK_CSR bits
+#define SYSTICK_ENABLE      0
+#define SYSTICK_TICKINT     1
+#define SYSTICK_CLKSOURCE   2
+#define SYSTICK_COUNTFLAG   16
+
+#endif /* TIME_PRIVATE_H */
@@ -1,15 +1,148 @@
 #include "TimeCapture.h"
 
 #include <Rcc.h>
+#include "Dma.h"
 
 // Time Capture Implementation
-volatile uint32_t capture1 = 0;
-volatile uint32_t capture2 = 0;
 volatile uint32_t period = 0;
-volatile uint8_t captureFlag = 0;
 volatile uint32_t overflow_count = 0;
 
+// Written by the TIM2 interrupt only
+static volatile uint32_t period_ring[TIMECAPTURE_RING_SIZE];
+static volatile uint32_t period_head = 0;      // periods written so far
+static volatile uint64_t period_sum = 0;       // sum of the last TIMECAPTURE_AVG_COUNT periods
+static volatile uint32_t period_count = 0;     // periods in period_sum, saturates (head wraps)
+static volatile uint64_t last_edge = 0;        // overflow-extended timestamp of the last edge
+static volatile uint8_t have_edge = 0;
+
+// Owned by the reader
+static uint32_t period_tail = 0;
+static uint32_t period_lost = 0;
+
+// DMA mode: CCR1 values streamed into a circular buffer
+static volatile uint32_t capture_dma_buffer[TIMECAPTURE_DMA_SIZE];
+static uint32_t capture_dma_read = 0;      // next buffer index to turn into a period
+static uint32_t capture_dma_last = 0;      // previous raw capture value
+
+// PWM-input mode: the hardware resets the counter on every rising edge
+static volatile uint8_t pwm_input_valid = 0;  // CCR1/CCR2 hold a full cycle
+static volatile uint8_t pwm_input_skip = 0;   // captures to drop after a stall
+
+static uint8_t capture_mode = TIMECAPTURE_MODE_IRQ;
+
+static void TimeCapture_ConfigureInput(void);
+static void TimeCapture_ClearPeriods(void);
+static void TimeCapture_PushPeriod(uint32_t value);
+static void TimeCapture_DmaProcess(uint32_t upto);
+
 void TimeCapture_Init(void) {
+    TimeCapture_ConfigureInput();
+
+    // Capture and overflow interrupts; the ISR extends the counter to 64 bits
+    capture_mode = TIMECAPTURE_MODE_IRQ;
+    have_edge = 0;
+    TIMER2->SR = 0;                            // Clear all flags
+    TIMER2->DIER = CC1IE | UIE;
+    NVIC_EnableIRQ(TIM2_IRQn);
+
+    // Enable the timer
+    TIMER2->CR1 |= COUNTER_ENABLE_MSK;
+}
+
+// Every capture raises a DMA request; the DMA burst interface (DCR/DMAR)
+// moves CCR1 into capture_dma_buffer and the half/full transfer interrupts
+// turn the values into periods in batches. Periods are 32-bit differences,
+// so one counter wrap between two edges is handled by unsigned arithmetic.
+void TimeCapture_InitDma(void) {
+    Dma_Config config = {
+        .Channel = TIMECAPTURE_DMA_CHANNEL,
+        .Direction = DMA_PERIPH_TO_MEM,
+        .DataSize = DMA_SIZE_32,
+        .Circular = 1,
+        .MemIncrement = 1,
+        .Priority = DMA_PRIORITY_HIGH,
+        .Interrupts = DMA_FLAG_HT | DMA_FLAG_TC,
+    };
+
+    TimeCapture_ConfigureInput();
+
+    capture_mode = TIMECAPTURE_MODE_DMA;
+    capture_dma_read = 0;
+    have_edge = 0;
+
+    Dma_Init(DMA_1, TIMECAPTURE_DMA_STREAM, &config);
+    Dma_Start(DMA_1, TIMECAPTURE_DMA_STREAM, (uint32_t)&TIMER2->DMAR,
+              (uint32_t)capture_dma_buffer, TIMECAPTURE_DMA_SIZE);
+    NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+
+    // One 32-bit transfer from CCR1 per request
+    TIMER2->DCR = (DCR_DBA_CCR1 << DCR_DBA_POS) | (0UL << DCR_DBL_POS);
+    TIMER2->SR = 0;
+    TIMER2->DIER = CC1DE;
+
+    TIMER2->CR1 |= COUNTER_ENABLE_MSK;
+}
+
+// TI1 feeds both capture channels: IC1 latches the counter on the rising
+// edge, then the slave controller resets it (SMS = reset, TS = TI1FP1);
+// IC2 latches it on the falling edge. CCR1 is the period and CCR2 the high
+// time without any timestamp arithmetic; the capture interrupt only copies
+// CCR1 into the period ring. ARR only expires when no rising edge arrives
+// for TIMECAPTURE_PWM_TIMEOUT ticks, which marks the signal stalled.
+void TimeCapture_InitPwmInput(void) {
+    TimeCapture_ConfigureInput();
+
+    capture_mode = TIMECAPTURE_MODE_PWM_INPUT;
+    pwm_input_valid = 0;
+    pwm_input_skip = 1;    // first capture measures from the start, not an edge
+
+    TIMER2->ARR = TIMECAPTURE_PWM_TIMEOUT;
+    TIMER2->CCMR1 &= ~CC2S_MSK;
+    TIMER2->CCMR1 |= (0x2UL << CC2S_POS);      // CC2S = 10: TI1 mapped to CC2
+    TIMER2->CCER |= CC2P_MSK | CC2E_MSK;       // IC2 on the falling edge
+    TIMER2->SMCR = (SMCR_TS_TI1FP1 << SMCR_TS_POS) | (SMCR_SMS_RESET << SMCR_SMS_POS);
+    TIMER2->CR1 |= URS_MSK;                    // slave resets don't raise UIF
+
+    TIMER2->SR = 0;
+    TIMER2->DIER = UIE | CC1IE;
+    NVIC_EnableIRQ(TIM2_IRQn);
+
+    TIMER2->CR1 |= COUNTER_ENABLE_MSK;
+}
+
+uint8_t TimeCapture_GetPwmInput(uint32_t *period_out, uint32_t *high_out) {
+    uint32_t p;
+    uint32_t h;
+
+    if (capture_mode != TIMECAPTURE_MODE_PWM_INPUT || !pwm_input_valid) {
+        return 0;
+    }
+
+    // Retry if a new rising edge landed between the two reads
+    do {
+        p = TIMER2->CCR1;
+        h = TIMER2->CCR2;
+    } while (p != TIMER2->CCR1);
+
+    *period_out = p;
+    *high_out = h;
+    return 1;
+}
+
+uint16_t TimeCapture_GetDutyPermille(void) {
+    uint32_t p;
+    uint32_t h;
+
+    if (!TimeCapture_GetPwmInput(&p, &h) || p == 0) {
+        return 0;
+    }
+    if (h > p) {
+        h = p;
+    }
+    return (uint16_t)(((uint64_t)h * 1000U + p / 2) / p);
+}
+
+static void TimeCapture_ConfigureInput(void) {
     // Enable GPIOA and TIM2 clocks
 
     // // RCC->AHB1ENR |= RCC_AHB1ENR_GPIOAEN;
@@ -23,14 +156,18 @@ void TimeCapture_Init(void) {
     GPIOA->AFR[0] |= (0x1 << (5*4));         // Set AF1 for TIM2_CH1
 
     // Configure TIM2 for input capture
-    TIMER2->PSC = 16000-1;                          // Did not work 84MHz/(83+1) = 1MHz (1µs resolution)
+    TIMER2->PSC = Rcc_GetTimerClockHz(RCC_APB1) / TIMECAPTURE_TICK_HZ - 1;   // 1MHz (1µs resolution)
     TIMER2->EGR |= UPDATE_GENERATION_MSK;                 // Force update event to load new PSC
-    TIMER2->SR &= ~UIF;
+    TIMER2->SR = (uint32_t)~UIF;
     TIMER2->ARR = 0xFFFFFFFF  ;                 //Hisham dont change this
-    TIMER2->CR1 &= ~COUNTER_ENABLE_MSK;               // Ensure timer is stopped during config
+    TIMER2->CR1 &= ~(COUNTER_ENABLE_MSK | URS_MSK);   // Ensure timer is stopped during config
+    TIMER2->SMCR = 0;                                 // No slave mode (PWM input sets reset mode)
+    TIMER2->DCR = 0;
+    TIMER2->DIER = 0;
 
-    // Configure Channel 1 for input capture
-    TIMER2->CCMR1 &= ~(CC1S_MSK | IC1F_MSK);  // Clear capture selection and filter bits
+    // Configure Channel 1 for input capture; undo the PWM-input use of CH2
+    TIMER2->CCER &= ~(CC2E_MSK | CC2P_MSK);   // Channel must be off to change CC2S
+    TIMER2->CCMR1 &= ~(CC1S_MSK | IC1F_MSK | CC2S_MSK);  // Clear capture selection and filter bits
     TIMER2->CCMR1 |= TIM_CCMR1_CC1S_0;        // CC1S = 01: TI1 mapped to CC1
 
     // TIM2->CCMR1 |= (0x3 << 4);              // IC1F = 0011: fSAMPLING=fCK_INT, N=8
@@ -38,112 +175,222 @@ void TimeCapture_Init(void) {
     // Configure capture on rising edge
     TIMER2->CCER &= ~(CC1P_Msk | CC1NP_MSK); // Clear polarity bits (rising edge)
     TIMER2->CCER |= CAPTURE_ENABLE_MSK;             // Enable capture
+}
 
-    // Enable update interrupt for overflow handling (even though you can't use interrupts)
-    // We'll poll for these flags instead
-    TIMER2->DIER = 0;                          // Clear all interrupt enables first
-    TIMER2->SR = 0;                            // Clear all flags
+static void TimeCapture_ClearPeriods(void) {
+    period = 0;
+    period_head = 0;
+    period_sum = 0;
+    period_count = 0;
+    period_tail = 0;
+}
 
-    // Enable the timer
-    TIMER2->CR1 |= COUNTER_ENABLE_MSK;
+void TIM2_IRQHandler(void) {
+    uint32_t sr = TIMER2->SR;
+
+    if (capture_mode == TIMECAPTURE_MODE_PWM_INPUT) {
+        // Only runs on a stall and for the edges right after it
+        if (sr & UIF) {
+            TIMER2->SR = (uint32_t)~UIF;
+            pwm_input_valid = 0;
+            pwm_input_skip = 1;
+            period = 0;
+            // CC1IF may still hold the last edge before the stall; drop it
+            // so the skip applies to the partial first capture instead
+            TIMER2->SR = (uint32_t)~CC1_IF;
+            sr &= ~CC1_IF;
+        }
+        if (sr & CC1_IF) {
+            uint32_t capture = TIMER2->CCR1;   // clears CC1IF
+            if (pwm_input_skip) {
+                pwm_input_skip = 0;
+            } else {
+                pwm_input_valid = 1;
+                TimeCapture_PushPeriod(capture);
+            }
+        }
+        return;
+    }
+
+    if (sr & CC1_IF) {
+        uint32_t capture = TIMER2->CCR1;       // reading CCR1 clears CC1IF
+        uint32_t high = overflow_count;
+
+        // An overflow still pending next to a capture near the bottom of the
+        // count range happened before the edge
+        if ((sr & UIF) && capture < 0x80000000UL) {
+            high++;
+        }
+
+        uint64_t edge = ((uint64_t)high << 32) | capture;
+        if (have_edge) {
+            uint64_t delta = edge - last_edge;
+            TimeCapture_PushPeriod((delta > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)delta);
+        }
+        last_edge = edge;
+        have_edge = 1;
+
+        if (sr & CC1_OF) {
+            TIMER2->SR = (uint32_t)~CC1_OF;    // an edge was missed, next period is a multiple
+        }
+    }
+
+    if (sr & UIF) {
+        TIMER2->SR = (uint32_t)~UIF;
+        overflow_count++;
+    }
+}
+
+void DMA1_Stream5_IRQHandler(void) {
+    uint8_t flags = Dma_GetFlags(DMA_1, TIMECAPTURE_DMA_STREAM);
+    Dma_ClearFlags(DMA_1, TIMECAPTURE_DMA_STREAM, flags);
+
+    if (flags & DMA_FLAG_HT) {
+        TimeCapture_DmaProcess(TIMECAPTURE_DMA_SIZE / 2);
+    }
+    if (flags & DMA_FLAG_TC) {
+        TimeCapture_DmaProcess(TIMECAPTURE_DMA_SIZE);
+    }
+}
+
+// At low edge rates a half buffer takes long to fill; this picks up the
+// captures already written without waiting for the next batch
+void TimeCapture_PollDma(void) {
+    if (capture_mode != TIMECAPTURE_MODE_DMA) {
+        return;
+    }
+
+    NVIC_DisableIRQ(DMA1_Stream5_IRQn);
+    uint32_t written = TIMECAPTURE_DMA_SIZE - Dma_GetRemaining(DMA_1, TIMECAPTURE_DMA_STREAM);
+    if (written >= capture_dma_read) {
+        TimeCapture_DmaProcess(written);
+    }
+    NVIC_EnableIRQ(DMA1_Stream5_IRQn);
+}
+
+static void TimeCapture_DmaProcess(uint32_t upto) {
+    // Nothing to do if TimeCapture_PollDma() already went past this point
+    while (capture_dma_read < upto) {
+        uint32_t capture = capture_dma_buffer[capture_dma_read++];
+        if (have_edge) {
+            TimeCapture_PushPeriod(capture - capture_dma_last);
+        }
+        capture_dma_last = capture;
+        have_edge = 1;
+    }
+
+    if (capture_dma_read >= TIMECAPTURE_DMA_SIZE) {
+        capture_dma_read = 0;
+    }
+}
+
+static void TimeCapture_PushPeriod(uint32_t value) {
+    uint32_t slot = period_head & (TIMECAPTURE_RING_SIZE - 1);
+    uint32_t oldest = period_ring[(period_head - TIMECAPTURE_AVG_COUNT) & (TIMECAPTURE_RING_SIZE - 1)];
+    if (period_count < TIMECAPTURE_AVG_COUNT) {
+        oldest = 0;
+        period_count++;
+    }
+    period_sum = period_sum + value - oldest;
+    period_ring[slot] = value;
+    period_head++;
+    period = value;
+}
+
+uint32_t TimeCapture_GetTickHz(void) {
+    return TIMECAPTURE_TICK_HZ;
 }
 
 uint32_t TimeCapture_GetPeriod(void) {
+    if (capture_mode == TIMECAPTURE_MODE_PWM_INPUT) {
+        return pwm_input_valid ? TIMER2->CCR1 : 0;
+    }
     return period;
 }
-//
-// void TimeCapture_Start(void) {
-//     TIM2->CNT = 0;
-//     captureFlag = 0;
-//     capture1 = 0;
-//     capture2 = 0;
-//     period = 0;
-//     overflow_count = 0;
-//     TIM2->SR = 0;  // Clear all flags
-// }
 
-void TimeCapture_Stop(void) {
-    TIMER2->CR1 &= ~COUNTER_ENABLE_MSK;
+uint32_t TimeCapture_GetAveragePeriod(void) {
+    uint32_t head;
+    uint32_t count;
+    uint64_t sum;
+
+    // Retry if a capture landed between the reads
+    do {
+        head = period_head;
+        count = period_count;
+        sum = period_sum;
+    } while (head != period_head);
+
+    if (count == 0) {
+        return 0;
+    }
+    if (count < TIMECAPTURE_AVG_COUNT) {
+        return (uint32_t)(sum / count);
+    }
+    return (uint32_t)(sum >> TIMECAPTURE_AVG_SHIFT);
 }
 
-// Call this function regularly in your main loop to process captures
-// Fixed calculation in ProcessInputCapture
-void ProcessInputCapture(void) {
-    uint32_t sr = TIMER2->SR;
+uint8_t TimeCapture_ReadPeriod(uint32_t *out) {
+    uint32_t head = period_head;
 
-    // Handle timer overflow
-    if(sr & UIF) {
-        overflow_count++;
-        TIMER2->SR &= ~UIF;  // Clear overflow flag
-    }
-
-    // Handle input capture
-    if(sr & CC1_IF) {
-        uint32_t current_capture = TIMER2->CCR1;
-
-        if(!captureFlag) {
-            // First capture - store reference point
-            capture1 = current_capture;
-            captureFlag = 1;
-            overflow_count = 0;  // Reset overflow counter for this measurement
-        } else {
-            // Second capture - calculate period
-            capture2 = current_capture;
-
-            // Fixed calculation for period
-            if(overflow_count == 0) {
-                // Simple case - no overflow between captures
-                if(capture2 >= capture1) {
-                    period = capture2 - capture1;
-                } else {
-                    // This shouldn't happen if no overflow
-                    period = 0;  // Error case
-                }
-            } else {
-                // Handle overflow case - use 64-bit arithmetic
-                uint64_t temp_period;
-                temp_period = ((uint64_t)overflow_count << 32) + capture2 - capture1;
-
-                // Check if result fits in 32-bit
-                if(temp_period > 0xFFFFFFFF) {
-                    period = 0xFFFFFFFF;  // Saturate to maximum
-                } else {
-                    period = (uint32_t)temp_period;
-                }
-            }
+    if (period_tail == head) {
+        return 0;
+    }
 
-            captureFlag = 0;
-            overflow_count = 0;
-        }
+    // The ISR overwrites the oldest entries when the reader falls behind
+    if (head - period_tail > TIMECAPTURE_RING_SIZE) {
+        period_lost += head - period_tail - TIMECAPTURE_RING_SIZE;
+        period_tail = head - TIMECAPTURE_RING_SIZE;
+    }
+
+    uint32_t value = period_ring[period_tail & (TIMECAPTURE_RING_SIZE - 1)];
 
-        TIM2->SR &= ~TIM_SR_CC1IF;  // Clear capture flag
+    // Slot may have been reused while reading it
+    if (period_head - period_tail > TIMECAPTURE_RING_SIZE) {
+        return TimeCapture_ReadPeriod(out);
     }
+
+    *out = value;
+    period_tail++;
+    return 1;
+}
+
+uint32_t TimeCapture_GetPeriodCount(void) {
+    return period_head;
+}
+
+uint32_t TimeCapture_GetLostCount(void) {
+    return period_lost;
+}
+
+void TimeCapture_Stop(void) {
+    TIMER2->CR1 &= ~COUNTER_ENABLE_MSK;
 }
 
-// Also fix the start function to ensure clean start
+// Restart measurement from a clean state (drops the period history)
 void TimeCapture_Start(void) {
+    if (capture_mode == TIMECAPTURE_MODE_PWM_INPUT) {
+        TimeCapture_Stop();
+        NVIC_DisableIRQ(TIM2_IRQn);
+        TimeCapture_ClearPeriods();
+        TimeCapture_InitPwmInput();
+        return;
+    }
+
+    if (capture_mode == TIMECAPTURE_MODE_DMA) {
+        TimeCapture_Stop();
+        Dma_Stop(DMA_1, TIMECAPTURE_DMA_STREAM);
+        TimeCapture_InitDma();
+        TimeCapture_ClearPeriods();
+        return;
+    }
+
+    NVIC_DisableIRQ(TIM2_IRQn);
     TIMER2->CR1 &= ~COUNTER_ENABLE_MSK;       // Stop timer first
     TIMER2->CNT = 0;                   // Reset counter to 0
-    captureFlag = 0;
-    capture1 = 0;
-    capture2 = 0;
-    period = 0;
     overflow_count = 0;
+    TimeCapture_ClearPeriods();
+    have_edge = 0;
     TIMER2->SR = 0;                    // Clear all flags
     TIMER2->CR1 |= COUNTER_ENABLE_MSK;        // Restart timer
+    NVIC_EnableIRQ(TIM2_IRQn);
 }
-// Helper functions (optional - you can remove if not needed)
-// uint8_t TimeCapture_HasNewPeriod(void) {
-//     static uint32_t lastPeriod = 0;
-//
-//     if(period != lastPeriod && period != 0) {
-//         lastPeriod = period;
-//         return 1;
-//     }
-//     return 0;
-// }
-
-// uint32_t TimeCapture_GetFrequencyHz(void) {
-//     if(period == 0) return 0;
-//     return (1000000 + period/2) / period;  // 1MHz / period with rounding
-// }
\ No newline at end of file
@@ -6,27 +6,27 @@
 
 typedef struct
 {
-   uint32_t CR1;         /*!< TIM control register 1,              Address offset: 0x00 */
-   uint32_t CR2;         /*!< TIM control register 2,              Address offset: 0x04 */
-   uint32_t SMCR;        /*!< TIM slave mode control register,     Address offset: 0x08 */
-   uint32_t DIER;        /*!< TIM DMA/interrupt enable register,   Address offset: 0x0C */
-   uint32_t SR;          /*!< TIM status register,                 Address offset: 0x10 */
-   uint32_t EGR;         /*!< TIM event generation register,       Address offset: 0x14 */
-   uint32_t CCMR1;       /*!< TIM capture/compare mode register 1, Address offset: 0x18 */
-   uint32_t CCMR2;       /*!< TIM capture/compare mode register 2, Address offset: 0x1C */
-   uint32_t CCER;        /*!< TIM capture/compare enable register, Address offset: 0x20 */
-   uint32_t CNT;         /*!< TIM counter register,                Address offset: 0x24 */
-   uint32_t PSC;         /*!< TIM prescaler,                       Address offset: 0x28 */
-   uint32_t ARR;         /*!< TIM auto-reload register,            Address offset: 0x2C */
-   uint32_t RCR;         /*!< TIM repetition counter register,     Address offset: 0x30 */
-   uint32_t CCR1;        /*!< TIM capture/compare register 1,      Address offset: 0x34 */
-   uint32_t CCR2;        /*!< TIM capture/compare register 2,      Address offset: 0x38 */
-   uint32_t CCR3;        /*!< TIM capture/compare register 3,      Address offset: 0x3C */
-   uint32_t CCR4;        /*!< TIM capture/compare register 4,      Address offset: 0x40 */
-   uint32_t BDTR;        /*!< TIM break and dead-time register,    Address offset: 0x44 */
-   uint32_t DCR;         /*!< TIM DMA control register,            Address offset: 0x48 */
-   uint32_t DMAR;        /*!< TIM DMA address for full transfer,   Address offset: 0x4C */
-   uint32_t OR;          /*!< TIM option register,                 Address offset: 0x50 */
+   volatile uint32_t CR1;         /*!< TIM control register 1,              Address offset: 0x00 */
+   volatile uint32_t CR2;         /*!< TIM control register 2,              Address offset: 0x04 */
+   volatile uint32_t SMCR;        /*!< TIM slave mode control register,     Address offset: 0x08 */
+   volatile uint32_t DIER;        /*!< TIM DMA/interrupt enable register,   Address offset: 0x0C */
+   volatile uint32_t SR;          /*!< TIM status register,                 Address offset: 0x10 */
+   volatile uint32_t EGR;         /*!< TIM event generation register,       Address offset: 0x14 */
+   volatile uint32_t CCMR1;       /*!< TIM capture/compare mode register 1, Address offset: 0x18 */
+   volatile uint32_t CCMR2;       /*!< TIM capture/compare mode register 2, Address offset: 0x1C */
+   volatile uint32_t CCER;        /*!< TIM capture/compare enable register, Address offset: 0x20 */
+   volatile uint32_t CNT;         /*!< TIM counter register,                Address offset: 0x24 */
+   volatile uint32_t PSC;         /*!< TIM prescaler,                       Address offset: 0x28 */
+   volatile uint32_t ARR;         /*!< TIM auto-reload register,            Address offset: 0x2C */
+   volatile uint32_t RCR;         /*!< TIM repetition counter register,     Address offset: 0x30 */
+   volatile uint32_t CCR1;        /*!< TIM capture/compare register 1,      Address offset: 0x34 */
+   volatile uint32_t CCR2;        /*!< TIM capture/compare register 2,      Address offset: 0x38 */
+   volatile uint32_t CCR3;        /*!< TIM capture/compare register 3,      Address offset: 0x3C */
+   volatile uint32_t CCR4;        /*!< TIM capture/compare register 4,      Address offset: 0x40 */
+   volatile uint32_t BDTR;        /*!< TIM break and dead-time register,    Address offset: 0x44 */
+   volatile uint32_t DCR;         /*!< TIM DMA control register,            Address offset: 0x48 */
+   volatile uint32_t DMAR;        /*!< TIM DMA address for full transfer,   Address offset: 0x4C */
+   volatile uint32_t OR;          /*!< TIM option register,                 Address offset: 0x50 */
 } TIMER_TypeDef;
 #define TIMER2_BASE             ( 0x40000000UL + 0x0000UL)
 
@@ -43,15 +43,61 @@ typedef struct
 #define CAPTURE_ENABLE_MSK    (0x1UL << (0U))
 
 #define CC1_IF (0x1UL << (1U))
+#define CC1_OF                (0x1UL << (9U))
+#define UIE                   (0x1UL << (0U))
+#define CC1IE                 (0x1UL << (1U))
+#define CC1DE                 (0x1UL << (9U))
+#define URS_MSK               (0x1UL << (2U))
+#define CC2S_POS              8U
+#define CC2S_MSK              (0x3UL << CC2S_POS)
+#define CC2E_MSK              (0x1UL << (4U))
+#define CC2P_MSK              (0x1UL << (5U))
+#define SMCR_SMS_POS          0U
+#define SMCR_SMS_RESET        0x4UL
+#define SMCR_TS_POS           4U
+#define SMCR_TS_TI1FP1        0x5UL
+#define DCR_DBA_POS           0U
+#define DCR_DBL_POS           8U
+#define DCR_DBA_CCR1          (0x34UL / 4U)   // CCR1 offset in words
+
+#define TIMECAPTURE_RING_SIZE 16U   // power of two
+#define TIMECAPTURE_AVG_SHIFT 3U    // average over the last 8 periods
+#define TIMECAPTURE_AVG_COUNT (1U << TIMECAPTURE_AVG_SHIFT)
+
+// Capture tick; the prescaler is derived from the APB1 timer clock
+#define TIMECAPTURE_TICK_HZ         1000000UL
+
+#define TIMECAPTURE_MODE_IRQ        0U
+#define TIMECAPTURE_MODE_DMA        1U
+#define TIMECAPTURE_MODE_PWM_INPUT  2U
+
+// PWM-input mode: no rising edge for this many ticks (2 s) means the signal stopped
+#define TIMECAPTURE_PWM_TIMEOUT (TIMECAPTURE_TICK_HZ * 2UL)
+
+// DMA mode: TIM2_CH1 requests are on DMA1 stream 5, channel 3
+#define TIMECAPTURE_DMA_STREAM  5U
+#define TIMECAPTURE_DMA_CHANNEL 3U
+#define TIMECAPTURE_DMA_SIZE    64U   // captures per circular buffer
+
 // Time Capture Functions
+// Every rising edge on PA5 is timestamped by the TIM2 interrupt; periods
+// (in timer ticks) are kept in a ring buffer the main loop reads at leisure.
 void TimeCapture_Init(void);
-uint32_t TimeCapture_GetPeriod(void);
+void TimeCapture_InitDma(void);               // DMA mode for high edge rates
+void TimeCapture_PollDma(void);               // DMA mode: flush captures not yet batched
+void TimeCapture_InitPwmInput(void);          // hardware period + high time, ISR only queues CCR1
+uint8_t TimeCapture_GetPwmInput(uint32_t *period_out, uint32_t *high_out);
+uint16_t TimeCapture_GetDutyPermille(void);   // PWM-input mode: high time / period
+uint32_t TimeCapture_GetTickHz(void);         // rate periods are counted in
+uint32_t TimeCapture_GetPeriod(void);         // latest period, 0 before two edges
+uint32_t TimeCapture_GetAveragePeriod(void);  // mean of the last TIMECAPTURE_AVG_COUNT
+uint8_t TimeCapture_ReadPeriod(uint32_t *out); // oldest unread period, 0 if none
+uint32_t TimeCapture_GetPeriodCount(void);    // periods measured since start
+uint32_t TimeCapture_GetLostCount(void);      // periods overwritten before being read
 void TimeCapture_Start(void);
 void TimeCapture_Stop(void);
-void ProcessInputCapture(void);
 
 // Shared variables
-extern volatile uint8_t captureFlag;
 extern volatile uint32_t period;
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,133 @@
+/**
+ * Usart.c
+ *
+ *  Transmit-only USART driver with DMA.
+ */
+
+#include "Usart.h"
+
+#include "Bit_Operations.h"
+#include "Dma.h"
+#include "Gpio.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+#include "Rcc.h"
+#include "Std_Types.h"
+#include "Usart_Private.h"
+
+typedef struct {
+    USART_Type* Regs;
+    uint8 RccId;
+    uint8 Bus;          // RCC_APB1/RCC_APB2
+    uint8 TxPort;
+    uint8 TxPin;
+    uint8 AltFunc;
+    uint8 DmaController;
+    uint8 DmaStream;
+    uint8 DmaChannel;
+    uint8 DmaIrq;
+} Usart_Desc;
+
+// USART2's TX pins are PA2 (LCD RW on this board) and PD5 (not bonded on
+// the 64-pin package), so telemetry uses USART1 on PB6 instead of PA9,
+// which is the reset button
+static const Usart_Desc usart_map[USART_COUNT] = {
+    [USART_1] = { (USART_Type*) USART1_BASE_ADDR, RCC_USART1, RCC_APB2, GPIO_B, 6, 7, DMA_2, 7, 4, 70 },
+    [USART_2] = { (USART_Type*) USART2_BASE_ADDR, RCC_USART2, RCC_APB1, GPIO_A, 2, 7, DMA_1, 6, 4, 17 },
+};
+
+static Usart_TxDoneFn usart_tx_done[USART_COUNT];
+static volatile uint8 usart_tx_busy[USART_COUNT];
+static uint32 usart_baud[USART_COUNT];
+
+uint8 Usart_Init(uint8 Usart, uint32 Baud, Usart_TxDoneFn TxDone) {
+    if (Usart >= USART_COUNT || Baud == 0) {
+        return USART_NOK;
+    }
+
+    const Usart_Desc* U = &usart_map[Usart];
+    uint32 Pclk = (U->Bus == RCC_APB2) ? Rcc_GetPclk2Hz() : Rcc_GetPclk1Hz();
+
+    // 16x oversampling: BRR holds USARTDIV in 12.4 fixed point, i.e. Pclk / Baud
+    uint32 Brr = (Pclk + Baud / 2) / Baud;
+    if (Brr < 16 || Brr > 0xFFFF) {
+        return USART_NOK;
+    }
+
+    Rcc_Enable(U->RccId);
+
+    Gpio_Init(U->TxPort, U->TxPin, GPIO_AF, GPIO_PUSH_PULL);
+    GPIO_Device* Gpio = GPIO_PORT_DEVICE(U->TxPort);
+    if (U->TxPin < 8) {
+        Gpio->GPIO_AFRL &= ~(0xFUL << (U->TxPin * 4));
+        Gpio->GPIO_AFRL |= ((uint32)U->AltFunc << (U->TxPin * 4));
+    } else {
+        Gpio->GPIO_AFRH &= ~(0xFUL << ((U->TxPin - 8) * 4));
+        Gpio->GPIO_AFRH |= ((uint32)U->AltFunc << ((U->TxPin - 8) * 4));
+    }
+
+    Dma_Config Config = {
+        .Channel = U->DmaChannel,
+        .Direction = DMA_MEM_TO_PERIPH,
+        .DataSize = DMA_SIZE_8,
+        .Circular = 0,
+        .MemIncrement = 1,
+        .Priority = DMA_PRIORITY_LOW,
+        .Interrupts = DMA_FLAG_TC | DMA_FLAG_TE,
+    };
+    Dma_Init(U->DmaController, U->DmaStream, &Config);
+
+    U->Regs->CR1 = 0;
+    U->Regs->CR2 = 0;                       // 1 stop bit
+    U->Regs->CR3 = (1UL << USART_CR3_DMAT);
+    U->Regs->BRR = Brr;
+    U->Regs->CR1 = (1UL << USART_CR1_UE) | (1UL << USART_CR1_TE);
+
+    usart_tx_done[Usart] = TxDone;
+    usart_tx_busy[Usart] = 0;
+    usart_baud[Usart] = (Pclk + Brr / 2) / Brr;
+
+    Irq_Enable(U->DmaIrq);
+    return USART_OK;
+}
+
+uint8 Usart_WriteDma(uint8 Usart, const uint8* Data, uint16 Length) {
+    if (Usart >= USART_COUNT || Length == 0 || usart_tx_busy[Usart]) {
+        return USART_NOK;
+    }
+
+    const Usart_Desc* U = &usart_map[Usart];
+    usart_tx_busy[Usart] = 1;
+    Dma_Start(U->DmaController, U->DmaStream, (uint32)&U->Regs->DR, (uint32)Data, Length);
+    return USART_OK;
+}
+
+uint8 Usart_IsTxBusy(uint8 Usart) {
+    return usart_tx_busy[Usart];
+}
+
+uint32 Usart_GetBaud(uint8 Usart) {
+    return usart_baud[Usart];
+}
+
+static void Usart_DmaIrq(uint8 Usart) {
+    const Usart_Desc* U = &usart_map[Usart];
+    uint8 Flags = Dma_GetFlags(U->DmaController, U->DmaStream);
+    Dma_ClearFlags(U->DmaController, U->DmaStream, Flags);
+
+    // A transfer error disables the stream as well; either way it is over
+    if (Flags & (DMA_FLAG_TC | DMA_FLAG_TE)) {
+        usart_tx_busy[Usart] = 0;
+        if (usart_tx_done[Usart] != 0) {
+            usart_tx_done[Usart](Usart);
+        }
+    }
+}
+
+void DMA2_Stream7_IRQHandler(void) {
+    Usart_DmaIrq(USART_1);
+}
+
+void DMA1_Stream6_IRQHandler(void) {
+    Usart_DmaIrq(USART_2);
+}
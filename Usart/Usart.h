@@ -0,0 +1,33 @@
+/**
+ * Usart.h
+ *
+ *  Transmit-only USART driver; each frame goes out by DMA while the caller
+ *  carries on.
+ */
+
+#ifndef USART_H
+#define USART_H
+#include "Std_Types.h"
+
+#define USART_1             0
+#define USART_2             1
+#define USART_COUNT         2
+
+#define USART_OK            0x0
+#define USART_NOK           0x1
+
+// Called from the DMA interrupt once the last byte has been handed to the USART
+typedef void (*Usart_TxDoneFn)(uint8 Usart);
+
+// 8N1 at Baud from the bus clock; call after Rcc_Init
+uint8 Usart_Init(uint8 Usart, uint32 Baud, Usart_TxDoneFn TxDone);
+
+// Starts a DMA transfer of Data, which must stay untouched until TxDone.
+// Returns USART_NOK without waiting if a transfer is still running.
+uint8 Usart_WriteDma(uint8 Usart, const uint8* Data, uint16 Length);
+
+uint8 Usart_IsTxBusy(uint8 Usart);
+
+uint32 Usart_GetBaud(uint8 Usart);
+
+#endif /* USART_H */
@@ -0,0 +1,36 @@
+/**
+ * Usart_Private.h
+ *
+ *  USART register map.
+ */
+
+#ifndef USART_PRIVATE_H
+#define USART_PRIVATE_H
+#include "Std_Types.h"
+
+#define USART1_BASE_ADDR    0x40011000UL
+#define USART2_BASE_ADDR    0x40004400UL
+
+typedef struct
+{
+    volatile uint32 SR;
+    volatile uint32 DR;
+    volatile uint32 BRR;
+    volatile uint32 CR1;
+    volatile uint32 CR2;
+    volatile uint32 CR3;
+    volatile uint32 GTPR;
+} USART_Type;
+
+// USART_SR bits
+#define USART_SR_TC         6
+#define USART_SR_TXE        7
+
+// USART_CR1 bits
+#define USART_CR1_TE        3
+#define USART_CR1_UE        13
+
+// USART_CR3 bits
+#define USART_CR3_DMAT      7
+
+#endif /* USART_PRIVATE_H */
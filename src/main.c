@@ -6,43 +6,88 @@
 #include "lcd.h"
 #include "pwm.h"
 #include "EXTI.h"
+#include "EventQueue.h"
+#include "Speed.h"
+#include "SpeedFilter.h"
+#include "Gpio_Pins.h"
+#include "Time.h"
+#include "Pid.h"
+#include "Sched.h"
+#include "Power.h"
+#include "Telemetry.h"
+#include "Usart.h"
+#include <stddef.h>
 
-#define NUMBER_OF_CYCLES 1000000
 #define POTENTIOMETER_ADC_CHANNEL 10
+#define MOTOR_CURRENT_ADC_CHANNEL 11
+#define POTENTIOMETER_SAMPLE_RATE_HZ 1000
+#define POTENTIOMETER_EXTRA_BITS 2        // 16 samples -> 14 bits, ~60 Hz
+#define POTENTIOMETER_HYSTERESIS_PERMILLE 3
+#define MOTOR_CURRENT_TRIP_RAW 3600       // shunt amplifier output near full scale
+#define CONTROL_PERIOD_MS 5               // 200 Hz speed loop
+#define CONVEYOR_MAX_SPEED_MM_S 400       // pot full scale
+
+// Speed loop gains: PWM ticks per mm/s of error (ki per 5 ms tick) at a
+// 1000-tick period, scaled to the real period at init
+#define SPEED_KP_Q16 (2L << PID_Q)
+#define SPEED_KI_Q16 ((1L << PID_Q) / 20)
+#define SPEED_GAIN_PERIOD 1000L           // PWM period the gains were tuned at
+#define SPEED_SLEW_DIVISOR 50             // period/50 per tick: 0..100% in 250 ms
+#define MOTOR_RAMP_FULL_SCALE_MS 250      // S-curve time for a 0..100% setpoint step
+#define MOTOR_RAMP_MIN_STEP_MM_S 40       // setpoint jumps from here up go through the ramp
 #define DEBOUNCE_DELAY_MS 50
-
-#define IR_BUTTON_PORT GPIO_A
-#define IR_BUTTON_PIN  15
-
-#define EMERGENCY_STOP_PIN 8  // PA8
-#define RESET_BUTTON_PIN   9  // PA9
+#define ESTOP_LOCKOUT_MS 50               // stop on the first edge, ignore the bounces
+#define IR_SENSOR_DEBOUNCE_MS 5
+#define EXTI_PRIORITY_BUTTONS 1
+#define EXTI_PRIORITY_SENSORS 3
+#define INPUT_PERIOD_MS 1                 // 1 kHz events and capture
+#define CAPTURE_TIMEOUT_MS 10000
+#define LCD_REFRESH_PERIOD_MS 100         // 10 Hz display
+// SysTick is the only periodic wakeup, so releases sit on whole milliseconds;
+// display is offset to avoid landing on the same tick as control
+#define DISPLAY_OFFSET_MS 2
+#define TELEMETRY_USART USART_1           // TX on PB6
+#define TELEMETRY_BAUD 115200UL
+#define TELEMETRY_RATE_HZ 20
+#define TELEMETRY_OFFSET_MS 3
+
+// Belt encoder: one pulse per revolution of a 50 mm pulley
+#define CONVEYOR_PULSES_PER_REV 1
+#define CONVEYOR_PULLEY_CIRCUMFERENCE_UM 157080UL
+
+// EVENT_EMERGENCY_STOP data
+#define STOP_SOURCE_BUTTON 0
+#define STOP_SOURCE_OVERCURRENT 1
+
+PIN_DEF(IR_SENSOR, GPIO_A, 15)
+PIN_DEF(EMERGENCY_STOP, GPIO_A, 8)
+PIN_DEF(RESET_BUTTON, GPIO_A, 9)
+PIN_DEF(POTENTIOMETER, GPIO_C, 0)  // ADC channel 10
+PIN_DEF(MOTOR_CURRENT, GPIO_C, 1)  // ADC channel 11, shunt amplifier
+
+// Converted together on every trigger
+static const uint8_t adc_scan_channels[] = {
+    POTENTIOMETER_ADC_CHANNEL,
+    MOTOR_CURRENT_ADC_CHANNEL,
+    ADC_CHANNEL_TEMPSENSOR,
+    ADC_CHANNEL_VREFINT,
+};
 
 volatile uint8_t emergencyStop = 0;
-volatile uint32_t system_ms = 0;
-volatile uint8_t object_count = 0;
-volatile uint8_t object_detected = 0;  // Flag for interrupt-based detection
+volatile uint8_t stop_source = STOP_SOURCE_BUTTON;
+uint32_t object_count = 0;
+uint32_t object_drops_counted = 0;
 
 uint8_t duty = 0;
-float prev_voltage = -1.0f;
-uint8_t prev_duty = 0xFF;
-int prev_conv_speed = -1;
-uint8_t prev_object_count = 0xFF;
-
-// State machine for TimeCapture
-typedef enum {
-    CAPTURE_IDLE,
-    CAPTURE_WAITING_START,
-    CAPTURE_WAITING_END
-} capture_state_t;
-
-capture_state_t capture_state = CAPTURE_IDLE;
-uint32_t capture_timeout = 0;
-uint32_t last_speed_update = 0;
+ADC_Hysteresis_t setpoint_hysteresis = { .band_permille = POTENTIOMETER_HYSTERESIS_PERMILLE };
+int conv_speed = 0;
 
-void delay_millis(uint32_t delay) {
-    for (volatile uint32_t i = 0; i < (NUMBER_OF_CYCLES / 1000) * delay; i++);
-    system_ms += delay;
-}
+uint32_t last_speed_update = 0;
+SpeedFilter_t period_filter;
+uint32_t belt_speed_mm_s = 0;      // filtered feedback for the speed loop
+uint32_t speed_setpoint_mm_s = 0;
+uint32_t last_setpoint_mm_s = 0;   // 0 after boot and reset, so restarts ramp
+Pid_t speed_pid;
 
 void float_to_string(float value, char* buffer, uint8_t decimal_places) {
     int integer_part = (int)value;
@@ -102,84 +147,92 @@ void int_to_string_padded(int value, char* buffer, uint8_t width) {
     }
 }
 
+// The LCD_Update* helpers only draw into the shadow framebuffer;
+// LCD_Flush() sends whatever actually changed.
+void LCD_UpdateObjectCount(void) {
+    char count_str[4];
+    int_to_string_padded(object_count > 99 ? 99 : object_count, count_str, 2);
+    LCD_FbWrite(LCD_ROW_0, 13, count_str);
+}
+
+void LCD_UpdateConvSpeed(int speed) {
+    char conv_speed_buf[6];
+    conv_speed = speed > 9999 ? 9999 : speed;
+    int_to_string(conv_speed, conv_speed_buf);
+    LCD_FbFill(LCD_ROW_1, 5, 4, ' '); // Clear remaining space up to "Mot:"
+    LCD_FbWrite(LCD_ROW_1, 5, conv_speed_buf);
+}
+
+void LCD_UpdateMotorDuty(void) {
+    char duty_str[4];
+    int_to_string_padded(duty > 99 ? 99 : duty, duty_str, 2);
+    LCD_FbWrite(LCD_ROW_1, 13, duty_str);
+}
+
 void LCD_PrintStatus(void) {
-    LCD_SetCursor(LCD_ROW_0, 0);
     if (emergencyStop) {
-        LCD_PrintString("!!! EMERGENCY !!!");
-        LCD_SetCursor(LCD_ROW_1, 0);
-        LCD_PrintString("SYSTEM STOPPED  ");
+        LCD_FbWrite(LCD_ROW_0, 0, "!!! EMERGENCY !!");
+        LCD_FbWrite(LCD_ROW_1, 0, "SYSTEM STOPPED  ");
     } else {
-        LCD_PrintString("Object Count:   ");
-        LCD_SetCursor(LCD_ROW_1, 0);
-        LCD_PrintString("Conv:    Mot:  %"); // Shorter labels, more space
-
-        prev_conv_speed = -1;
-        prev_duty = 0xFF;
-        prev_object_count = 0xFF;
+        LCD_FbWrite(LCD_ROW_0, 0, "Object Count:   ");
+        LCD_FbWrite(LCD_ROW_1, 0, "Conv:    Mot:  %"); // Shorter labels, more space
+        LCD_UpdateObjectCount();
+        LCD_UpdateConvSpeed(conv_speed);
+        LCD_UpdateMotorDuty();
     }
 }
 
-void LCD_UpdateObjectCount(void) {
-    if (object_count != prev_object_count) {
-        char count_str[4];
-        int_to_string_padded(object_count > 99 ? 99 : object_count, count_str, 2);
-        LCD_SetCursor(LCD_ROW_0, 13);
-        LCD_PrintString(count_str);
-        prev_object_count = object_count;
+// OPTION 1: Interrupt-based IR sensor detection
+void IrSensor_OnEdge(uint8 LineNumber, void* Context) {
+    if (!emergencyStop) {
+        EventQueue_Push(EVENT_OBJECT_DETECTED, 0);
     }
 }
 
-void LCD_UpdateConvSpeed(int speed) {
-    if (speed != prev_conv_speed) {
-        char conv_speed_buf[6];
-        int_to_string(speed, conv_speed_buf);
-        LCD_SetCursor(LCD_ROW_1, 5); // Position after "C:"
-        LCD_PrintString("    "); // Clear remaining space up to "M:"
-        LCD_SetCursor(LCD_ROW_1, 5); // Position after "C:"
-        LCD_PrintString(conv_speed_buf);
-        prev_conv_speed = speed;
-    }
+// Shared stop path for the e-stop button and the current watchdog; runs
+// in interrupt context so every PWM output is cut before anything else happens
+void Conveyor_EmergencyStop(uint8_t source) {
+    PWM_Stop();
+    stop_source = source;
+    emergencyStop = 1;
+    LCD_PrintStatus();
+    EventQueue_Push(EVENT_EMERGENCY_STOP, source);
 }
 
-void LCD_UpdateMotorDuty(void) {
-    if (duty != prev_duty) {
-        char duty_str[4];
-        int_to_string_padded(duty > 99 ? 99 : duty, duty_str, 2);
-        LCD_SetCursor(LCD_ROW_1, 13);  // Position after "M:"
-        LCD_PrintString(duty_str);
-        prev_duty = duty;
-    }
+void MotorCurrent_Trip(uint8_t channel, uint16_t value) {
+    Conveyor_EmergencyStop(STOP_SOURCE_OVERCURRENT);
 }
 
-// OPTION 1: Interrupt-based IR sensor detection
-void EXTI15_10_IRQHandler(void) {
-    if (EXTI_REGISTERS->EXTI_PR & (1 << IR_BUTTON_PIN)) {
-        EXTI_ClearPending(IR_BUTTON_PIN);
-        if (!emergencyStop) {
-            object_detected = 1;  // Set flag instead of incrementing directly
-        }
-    }
+void EmergencyStop_OnEdge(uint8 LineNumber, void* Context) {
+    Conveyor_EmergencyStop(STOP_SOURCE_BUTTON);
 }
 
-void EXTI9_5_IRQHandler(void) {
-    if (EXTI_REGISTERS->EXTI_PR & (1 << EMERGENCY_STOP_PIN)) {
-        EXTI_ClearPending(EMERGENCY_STOP_PIN);
-        emergencyStop = 1;
-        PWM_SetDutyCycle(0);
+void ResetButton_OnEdge(uint8 LineNumber, void* Context) {
+    if (emergencyStop) {
+        emergencyStop = 0;
         LCD_PrintStatus();
+        EventQueue_Push(EVENT_RESET, 0);
     }
+}
 
-    if (EXTI_REGISTERS->EXTI_PR & (1 << RESET_BUTTON_PIN)) {
-        EXTI_ClearPending(RESET_BUTTON_PIN);
-        if (emergencyStop) {
-            emergencyStop = 0;
-            prev_voltage = -999.0f;
-            prev_duty = 0xFF;
-            prev_conv_speed = -1;
-            prev_object_count = 0xFF;
-            LCD_PrintStatus();
+// Drain the ISR event queue; objects whose events were dropped on
+// overflow are still counted from the queue's drop counter
+void ProcessEvents(void) {
+    Event event;
+    while (EventQueue_Pop(&event)) {
+        if (event.Type == EVENT_OBJECT_DETECTED) {
+            object_count++;
+        } else if (event.Type == EVENT_RESET) {
+            Pid_Reset(&speed_pid, 0);   // restart from standstill, no wound-up integral
+            last_setpoint_mm_s = 0;
+            PWM_Release();
+            ADC_RearmWatchdog();
         }
     }
+
+    uint32_t dropped = EventQueue_GetDropped(EVENT_OBJECT_DETECTED);
+    object_count += dropped - object_drops_counted;
+    object_drops_counted = dropped;
 }
 
 // OPTION 2: Non-blocking polling function
@@ -191,10 +244,10 @@ uint8 detect_falling_edge_nonblocking(uint8 button_port, uint8 button_pin) {
     uint8_t current_state = Gpio_ReadPin(button_port, button_pin);
 
     // Detect falling edge with debouncing
-    if (system_ms - last_change_time > DEBOUNCE_DELAY_MS) {
+    if (Time_Elapsed(last_change_time, DEBOUNCE_DELAY_MS + 1)) {
         if (previous_state == 1 && current_state == 0) {
             edge_detected = 1;
-            last_change_time = system_ms;
+            last_change_time = Time_GetMs();
         }
     }
 
@@ -208,112 +261,253 @@ uint8 detect_falling_edge_nonblocking(uint8 button_port, uint8 button_pin) {
     return 0;
 }
 
-// Non-blocking TimeCapture processing
-void ProcessTimeCaptureNonBlocking(void) {
-    switch (capture_state) {
-        case CAPTURE_IDLE:
-            TimeCapture_Start();
-            capture_state = CAPTURE_WAITING_START;
-            capture_timeout = 0;
-            break;
-
-        case CAPTURE_WAITING_START:
-            ProcessInputCapture();
-            capture_timeout++;
-
-            if (captureFlag) {
-                capture_state = CAPTURE_WAITING_END;
-                capture_timeout = 0;
-            } else if (capture_timeout > 10000) {  // Timeout after many iterations
-                capture_state = CAPTURE_IDLE;
-            }
-            break;
-
-        case CAPTURE_WAITING_END:
-            ProcessInputCapture();
-            capture_timeout++;
-
-            if (!captureFlag && period != 0) {
-                // Successfully captured period
-                int conv_speed = (int)(1000000.0/period);
-                LCD_UpdateConvSpeed(conv_speed);
-                last_speed_update = system_ms;
-                capture_state = CAPTURE_IDLE;
-            } else if (capture_timeout > 10000) {  // Timeout
-                capture_state = CAPTURE_IDLE;
-            }
-            break;
+// Fixed-rate PI step: pot setpoint vs. measured belt speed, output in
+// timer ticks. A large setpoint step (start-up, restart after a stop, a
+// big pot move) goes to the PWM ramp as an open-loop move to the duty that
+// speed needs; the PI holds the ramp's output and takes over when it
+// lands. Otherwise the slew-limited PI output is written directly, so the
+// TIM3 update interrupt is off in steady state. After an e-stop the PWM
+// ignores both until the reset is processed.
+void SpeedControl_Task(void) {
+    uint32_t period = PWM_GetPeriodTicks();
+    uint32_t step = speed_setpoint_mm_s > last_setpoint_mm_s
+                  ? speed_setpoint_mm_s - last_setpoint_mm_s
+                  : last_setpoint_mm_s - speed_setpoint_mm_s;
+    last_setpoint_mm_s = speed_setpoint_mm_s;
+    if (step >= MOTOR_RAMP_MIN_STEP_MM_S) {
+        PWM_RampTo(speed_setpoint_mm_s * period / CONVEYOR_MAX_SPEED_MM_S);
+    }
+
+    uint32_t compare;
+    if (PWM_IsRamping()) {
+        compare = PWM_GetRaw();
+        Pid_Reset(&speed_pid, (int32_t)compare);   // bumpless hand-back
+    } else {
+        compare = (uint32_t)Pid_Update(&speed_pid, (int32_t)speed_setpoint_mm_s,
+                                       (int32_t)belt_speed_mm_s);
+        PWM_SetRaw(compare);
+    }
+
+    uint8_t new_duty = (uint8_t)((compare * 100U) / period);
+    if (new_duty != duty) {
+        duty = new_duty;
+        LCD_UpdateMotorDuty();
+    }
+}
+
+// TimeCapture runs from its interrupt; only pick up new periods here
+void ProcessTimeCapture(void) {
+    uint32_t raw_period;
+    uint8_t updated = 0;
+
+    while (TimeCapture_ReadPeriod(&raw_period)) {
+        SpeedFilter_Update(&period_filter, raw_period);
+        updated = 1;
+    }
+
+    if (updated) {
+        uint32_t filtered = SpeedFilter_Get(&period_filter);
+        if (filtered != 0) {
+            belt_speed_mm_s = Speed_PeriodToMmPerSec(filtered);
+            LCD_UpdateConvSpeed((int)belt_speed_mm_s);  // mm/s
+            last_speed_update = Time_GetMs();
+        }
+    } else if (Time_Elapsed(last_speed_update, CAPTURE_TIMEOUT_MS)) {
+        // No edges: the belt has stopped
+        belt_speed_mm_s = 0;
+        LCD_UpdateConvSpeed(0);
+        SpeedFilter_Reset(&period_filter);
+        last_speed_update = Time_GetMs();
+    }
+}
+
+// Scheduler clock: Time_GetUs wraps modulo 2^32 like the scheduler expects
+static uint32_t Sched_Clock(void) {
+    return Time_GetUs();
+}
+
+void Input_Task(void) {
+    ProcessEvents();
+
+    if (!emergencyStop) {
+        // OPTION 2: Alternative - Non-blocking polling (comment out if using Option 1)
+        /*
+        if (detect_falling_edge_nonblocking(IR_SENSOR_PORT, IR_SENSOR_PIN)) {
+            object_count++;
+            LCD_UpdateObjectCount();
+        }
+        */
+
+        // Non-blocking conveyor speed measurement
+        ProcessTimeCapture();
+    }
+}
+
+void Control_Task(void) {
+    if (emergencyStop) {
+        return;
+    }
+
+    // Pot gives the speed setpoint; the PI loop owns the PWM
+    uint32_t setpoint;
+    ADC_PollDecimation();
+    if (ADC_GetDecimated(POTENTIOMETER_ADC_CHANNEL, &setpoint)) {
+        uint8_t percent = ADC_HysteresisPercent(&setpoint_hysteresis, setpoint,
+                                                ADC_DECIMATED_MAX(POTENTIOMETER_EXTRA_BITS));
+        speed_setpoint_mm_s = (uint32_t)percent * CONVEYOR_MAX_SPEED_MM_S / 100U;
     }
+
+    SpeedControl_Task();
+}
+
+static uint8 Idle_WorkPending(void) {
+    return !EventQueue_IsEmpty();
+}
+
+// Nothing due: sleep until SysTick, an EXTI edge, capture or ADC/DMA wakes us
+void Idle_Task(void) {
+    Power_Idle(Idle_WorkPending);
+}
+
+void Display_Task(void) {
+    if (!emergencyStop) {
+        LCD_UpdateObjectCount();
+    }
+    LCD_Flush();
+}
+
+void Telemetry_Task(void) {
+    Telemetry_Record record = {
+        .TimestampUs = Time_GetUs(),
+        .ObjectCount = object_count,
+        .PeriodTicks = SpeedFilter_Get(&period_filter),
+        .SpeedMmS = (uint16)belt_speed_mm_s,
+        .Duty = (uint16)PWM_GetRaw(),
+        .AdcRaw = ADC_GetChannelLatest(POTENTIOMETER_ADC_CHANNEL),
+        .Faults = 0,
+    };
+
+    if (emergencyStop) {
+        record.Faults |= (stop_source == STOP_SOURCE_OVERCURRENT) ? TELEMETRY_FAULT_OVERCURRENT
+                                                                  : TELEMETRY_FAULT_ESTOP;
+    }
+    if (object_drops_counted != 0) {
+        record.Faults |= TELEMETRY_FAULT_EVENTS_DROPPED;
+    }
+    if (belt_speed_mm_s == 0 && record.Duty != 0) {
+        record.Faults |= TELEMETRY_FAULT_BELT_STALLED;
+    }
+
+    Telemetry_Publish(&record);
 }
 
 int main(void) {
     Rcc_Init();
+    Time_Init();
     Rcc_Enable(RCC_GPIOA);
     Rcc_Enable(RCC_GPIOB);
     Rcc_Enable(RCC_GPIOC);
     Rcc_Enable(RCC_SYSCFG);
     Rcc_Enable(RCC_ADC1);
 
-    Gpio_Init(GPIO_C, 0, GPIO_ANALOG, GPIO_NO_PULL_DOWN); // PC0 - ADC
+    PIN_INIT(POTENTIOMETER, GPIO_ANALOG, GPIO_NO_PULL_DOWN);
+    PIN_INIT(MOTOR_CURRENT, GPIO_ANALOG, GPIO_NO_PULL_DOWN);
     Gpio_Init(GPIO_B, 0, GPIO_OUTPUT, GPIO_PUSH_PULL);    // PB0 - PWM output
-    Gpio_Init(GPIO_A, EMERGENCY_STOP_PIN, GPIO_INPUT, GPIO_PULL_UP);
-    Gpio_Init(GPIO_A, RESET_BUTTON_PIN, GPIO_INPUT, GPIO_PULL_UP);
-    Gpio_Init(GPIO_A, IR_BUTTON_PIN, GPIO_INPUT, GPIO_PULL_UP);  // IR sensor
+    PIN_INIT(EMERGENCY_STOP, GPIO_INPUT, GPIO_PULL_UP);
+    PIN_INIT(RESET_BUTTON, GPIO_INPUT, GPIO_PULL_UP);
+    PIN_INIT(IR_SENSOR, GPIO_INPUT, GPIO_PULL_UP);  // IR sensor
 
     LCD_Init();
     PWM_Init();
     ADC_Init();
+
+    // Per-channel sample times only (software start); ADC_ConfigureScan
+    // below then samples both channels at a fixed rate in the background
+    ADC_Config_t adc_config = {
+        .channel = POTENTIOMETER_ADC_CHANNEL,
+        .sampling_time = 0x4,   // 84 cycles
+        .continuous_mode = false,
+        .trigger_rate_hz = 0,
+    };
+    ADC_Configure(&adc_config);
+    adc_config.channel = MOTOR_CURRENT_ADC_CHANNEL;
+    ADC_Configure(&adc_config);
+    ADC_ConfigureScan(adc_scan_channels, sizeof(adc_scan_channels), POTENTIOMETER_SAMPLE_RATE_HZ);
+    ADC_EnableDecimation(POTENTIOMETER_ADC_CHANNEL, POTENTIOMETER_EXTRA_BITS);
+
+    Pid_Config_t speed_pid_config = {
+        .kp_q16 = (int32_t)(SPEED_KP_Q16 * (int32_t)PWM_GetPeriodTicks() / SPEED_GAIN_PERIOD),
+        .ki_q16 = (int32_t)(SPEED_KI_Q16 * (int32_t)PWM_GetPeriodTicks() / SPEED_GAIN_PERIOD),
+        .kd_q16 = 0,
+        .out_min = 0,
+        .out_max = (int32_t)PWM_GetPeriodTicks(),
+        .slew_max = (int32_t)(PWM_GetPeriodTicks() / SPEED_SLEW_DIVISOR),
+    };
+    Pid_Init(&speed_pid, &speed_pid_config);
+    PWM_ConfigureRamp(MOTOR_RAMP_FULL_SCALE_MS, PWM_RAMP_SCURVE);
+
+    ADC_Watchdog_Config_t current_guard = {
+        .channel = MOTOR_CURRENT_ADC_CHANNEL,
+        .low = 0,
+        .high = MOTOR_CURRENT_TRIP_RAW,
+        .on_trip = MotorCurrent_Trip,
+    };
+    ADC_ConfigureWatchdog(&current_guard);
     TimeCapture_Init();
 
-    // Setup interrupts
-    EXTI_Init(GPIO_A, EMERGENCY_STOP_PIN, FALLING_EDGE_TRIGGERED);
-    EXTI_Init(GPIO_A, RESET_BUTTON_PIN, FALLING_EDGE_TRIGGERED);
+    Speed_Config_t speed_config = {
+        .tick_hz = TimeCapture_GetTickHz(),
+        .pulses_per_rev = CONVEYOR_PULSES_PER_REV,
+        .circumference_um = CONVEYOR_PULLEY_CIRCUMFERENCE_UM,
+    };
+    Speed_Init(&speed_config);
+
+    // Median of 5 with a guard against single jittery edges
+    SpeedFilter_Config_t filter_config = {
+        .mode = SPEED_FILTER_MEDIAN,
+        .window = 5,
+        .outlier_pct = 25,
+        .outlier_max_run = 3,
+    };
+    SpeedFilter_Init(&period_filter, &filter_config);
+
+    // Setup interrupts; the buttons share the EXTI9_5 vector and outrank
+    // the IR sensor. Debounced (trailing) callbacks come from TIM9, which
+    // would otherwise sit at priority 0 above both.
+    EXTI_SetPriority(EMERGENCY_STOP_PIN, EXTI_PRIORITY_BUTTONS);
+    EXTI_SetPriority(IR_SENSOR_PIN, EXTI_PRIORITY_SENSORS);
+    EXTI_SetDebouncePriority(EXTI_PRIORITY_BUTTONS);
+    EXTI_Register(EMERGENCY_STOP_PIN, EMERGENCY_STOP_PORT, FALLING_EDGE_TRIGGERED,
+                  EmergencyStop_OnEdge, NULL);
+    EXTI_Register(RESET_BUTTON_PIN, RESET_BUTTON_PORT, FALLING_EDGE_TRIGGERED,
+                  ResetButton_OnEdge, NULL);
 
     // OPTION 1: Enable interrupt for IR sensor (recommended)
-    EXTI_Init(GPIO_A, IR_BUTTON_PIN, FALLING_EDGE_TRIGGERED);
-    EXTI_Enable(IR_BUTTON_PIN);
-    NVIC->ISER[1] = (1 << (EXTI15_10_IRQn - 32));  // Enable EXTI15_10 interrupt
+    EXTI_Register(IR_SENSOR_PIN, IR_SENSOR_PORT, FALLING_EDGE_TRIGGERED,
+                  IrSensor_OnEdge, NULL);
 
-    EXTI_Enable(EMERGENCY_STOP_PIN);
-    EXTI_Enable(RESET_BUTTON_PIN);
-    NVIC->ISER[0] = (1 << EXTI9_5_IRQn);
+    EXTI_SetDebounce(EMERGENCY_STOP_PIN, EXTI_DEBOUNCE_LEADING, ESTOP_LOCKOUT_MS);
+    EXTI_SetDebounce(RESET_BUTTON_PIN, EXTI_DEBOUNCE_TRAILING, DEBOUNCE_DELAY_MS);
+    EXTI_SetDebounce(IR_SENSOR_PIN, EXTI_DEBOUNCE_TRAILING, IR_SENSOR_DEBOUNCE_MS);
 
     LCD_PrintStatus();
 
-    while (1) {
-        if (!emergencyStop) {
-            // OPTION 1: Handle interrupt-based object detection
-            if (object_detected) {
-                object_detected = 0;  // Clear flag
-                object_count++;
-                LCD_UpdateObjectCount();
-            }
-
-            // OPTION 2: Alternative - Non-blocking polling (comment out if using Option 1)
-            /*
-            if (detect_falling_edge_nonblocking(IR_BUTTON_PORT, IR_BUTTON_PIN)) {
-                object_count++;
-                LCD_UpdateObjectCount();
-            }
-            */
-
-            // Non-blocking conveyor speed measurement
-            ProcessTimeCaptureNonBlocking();
-
-            // ADC and PWM processing (fast, non-blocking)
-            uint16_t raw_value = ADC_ReadBlocking(POTENTIOMETER_ADC_CHANNEL);
-            if (raw_value > 4095) raw_value = 4095;
-
-            duty = (uint8_t)((raw_value * 100.0f) / 4095.0f);
-            PWM_SetDutyCycle(duty);
-            LCD_UpdateMotorDuty();
-
-            // Update object count display regularly
-            LCD_UpdateObjectCount();
-        }
+    Power_Init();
+
+    // Releases on the SysTick grid, so the tick that wakes the core finds
+    // the task due rather than a few microseconds short
+    Sched_Init(Sched_Clock);
+    Sched_SetEpoch(Time_GetMs() * 1000UL);
+    Sched_SetIdleHook(Idle_Task);
+    Sched_AddTask("input", Input_Task, INPUT_PERIOD_MS * 1000UL, 0);
+    Sched_AddTask("control", Control_Task, CONTROL_PERIOD_MS * 1000UL, 0);
+    Sched_AddTask("display", Display_Task, LCD_REFRESH_PERIOD_MS * 1000UL, DISPLAY_OFFSET_MS * 1000UL);
+    if (Telemetry_Init(TELEMETRY_USART, TELEMETRY_BAUD, TELEMETRY_RATE_HZ) == TELEMETRY_OK) {
+        Sched_AddTask("telemetry", Telemetry_Task, 1000000UL / TELEMETRY_RATE_HZ, TELEMETRY_OFFSET_MS * 1000UL);
+    }
 
-        // Very small delay to prevent CPU hogging
-        delay_millis(1);
+    while (1) {
+        Sched_RunOnce();
     }
 
     return 0;
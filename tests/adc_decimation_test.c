@@ -0,0 +1,204 @@
+/**
+ * adc_decimation_test.c
+ *
+ *  Replays noisy potentiometer streams through the ADC decimator and the
+ *  percentage hysteresis, with the same scan, rate and control period as
+ *  main.c. A simulated DMA stream writes one scan frame per millisecond
+ *  into the circular buffer; the control step polls every 10 ms. Counts
+ *  how often the setpoint percentage changes (each change is a PWM
+ *  retarget and an LCD redraw) against the old single-sample reading, and
+ *  checks that a real sweep is still followed.
+ *
+ *    gcc -std=gnu11 -Wno-pointer-to-int-cast -Itests/stubs -IAdc -IDma -IRcc -IIrq \
+ *        -o adc_decimation_test tests/adc_decimation_test.c && ./adc_decimation_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "adc.h"
+#include "Irq.h"
+
+static ADC_TypeDef host_adc;
+static ADC_Common_TypeDef host_adc_common;
+static ADC_TIM_TypeDef host_tim5;
+Irq_NvicRegs irq_host_nvic;
+
+#undef ADC1
+#undef ADC_COMMON
+#undef ADC_TRIGGER_TIM
+#define ADC1 (&host_adc)
+#define ADC_COMMON (&host_adc_common)
+#define ADC_TRIGGER_TIM (&host_tim5)
+
+#include "../Adc/Adc.c"
+
+static uint16 host_ndtr;
+
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config) {
+    (void)Controller; (void)Stream; (void)Config;
+}
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count) {
+    (void)Controller; (void)Stream; (void)PeriphAddr; (void)MemAddr;
+    host_ndtr = Count;
+}
+void Dma_Stop(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; }
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream) {
+    (void)Controller; (void)Stream;
+    return host_ndtr;
+}
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetPclk2Hz(void) { return 84000000UL; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// Same setup as main.c
+#define POT_CHANNEL         10
+#define CURRENT_CHANNEL     11
+#define EXTRA_BITS          2
+#define HYSTERESIS_PERMILLE 3
+#define FRAMES_PER_STEP     10      // 1 kHz frames, 10 ms control step
+
+static const uint8_t scan[] = { POT_CHANNEL, CURRENT_CHANNEL, ADC_CHANNEL_TEMPSENSOR, ADC_CHANNEL_VREFINT };
+#define SCAN_COUNT (sizeof(scan) / sizeof(scan[0]))
+
+static uint32_t lcg_state = 1;
+
+// Roughly Gaussian: sum of four uniforms, +-amplitude
+static int32_t Noise(int32_t amplitude) {
+    int32_t sum = 0;
+    for (int i = 0; i < 4; i++) {
+        lcg_state = lcg_state * 1664525UL + 1013904223UL;
+        sum += (int32_t)((lcg_state >> 16) % (uint32_t)(2 * amplitude + 1)) - amplitude;
+    }
+    return sum / 2;
+}
+
+static uint16_t Clamp(int32_t raw) {
+    return (uint16_t)(raw < 0 ? 0 : raw > ADC_MAX_VALUE ? ADC_MAX_VALUE : raw);
+}
+
+// DMA writes one frame per trigger
+static void DmaFrame(uint16_t pot) {
+    uint32_t pos = adc_dma_length - host_ndtr;
+    adc_dma_buffer[pos + 0] = pot;
+    adc_dma_buffer[pos + 1] = 200;
+    adc_dma_buffer[pos + 2] = 950;
+    adc_dma_buffer[pos + 3] = 1500;
+    host_ndtr -= SCAN_COUNT;
+    if (host_ndtr == 0) {
+        host_ndtr = adc_dma_length;
+    }
+}
+
+typedef struct {
+    unsigned changes;
+    uint8_t percent;
+} Output;
+
+typedef int32_t (*PotTrace)(uint32_t ms);
+
+// Runs `ms` of trace through the old path (one raw sample per step) and
+// the new one (decimated + hysteresis); returns how often each changed
+static void Replay(const char *name, PotTrace trace, uint32_t ms, int32_t noise,
+                   Output *old_out, Output *new_out, uint8_t *track_error) {
+    ADC_Hysteresis_t hyst = { .band_permille = HYSTERESIS_PERMILLE };
+    *old_out = (Output){ 0, 0xFF };
+    *new_out = (Output){ 0, 0xFF };
+    *track_error = 0;
+    ADC_EnableDecimation(POT_CHANNEL, EXTRA_BITS);   // drop the previous trace's partial sum
+
+    for (uint32_t t = 0; t < ms; t++) {
+        DmaFrame(Clamp(trace(t) + Noise(noise)));
+        if (t % FRAMES_PER_STEP != FRAMES_PER_STEP - 1) {
+            continue;
+        }
+
+        uint8_t old_percent = ADC_RawToPercentage(ADC_GetChannelLatest(POT_CHANNEL));
+        if (old_percent != old_out->percent) {
+            old_out->changes += (old_out->percent != 0xFF);
+            old_out->percent = old_percent;
+        }
+
+        uint32_t value;
+        ADC_PollDecimation();
+        if (ADC_GetDecimated(POT_CHANNEL, &value)) {
+            uint8_t percent = ADC_HysteresisPercent(&hyst, value, ADC_DECIMATED_MAX(EXTRA_BITS));
+            if (percent != new_out->percent) {
+                new_out->changes += (new_out->percent != 0xFF);
+                new_out->percent = percent;
+            }
+
+            // Lag behind the noiseless input, after the first 100 ms
+            int32_t truth = (trace(t) * 100 + ADC_MAX_VALUE / 2) / ADC_MAX_VALUE;
+            int32_t error = abs((int32_t)percent - truth);
+            if (t > 100 && error > *track_error) {
+                *track_error = (uint8_t)error;
+            }
+        }
+    }
+
+    printf("%-28s setpoint changes: single sample %5u, decimated+hysteresis %4u; worst lag %u%%\n",
+           name, old_out->changes, new_out->changes, *track_error);
+}
+
+// The old reading truncated, the new one rounds, so their boundaries differ
+static int32_t SteadyOnTruncation(uint32_t ms) { (void)ms; return 2048; }   // 49/50% truncated
+static int32_t SteadyOnRounding(uint32_t ms) { (void)ms; return 2068; }     // 50/51% rounded
+static int32_t SteadyMid(uint32_t ms) { (void)ms; return 1249; }            // 30.5% either way
+static int32_t Sweep(uint32_t ms) {
+    return (ms >= 10000) ? ADC_MAX_VALUE : (int32_t)((uint64_t)ms * ADC_MAX_VALUE / 10000U);
+}
+
+static void TestDecimatorMath(void) {
+    uint32_t value;
+    // Polled every 8 frames; a full lap of the buffer between polls is too late
+    for (unsigned i = 0; i < 16; i++) {
+        DmaFrame(1000 + (i & 3));       // sum 16 * 1000 + 4 * (0 + 1 + 2 + 3)
+        if (i % 8 == 7) {
+            ADC_PollDecimation();
+        }
+    }
+    CHECK(ADC_GetDecimated(POT_CHANNEL, &value), "no decimated value after 16 frames");
+    CHECK(value == (16UL * 1000 + 24) >> EXTRA_BITS, "decimated %lu, expected %lu", (unsigned long)value,
+          (unsigned long)((16UL * 1000 + 24) >> EXTRA_BITS));
+    CHECK(!ADC_GetDecimated(CURRENT_CHANNEL, &value), "decimation reported on a channel it is off for");
+}
+
+int main(void) {
+    ADC_Init();
+    CHECK(ADC_ConfigureScan(scan, SCAN_COUNT, 1000) == ADC_OK, "scan setup failed");
+    CHECK(ADC_EnableDecimation(POT_CHANNEL, EXTRA_BITS) == ADC_OK, "decimation setup failed");
+
+    TestDecimatorMath();
+
+    Output old_out, new_out;
+    uint8_t lag;
+
+    Replay("steady on a truncation edge", SteadyOnTruncation, 60000, 8, &old_out, &new_out, &lag);
+    CHECK(old_out.changes >= 1000, "noise too weak to exercise the filter: %u old changes", old_out.changes);
+    CHECK(new_out.changes * 10 <= old_out.changes, "only %u -> %u changes", old_out.changes, new_out.changes);
+
+    Replay("steady on a rounding edge", SteadyOnRounding, 60000, 8, &old_out, &new_out, &lag);
+    CHECK(new_out.changes <= 2, "setpoint still flaps: %u changes in a minute", new_out.changes);
+
+    Replay("steady inside a 1% step", SteadyMid, 60000, 8, &old_out, &new_out, &lag);
+    CHECK(new_out.changes == 0, "setpoint moved %u times", new_out.changes);
+
+    Replay("0-100% sweep over 10 s", Sweep, 10500, 8, &old_out, &new_out, &lag);
+    CHECK(new_out.percent == 100, "sweep ended at %u%%", new_out.percent);
+    CHECK(lag <= 2, "decimated setpoint lagged the pot by %u%%", lag);
+    CHECK(new_out.changes >= 95 && new_out.changes <= 110, "%u changes over a 100-step sweep", new_out.changes);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
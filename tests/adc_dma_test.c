@@ -0,0 +1,180 @@
+/**
+ * adc_dma_test.c
+ *
+ *  Register/DMA mock test for timer-triggered ADC sampling. ADC1, the ADC
+ *  common block and TIM5 are test-owned structs; the DMA driver is stubbed
+ *  and records what it was asked to do, with a settable NDTR standing in
+ *  for the stream's progress. Checks the trigger and DMA setup, the
+ *  latest/average readers against the circular buffer, overrun recovery
+ *  and stopping.
+ *
+ *    gcc -std=gnu11 -Wno-pointer-to-int-cast -Itests/stubs -IAdc -IDma -IRcc -IIrq \
+ *        -o adc_dma_test tests/adc_dma_test.c && ./adc_dma_test
+ */
+
+#include <stdio.h>
+
+#include "adc.h"
+#include "Irq.h"
+
+static ADC_TypeDef host_adc;
+static ADC_Common_TypeDef host_adc_common;
+static ADC_TIM_TypeDef host_tim5;
+Irq_NvicRegs irq_host_nvic;
+
+#undef ADC1
+#undef ADC_COMMON
+#undef ADC_TRIGGER_TIM
+#define ADC1 (&host_adc)
+#define ADC_COMMON (&host_adc_common)
+#define ADC_TRIGGER_TIM (&host_tim5)
+
+#include "../Adc/Adc.c"
+
+static Dma_Config dma_config;
+static uint32 dma_periph;
+static uint32 dma_mem;
+static uint16 dma_count;
+static uint16 host_ndtr;
+static int dma_starts;
+static int dma_running;
+
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config) {
+    (void)Controller; (void)Stream;
+    dma_config = *Config;
+}
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count) {
+    (void)Controller; (void)Stream;
+    dma_periph = PeriphAddr;
+    dma_mem = MemAddr;
+    dma_count = Count;
+    host_ndtr = Count;
+    dma_starts++;
+    dma_running = 1;
+}
+void Dma_Stop(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; dma_running = 0; }
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream) {
+    (void)Controller; (void)Stream;
+    return host_ndtr;
+}
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetPclk2Hz(void) { return 84000000UL; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define POT_CHANNEL 10
+
+static void TestPrescaler(void) {
+    // PCLK2 = 84 MHz: /2 is 42 MHz, too fast; /4 is the smallest in spec
+    CHECK(((host_adc_common.CCR & ADC_CCR_ADCPRE) >> ADC_CCR_ADCPRE_Pos) == 1, "ADCPRE = %lu",
+          (unsigned long)((host_adc_common.CCR & ADC_CCR_ADCPRE) >> ADC_CCR_ADCPRE_Pos));
+}
+
+static void TestTriggeredSetup(void) {
+    ADC_Config_t config = {
+        .channel = POT_CHANNEL,
+        .sampling_time = 0x4,
+        .continuous_mode = true,
+        .trigger_rate_hz = 1000,
+    };
+    CHECK(ADC_Configure(&config) == ADC_OK, "triggered configure failed");
+
+    uint32_t cr2 = host_adc.CR2;
+    CHECK(!(cr2 & ADC_CR2_CONT), "CONT left on, the timer should pace conversions");
+    CHECK((cr2 & (ADC_CR2_DMA | ADC_CR2_DDS)) == (ADC_CR2_DMA | ADC_CR2_DDS), "DMA/DDS not set");
+    CHECK((cr2 & ADC_CR2_EXTSEL) == ADC_CR2_EXTSEL_TIM5_CC1, "trigger is not TIM5 CC1");
+    CHECK((cr2 & ADC_CR2_EXTEN) == ADC_CR2_EXTEN_RISING, "trigger edge not rising");
+    CHECK(((host_adc.SMPR1 >> 0) & 0x7) == 0x4, "sample time not applied to channel 10");
+    CHECK((host_adc.SQR3 & ADC_SQR3_SQ1) == POT_CHANNEL, "SQ1 = %lu", (unsigned long)(host_adc.SQR3 & ADC_SQR3_SQ1));
+    CHECK((host_adc.SQR1 & ADC_SQR1_L) == 0, "sequence longer than one conversion");
+
+    // 1 MHz ticks, 1000 per trigger
+    CHECK(host_tim5.PSC == 83, "TIM5 PSC = %lu", (unsigned long)host_tim5.PSC);
+    CHECK(host_tim5.ARR == 999, "TIM5 ARR = %lu", (unsigned long)host_tim5.ARR);
+    CHECK(host_tim5.CCR1 == 500, "TIM5 CCR1 = %lu", (unsigned long)host_tim5.CCR1);
+    CHECK(host_tim5.CCMR1 == ADC_TIM_CCMR1_OC1M_PWM1 && host_tim5.CCER == ADC_TIM_CCER_CC1E,
+          "TIM5 CC1 not in PWM mode");
+    CHECK(host_tim5.CR1 & ADC_TIM_CR1_CEN, "TIM5 not running");
+
+    CHECK(dma_running && dma_starts == 1, "DMA started %d times", dma_starts);
+    CHECK(dma_config.Direction == DMA_PERIPH_TO_MEM && dma_config.DataSize == DMA_SIZE_16 &&
+          dma_config.Circular && dma_config.MemIncrement && dma_config.Channel == ADC_DMA_CHANNEL,
+          "DMA stream not a circular 16-bit peripheral-to-memory transfer");
+    CHECK(dma_periph == (uint32)(uintptr_t)&host_adc.DR, "DMA not reading ADC1->DR");
+    CHECK(dma_mem == (uint32)(uintptr_t)adc_dma_buffer, "DMA not writing the sample buffer");
+    CHECK(dma_count == ADC_SCAN_DEPTH, "DMA count %u", dma_count);
+
+    ADC_Config_t too_fast = config;
+    too_fast.trigger_rate_hz = 600000;
+    CHECK(ADC_Configure(&too_fast) == ADC_ERROR, "rate above the trigger tick accepted");
+    CHECK(ADC_Configure(&config) == ADC_OK, "reconfigure failed");
+}
+
+static void TestReaders(void) {
+    for (unsigned i = 0; i < ADC_SCAN_DEPTH; i++) {
+        adc_dma_buffer[i] = (uint16_t)(1000 + i);
+    }
+
+    // DMA is writing slot 6, so slot 5 is the newest complete sample
+    host_ndtr = ADC_SCAN_DEPTH - 6;
+    CHECK(ADC_GetLatest() == 1005, "latest %u, expected 1005", ADC_GetLatest());
+    CHECK(ADC_ReadBlocking(POT_CHANNEL) == 1005, "ReadBlocking did not return the DMA sample");
+    CHECK(!(host_adc.CR2 & ADC_CR2_SWSTART), "ReadBlocking started a software conversion");
+
+    // Just wrapped: the newest sample is the last slot
+    host_ndtr = ADC_SCAN_DEPTH;
+    CHECK(ADC_GetLatest() == 1000 + ADC_SCAN_DEPTH - 1, "latest after wrap %u", ADC_GetLatest());
+
+    // Mean of 1000..1015 is 1007.5, rounded up
+    CHECK(ADC_GetAverage() == 1008, "average %u, expected 1008", ADC_GetAverage());
+
+    // Bits above the 12-bit result are masked
+    adc_dma_buffer[ADC_SCAN_DEPTH - 1] = 0xF123;
+    CHECK(ADC_GetLatest() == 0x123, "latest %u not masked to 12 bits", ADC_GetLatest());
+}
+
+static void TestOverrunRecovery(void) {
+    int starts = dma_starts;
+    host_adc.SR = ADC_SR_OVR;
+    host_ndtr = 3;
+
+    ADC_GetLatest();
+    CHECK(dma_starts == starts + 1, "overrun did not restart DMA");
+    CHECK(!(host_adc.SR & ADC_SR_OVR), "OVR not cleared");
+    CHECK(host_adc.CR2 & ADC_CR2_DMA, "DMA request bit left off");
+    CHECK(host_ndtr == ADC_SCAN_DEPTH, "DMA not restarted at the top of the buffer");
+
+    host_adc.SR = 0;
+    starts = dma_starts;
+    ADC_GetLatest();
+    CHECK(dma_starts == starts, "DMA restarted without an overrun");
+}
+
+static void TestStop(void) {
+    ADC_StopTriggered();
+    CHECK(!(host_tim5.CR1 & ADC_TIM_CR1_CEN), "TIM5 still running");
+    CHECK(!(host_adc.CR2 & (ADC_CR2_DMA | ADC_CR2_DDS | ADC_CR2_EXTEN)), "ADC still triggered/DMA");
+    CHECK(!dma_running, "DMA stream still enabled");
+    CHECK(ADC_GetLatest() == 0 && ADC_GetAverage() == 0, "readers return stale DMA data after stop");
+}
+
+int main(void) {
+    CHECK(ADC_Init() == ADC_OK, "init failed");
+    TestPrescaler();
+    TestTriggeredSetup();
+    TestReaders();
+    TestOverrunRecovery();
+    TestStop();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
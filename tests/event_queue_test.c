@@ -0,0 +1,128 @@
+/**
+ * event_queue_test.c
+ *
+ *  Host stress test for the ISR-to-main event queue. SIGALRM stands in
+ *  for the EXTI interrupt: it preempts the consumer at arbitrary points
+ *  and pushes bursts of object events, while the main loop drains them
+ *  with the same accounting as ProcessEvents. Every push attempt must end
+ *  up either popped or in the drop counter, in order and exactly once.
+ *
+ *    gcc -std=gnu11 -O2 -Itests/stubs -IEvent -ITime -IIrq \
+ *        -o event_queue_test tests/event_queue_test.c Event/EventQueue.c && ./event_queue_test
+ */
+
+#include <signal.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "EventQueue.h"
+#include "Time.h"
+
+#define TEST_EVENTS         500000UL    // push attempts before the producer stops
+#define TEST_TIMER_US       20          // "interrupt" period
+
+static volatile uint32 push_attempts = 0;
+static volatile uint32 isr_bursts = 0;
+static volatile sig_atomic_t producing = 1;
+
+// EventQueue_Push stamps each attempt, dropped or not, so the timestamp
+// doubles as the producer's sequence number
+uint32 Time_GetUs(void) {
+    return ++push_attempts;
+}
+
+static void Isr(int sig) {
+    (void)sig;
+    if (!producing) {
+        return;
+    }
+    // Bursts of 1-8, like several IR edges landing before main runs
+    uint32 burst = (isr_bursts++ % 8U) + 1U;
+    for (uint32 i = 0; i < burst; i++) {
+        EventQueue_Push(EVENT_OBJECT_DETECTED, (uint8)i);
+    }
+    if (push_attempts >= TEST_EVENTS) {
+        producing = 0;
+    }
+}
+
+int main(void) {
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = Isr;
+    sigaction(SIGALRM, &sa, NULL);
+
+    struct itimerval timer = {
+        .it_interval = { 0, TEST_TIMER_US },
+        .it_value = { 0, TEST_TIMER_US },
+    };
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    uint32 object_count = 0;
+    uint32 drops_counted = 0;
+    uint32 popped = 0;
+    uint32 last_stamp = 0;
+    uint32 order_errors = 0;
+    uint32 loops = 0;
+
+    for (;;) {
+        uint8 done = !producing;   // sampled before the final drain
+        Event event;
+
+        while (EventQueue_Pop(&event)) {
+            if (event.Timestamp <= last_stamp) {
+                order_errors++;
+            }
+            last_stamp = event.Timestamp;
+            popped++;
+            object_count++;
+        }
+
+        // Same catch-up as main.c: dropped objects are still counted
+        uint32 dropped = EventQueue_GetDropped(EVENT_OBJECT_DETECTED);
+        object_count += dropped - drops_counted;
+        drops_counted = dropped;
+
+        if (done) {
+            break;
+        }
+
+        // A slow loop iteration now and then, so the queue overflows
+        if (++loops % 64U == 0) {
+            for (volatile uint32 spin = 0; spin < 20000U; spin++) {
+            }
+        }
+    }
+
+    timer.it_interval.tv_usec = 0;
+    timer.it_value.tv_usec = 0;
+    setitimer(ITIMER_REAL, &timer, NULL);
+
+    printf("%u pushes in %u interrupts: %u popped, %u dropped and counted, %u counted in total\n",
+           push_attempts, isr_bursts, popped, drops_counted, object_count);
+
+    int failures = 0;
+    if (object_count != push_attempts) {
+        printf("FAIL: %u objects counted for %u edges\n", object_count, push_attempts);
+        failures++;
+    }
+    if (popped + drops_counted != push_attempts) {
+        printf("FAIL: popped + dropped = %u, expected %u\n", popped + drops_counted, push_attempts);
+        failures++;
+    }
+    if (order_errors != 0) {
+        printf("FAIL: %u events out of order or duplicated\n", order_errors);
+        failures++;
+    }
+    if (drops_counted == 0 || popped == 0) {
+        printf("FAIL: the run never exercised %s\n", popped == 0 ? "the consumer" : "overflow");
+        failures++;
+    }
+
+    if (failures) {
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,298 @@
+/**
+ * exti_debounce_test.c
+ *
+ *  Host simulation of the EXTI debounce engine under bouncing inputs. The
+ *  EXTI block, SYSCFG, TIM9 and the NVIC are test-owned structs. The test
+ *  steps time in TIM9 ticks (0.1 ms): scripted pin levels raise EXTI_PR on
+ *  their selected edges (masked or not, as the hardware does), an unmasked
+ *  pending line enters its vector handler, and TIM9 enters its compare
+ *  interrupt when CNT reaches CCR1 with CC1IE on. Checks that contact
+ *  bounce and glitches shorter than the window publish nothing extra,
+ *  that trailing callbacks land one window after the first edge and only
+ *  if the level is still active, that leading callbacks fire at once and
+ *  then lock out, and that lines with different windows share the timer
+ *  without delaying each other.
+ *
+ *    gcc -std=gnu11 -O2 -Itests/stubs -IEXTI -IGpio -IRcc -IIrq \
+ *        -o exti_debounce_test tests/exti_debounce_test.c && ./exti_debounce_test
+ */
+
+#include <stdio.h>
+
+#include "EXTI.h"
+#include "EXTI_Private.h"
+#include "Irq.h"
+
+static EXTI_Type host_exti;
+static EXTI_DebounceTimer host_tim9;
+static SYSCFG_EXTILineConfig host_syscfg;
+Irq_NvicRegs irq_host_nvic;
+
+#undef EXTI_REGISTERS
+#undef EXTI_DEBOUNCE_TIM
+#define EXTI_REGISTERS (&host_exti)
+#define EXTI_DEBOUNCE_TIM (&host_tim9)
+
+#include "../EXTI/EXTI.c"
+
+// Pin levels, one bit per line (all on port A here)
+static uint32 host_levels = 0xFFFF;
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+uint8 Gpio_ReadPin(uint8 PortName, uint8 PinNumber) {
+    (void)PortName;
+    return (uint8)((host_levels >> PinNumber) & 1);
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// main.c's windows; the e-stop and reset button sit on PA8/PA9
+#define ESTOP_LINE 8
+#define RESET_LINE 9
+#define SENSOR_LINE 1
+#define ESTOP_LOCKOUT_MS 50
+#define DEBOUNCE_DELAY_MS 50
+#define IR_SENSOR_DEBOUNCE_MS 5
+
+#define TICKS_PER_MS (EXTI_DEBOUNCE_TICK_HZ / 1000UL)
+
+static uint32 now_ticks;
+static unsigned fired[EXTI_LINE_COUNT];
+static uint32 fired_at[EXTI_LINE_COUNT];    // tick of the last callback
+
+static void Publish(uint8 LineNumber, void* Context) {
+    (void)Context;
+    fired[LineNumber]++;
+    fired_at[LineNumber] = now_ticks;
+}
+
+static void (*const line_vectors[EXTI_LINE_COUNT])(void) = {
+    EXTI0_IRQHandler, EXTI1_IRQHandler, EXTI2_IRQHandler, EXTI3_IRQHandler, EXTI4_IRQHandler,
+    EXTI9_5_IRQHandler, EXTI9_5_IRQHandler, EXTI9_5_IRQHandler, EXTI9_5_IRQHandler, EXTI9_5_IRQHandler,
+    EXTI15_10_IRQHandler, EXTI15_10_IRQHandler, EXTI15_10_IRQHandler,
+    EXTI15_10_IRQHandler, EXTI15_10_IRQHandler, EXTI15_10_IRQHandler,
+};
+
+// PR is write-1-to-clear; the handlers' stores are folded in here
+static uint32 host_pr;
+
+static void TakeInterrupts(void) {
+    for (uint8 line = 0; line < EXTI_LINE_COUNT; line++) {
+        if (host_pr & host_exti.EXTI_IMR & (1UL << line)) {
+            host_exti.EXTI_PR = host_pr;
+            line_vectors[line]();
+            host_pr &= ~host_exti.EXTI_PR;
+        }
+    }
+}
+
+// New pin levels: edges the line is set up for latch into PR
+static void SetLevels(uint32 Levels) {
+    uint32 rising = Levels & ~host_levels;
+    uint32 falling = ~Levels & host_levels;
+    host_levels = Levels;
+    host_pr |= ((rising & host_exti.EXTI_RTSR) | (falling & host_exti.EXTI_FTSR)) & 0xFFFF;
+    TakeInterrupts();
+}
+
+static void SetLine(uint8 Line, uint8 Level) {
+    SetLevels(Level ? (host_levels | (1UL << Line)) : (host_levels & ~(1UL << Line)));
+}
+
+// One TIM9 tick, and the compare interrupt if it is due
+static void Tick(void) {
+    now_ticks++;
+    host_tim9.CNT = (host_tim9.CNT + 1) & 0xFFFF;
+    if ((host_tim9.DIER & TIM_DIER_CC1IE_BIT) && host_tim9.CNT == host_tim9.CCR1) {
+        // The handler's PR store, if it makes one, clears the lines it
+        // unmasks; no line reads back as the marker
+        host_exti.EXTI_PR = 0xFFFFFFFFUL;
+        TIM1_BRK_TIM9_IRQHandler();
+        if (host_exti.EXTI_PR != 0xFFFFFFFFUL) {
+            host_pr &= ~host_exti.EXTI_PR;
+        }
+        TakeInterrupts();
+    }
+}
+
+static void RunMs(uint32 Ms) {
+    for (uint32 i = 0; i < Ms * TICKS_PER_MS; i++) {
+        Tick();
+    }
+}
+
+// A contact closing or opening: the first edge goes to `Final`, then the
+// level flips every `Bounce` ticks for `Count` flips before it settles
+static void Bounce(uint8 Line, uint8 Final, unsigned Count, unsigned Bounce) {
+    for (unsigned i = 0; i < Count; i++) {
+        SetLine(Line, (uint8)((i & 1) ? !Final : Final));
+        for (unsigned t = 0; t < Bounce; t++) {
+            Tick();
+        }
+    }
+    SetLine(Line, Final);
+}
+
+static void Reset(void) {
+    for (uint8 line = 0; line < EXTI_LINE_COUNT; line++) {
+        fired[line] = 0;
+        fired_at[line] = 0;
+    }
+}
+
+static void TestTrailing(void) {
+    Reset();
+    RunMs(10);
+
+    // Press: 8 flips 0.3 ms apart, then held for 200 ms
+    uint32 pressed_at = now_ticks;
+    Bounce(RESET_LINE, 0, 8, 3);
+    RunMs(200);
+    CHECK(fired[RESET_LINE] == 1, "bouncy press: %u callbacks", fired[RESET_LINE]);
+    uint32 delay = fired_at[RESET_LINE] - pressed_at;
+    CHECK(delay >= DEBOUNCE_DELAY_MS * TICKS_PER_MS && delay <= DEBOUNCE_DELAY_MS * TICKS_PER_MS + 1,
+          "bouncy press: published after %lu ticks, window %lu", (unsigned long)delay,
+          (unsigned long)(DEBOUNCE_DELAY_MS * TICKS_PER_MS));
+    CHECK(EXTI_DebouncePending == 0 && (host_exti.EXTI_IMR & (1UL << RESET_LINE)),
+          "bouncy press: line left masked after the window");
+
+    // Release: its bounces include falling edges, but the level is
+    // inactive once the window runs out
+    Bounce(RESET_LINE, 1, 8, 3);
+    RunMs(200);
+    CHECK(fired[RESET_LINE] == 1, "bouncy release: %u callbacks", fired[RESET_LINE]);
+
+    // A glitch shorter than the window
+    SetLine(RESET_LINE, 0);
+    RunMs(2);
+    SetLine(RESET_LINE, 1);
+    RunMs(200);
+    CHECK(fired[RESET_LINE] == 1, "2 ms glitch published");
+
+    // Bouncing that goes on longer than the window: one event per window
+    // that ends with the button down, never one per edge
+    Bounce(RESET_LINE, 0, 400, 3);
+    RunMs(200);
+    unsigned published = fired[RESET_LINE] - 1;
+    printf("120 ms of bouncing into a press: %u event(s) for 400 edges\n", published);
+    CHECK(published >= 1 && published <= 3, "long bounce: %u events", published);
+    SetLine(RESET_LINE, 1);
+    RunMs(200);
+}
+
+static void TestLeading(void) {
+    Reset();
+
+    // Published on the first edge; the rest of the bounce is locked out
+    uint32 pressed_at = now_ticks;
+    Bounce(ESTOP_LINE, 0, 12, 2);
+    CHECK(fired[ESTOP_LINE] == 1 && fired_at[ESTOP_LINE] == pressed_at,
+          "e-stop: %u callbacks, first after %lu ticks", fired[ESTOP_LINE],
+          (unsigned long)(fired_at[ESTOP_LINE] - pressed_at));
+    RunMs(200);
+    CHECK(fired[ESTOP_LINE] == 1, "e-stop: %u callbacks after the lockout", fired[ESTOP_LINE]);
+
+    // Release bounces come after the lockout and are themselves edges:
+    // one more event at most, from the first of them
+    Bounce(ESTOP_LINE, 1, 12, 2);
+    RunMs(200);
+    CHECK(fired[ESTOP_LINE] <= 2, "e-stop release: %u callbacks", fired[ESTOP_LINE]);
+
+    // A second press after the lockout is its own event
+    unsigned before = fired[ESTOP_LINE];
+    Bounce(ESTOP_LINE, 0, 12, 2);
+    RunMs(200);
+    CHECK(fired[ESTOP_LINE] == before + 1, "second e-stop: %u new callbacks", fired[ESTOP_LINE] - before);
+    SetLine(ESTOP_LINE, 1);
+    RunMs(200);
+}
+
+// The sensor's short window runs out while the button's long one is
+// still open: each line is published at its own deadline
+static void TestIndependentWindows(void) {
+    Reset();
+
+    uint32 button_at = now_ticks;
+    Bounce(RESET_LINE, 0, 6, 3);
+    RunMs(10);
+    uint32 sensor_at = now_ticks;
+    Bounce(SENSOR_LINE, 0, 4, 2);
+    RunMs(100);
+
+    uint32 sensor_delay = fired_at[SENSOR_LINE] - sensor_at;
+    uint32 button_delay = fired_at[RESET_LINE] - button_at;
+    printf("sensor published after %.1f ms, button after %.1f ms\n",
+           sensor_delay / (double)TICKS_PER_MS, button_delay / (double)TICKS_PER_MS);
+    CHECK(fired[SENSOR_LINE] == 1 && fired[RESET_LINE] == 1, "sensor %u, button %u callbacks",
+          fired[SENSOR_LINE], fired[RESET_LINE]);
+    CHECK(sensor_delay >= IR_SENSOR_DEBOUNCE_MS * TICKS_PER_MS &&
+          sensor_delay <= IR_SENSOR_DEBOUNCE_MS * TICKS_PER_MS + 1,
+          "sensor: %lu ticks behind the button's window", (unsigned long)sensor_delay);
+    CHECK(button_delay >= DEBOUNCE_DELAY_MS * TICKS_PER_MS && button_delay <= DEBOUNCE_DELAY_MS * TICKS_PER_MS + 1,
+          "button: %lu ticks", (unsigned long)button_delay);
+
+    SetLine(SENSOR_LINE, 1);
+    SetLine(RESET_LINE, 1);
+    RunMs(200);
+}
+
+// Every line with its own window, all bouncing at once
+static void TestAllLines(void) {
+    for (uint8 line = 0; line < EXTI_LINE_COUNT; line++) {
+        EXTI_Register(line, GPIO_A, FALLING_EDGE_TRIGGERED, Publish, 0);
+        EXTI_SetDebounce(line, EXTI_DEBOUNCE_TRAILING, (uint16)(3 + line * 7));
+    }
+    Reset();
+
+    uint32 start = now_ticks;
+    for (unsigned flip = 0; flip < 10; flip++) {
+        SetLevels((flip & 1) ? 0xFFFF : 0x0000);
+        Tick();
+        Tick();
+    }
+    SetLevels(0x0000);
+    RunMs(300);
+
+    unsigned late = 0;
+    for (uint8 line = 0; line < EXTI_LINE_COUNT; line++) {
+        uint32 window = (3 + line * 7) * TICKS_PER_MS;
+        uint32 delay = fired_at[line] - start;
+        if (fired[line] != 1 || delay < window || delay > window + 1) {
+            printf("line %u: %u callbacks, after %lu ticks, window %lu\n", line, fired[line],
+                   (unsigned long)delay, (unsigned long)window);
+            late++;
+        }
+    }
+    CHECK(late == 0, "all lines: %u line(s) off their own window", late);
+    CHECK(!(host_tim9.DIER & TIM_DIER_CC1IE_BIT), "all lines: compare interrupt left on with nothing waiting");
+    SetLevels(0xFFFF);
+    RunMs(300);
+}
+
+int main(void) {
+    EXTI_SYSCFG = &host_syscfg;
+
+    EXTI_Register(ESTOP_LINE, GPIO_A, FALLING_EDGE_TRIGGERED, Publish, 0);
+    EXTI_Register(RESET_LINE, GPIO_A, FALLING_EDGE_TRIGGERED, Publish, 0);
+    EXTI_Register(SENSOR_LINE, GPIO_A, FALLING_EDGE_TRIGGERED, Publish, 0);
+    EXTI_SetDebounce(ESTOP_LINE, EXTI_DEBOUNCE_LEADING, ESTOP_LOCKOUT_MS);
+    EXTI_SetDebounce(RESET_LINE, EXTI_DEBOUNCE_TRAILING, DEBOUNCE_DELAY_MS);
+    EXTI_SetDebounce(SENSOR_LINE, EXTI_DEBOUNCE_TRAILING, IR_SENSOR_DEBOUNCE_MS);
+
+    TestTrailing();
+    TestLeading();
+    TestIndependentWindows();
+    TestAllLines();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
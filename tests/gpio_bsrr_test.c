@@ -0,0 +1,165 @@
+/**
+ * gpio_bsrr_test.c
+ *
+ *  Register-mock test for the BSRR write paths. Ports A-D are test-owned
+ *  structs; Gpio.c's address table is pointed at them, which needs a
+ *  non-PIE build so they sit below 4 GiB. Every access through
+ *  GPIO_PORT_DEVICE is counted and each BSRR store logged. Checks that pin
+ *  and masked writes are one BSRR store that leaves ODR and MODER alone,
+ *  and that an LCD nibble puts RS and D4-D7 out in a single store.
+ *
+ *    gcc -std=gnu11 -no-pie -Wno-int-to-pointer-cast -Wno-pointer-to-int-cast -Itests/stubs -IGpio -ILCD -IRcc -ITime -IIrq \
+ *        -o gpio_bsrr_test tests/gpio_bsrr_test.c && ./gpio_bsrr_test
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+
+#include "Std_Types.h"
+#include "Gpio.h"
+#include "Gpio_Private.h"
+
+static GPIO_Device host_ports[4];
+static unsigned host_accesses;
+static uint32 bsrr_log[16];
+static unsigned bsrr_count;
+
+// Logs the store the previous access left in BSRR
+static void HostCollect(void) {
+    for (unsigned i = 0; i < 4; i++) {
+        if (host_ports[i].GPIO_BSRR != 0) {
+            if (bsrr_count < 16) {
+                bsrr_log[bsrr_count] = host_ports[i].GPIO_BSRR;
+            }
+            bsrr_count++;
+            host_ports[i].GPIO_BSRR = 0;
+        }
+    }
+}
+
+static GPIO_Device* HostPort(uint8 PortName) {
+    HostCollect();
+    host_accesses++;
+    return &host_ports[PortName - GPIO_A];
+}
+
+#define GPIO_PORT_DEVICE(PortName) HostPort(PortName)
+
+#include "../Gpio/Gpio.c"
+#include "../LCD/lcd.c"
+
+TIM_TypeDef host_tim11;
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetHclkHz(void) { return 84000000UL; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Time_DelayMs(uint32 Delay) { (void)Delay; }
+void Time_DelayUs(uint32 Delay) { (void)Delay; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define SENTINEL 0xA5A5A5A5UL
+
+static void Arm(uint8 PortName) {
+    GPIO_Device* port = &host_ports[PortName - GPIO_A];
+    HostCollect();
+    port->GPIO_ODR = SENTINEL;
+    port->GPIO_MODER = SENTINEL;
+    port->GPIO_BSRR = 0;
+    bsrr_count = 0;
+    host_accesses = 0;
+}
+
+// The call under test must have made exactly one store, to BSRR
+static void ExpectOneStore(uint8 PortName, uint32 expected, const char *what) {
+    GPIO_Device* port = &host_ports[PortName - GPIO_A];
+    HostCollect();
+    CHECK(bsrr_count == 1, "%s: %u BSRR stores", what, bsrr_count);
+    CHECK(bsrr_log[0] == expected, "%s: BSRR = 0x%08lx, expected 0x%08lx", what,
+          (unsigned long)bsrr_log[0], (unsigned long)expected);
+    CHECK(port->GPIO_ODR == SENTINEL, "%s: ODR written", what);
+    CHECK(port->GPIO_MODER == SENTINEL, "%s: MODER written", what);
+}
+
+static int MapPorts(void) {
+    for (unsigned i = 0; i < 4; i++) {
+        address_map[i] = (uint32)(uintptr_t)&host_ports[i];
+        if ((uintptr_t)address_map[i] != (uintptr_t)&host_ports[i]) {
+            printf("host ports above 4 GiB, build with -no-pie\n");
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void TestWritePin(void) {
+    Arm(GPIO_B);
+    CHECK(Gpio_WritePin(GPIO_B, 7, HIGH) == OK, "WritePin failed");
+    ExpectOneStore(GPIO_B, 1UL << 7, "WritePin high");
+
+    Arm(GPIO_B);
+    Gpio_WritePin(GPIO_B, 7, LOW);
+    ExpectOneStore(GPIO_B, 1UL << (7 + 16), "WritePin low");
+
+    Arm(GPIO_D);
+    Gpio_WritePin(GPIO_D, 15, HIGH);
+    ExpectOneStore(GPIO_D, 1UL << 15, "WritePin pin 15");
+}
+
+static void TestPortMasked(void) {
+    Arm(GPIO_C);
+    Gpio_WritePortMasked(GPIO_C, 0x00F0, 0x0050);
+    ExpectOneStore(GPIO_C, 0x0050UL | (0x00A0UL << 16), "WritePortMasked");
+
+    // Bits of Value outside Mask must not leak into the store
+    Arm(GPIO_C);
+    Gpio_WritePortMasked(GPIO_C, 0x0003, 0xFFFE);
+    ExpectOneStore(GPIO_C, 0x0002UL | (0x0001UL << 16), "WritePortMasked outside mask");
+
+    Arm(GPIO_A);
+    Gpio_FastWritePortMasked(GPIO_A, 0x8001, 0x8000);
+    ExpectOneStore(GPIO_A, 0x8000UL | (0x0001UL << 16), "FastWritePortMasked");
+    CHECK(host_accesses == 1, "FastWritePortMasked: %u port accesses", host_accesses);
+
+    Arm(GPIO_A);
+    Gpio_FastWritePin(GPIO_A, 3, LOW);
+    ExpectOneStore(GPIO_A, 1UL << (3 + 16), "FastWritePin");
+}
+
+// RS and D4-D7 in one store, then E high and low
+static void TestLcdNibble(void) {
+    const uint8 nibble = 0x9;   // D4 and D7 high, D5 and D6 low
+    Arm(GPIO_A);
+    LCD_SendNibble(HIGH, nibble);
+    HostCollect();
+
+    CHECK(host_accesses == 3, "nibble: %u port accesses, expected data + E high + E low", host_accesses);
+    CHECK(bsrr_count == 3, "nibble: %u BSRR stores", bsrr_count);
+    uint32 set = LCD_D4_MASK | LCD_D7_MASK | LCD_RS_MASK;
+    uint32 reset = LCD_D5_MASK | LCD_D6_MASK;
+    CHECK(bsrr_log[0] == (set | (reset << 16)), "nibble data store 0x%08lx, expected 0x%08lx",
+          (unsigned long)bsrr_log[0], (unsigned long)(set | (reset << 16)));
+    CHECK(bsrr_log[1] == LCD_E_MASK, "E not raised after the data");
+    CHECK(bsrr_log[2] == (uint32)LCD_E_MASK << 16, "E not dropped last");
+    CHECK(host_ports[0].GPIO_ODR == SENTINEL, "nibble: ODR written");
+}
+
+int main(void) {
+    if (!MapPorts()) {
+        return 1;
+    }
+    TestWritePin();
+    TestPortMasked();
+    TestLcdNibble();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
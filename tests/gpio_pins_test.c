@@ -0,0 +1,118 @@
+/**
+ * gpio_pins_test.c
+ *
+ *  Host comparison of the compile-time pin descriptors against the
+ *  address_map[] functions in Gpio.c. Gpio.c is built as its own
+ *  translation unit, as on the target, with its port table pointed at
+ *  host structs (needs a non-PIE build so they sit below 4 GiB). Checks
+ *  that both paths produce the same register traffic and reports the cost
+ *  per access of each.
+ *
+ *    gcc -std=gnu11 -O2 -no-pie -Wno-int-to-pointer-cast -Itests/stubs -IGpio \
+ *        -o gpio_pins_test tests/gpio_pins_test.c Gpio/Gpio.c && ./gpio_pins_test
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
+
+#include "Std_Types.h"
+#include "Gpio.h"
+#include "Gpio_Private.h"
+
+static GPIO_Device host_ports[4];
+
+// Constant address, as GPIOA_BASE_ADDR + n * 0x400 is on the target
+#define GPIO_PORT_DEVICE(PortName) (&host_ports[(PortName) - GPIO_A])
+
+#include "Gpio_Pins.h"
+
+extern uint32 address_map[4];
+
+PIN_DEF(BENCH_OUT, GPIO_A, 4)
+PIN_DEF(BENCH_IN,  GPIO_B, 6)
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define ROUNDS 20000000L
+
+static double Now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec * 1e9 + (double)ts.tv_nsec;
+}
+
+static void TestSameTraffic(void) {
+    Gpio_WritePin(GPIO_A, BENCH_OUT_PIN, HIGH);
+    uint32 function_set = host_ports[0].GPIO_BSRR;
+    PIN_SET(BENCH_OUT);
+    CHECK(host_ports[0].GPIO_BSRR == function_set, "PIN_SET stored 0x%lx, Gpio_WritePin 0x%lx",
+          (unsigned long)host_ports[0].GPIO_BSRR, (unsigned long)function_set);
+
+    Gpio_WritePin(GPIO_A, BENCH_OUT_PIN, LOW);
+    uint32 function_clear = host_ports[0].GPIO_BSRR;
+    PIN_CLEAR(BENCH_OUT);
+    CHECK(host_ports[0].GPIO_BSRR == function_clear, "PIN_CLEAR differs from Gpio_WritePin");
+
+    PIN_WRITE(BENCH_OUT, HIGH);
+    CHECK(host_ports[0].GPIO_BSRR == function_set, "PIN_WRITE differs from Gpio_WritePin");
+
+    for (uint32 idr = 0; idr < 2; idr++) {
+        host_ports[1].GPIO_IDR = idr << BENCH_IN_PIN;
+        CHECK(PIN_READ(BENCH_IN) == Gpio_ReadPin(GPIO_B, BENCH_IN_PIN) && PIN_READ(BENCH_IN) == idr,
+              "PIN_READ and Gpio_ReadPin disagree for IDR 0x%lx", (unsigned long)host_ports[1].GPIO_IDR);
+    }
+}
+
+static void Compare(void) {
+    double t0 = Now();
+    for (long i = 0; i < ROUNDS; i++) {
+        Gpio_WritePin(GPIO_A, BENCH_OUT_PIN, (uint8)(i & 1));
+    }
+    double t1 = Now();
+    for (long i = 0; i < ROUNDS; i++) {
+        PIN_WRITE(BENCH_OUT, (uint8)(i & 1));
+    }
+    double t2 = Now();
+    uint32 sink = 0;
+    for (long i = 0; i < ROUNDS; i++) {
+        sink += Gpio_ReadPin(GPIO_B, BENCH_IN_PIN);
+    }
+    double t3 = Now();
+    for (long i = 0; i < ROUNDS; i++) {
+        sink += PIN_READ(BENCH_IN);
+    }
+    double t4 = Now();
+
+    double write_fn = (t1 - t0) / ROUNDS, write_pin = (t2 - t1) / ROUNDS;
+    double read_fn = (t3 - t2) / ROUNDS, read_pin = (t4 - t3) / ROUNDS;
+    printf("write: Gpio_WritePin %.2f ns, PIN_WRITE %.2f ns (%.1fx)\n", write_fn, write_pin, write_fn / write_pin);
+    printf("read:  Gpio_ReadPin  %.2f ns, PIN_READ  %.2f ns (%.1fx)\n", read_fn, read_pin, read_fn / read_pin);
+    (void)sink;
+    CHECK(write_pin < write_fn, "descriptor write not cheaper than the function");
+    CHECK(read_pin < read_fn, "descriptor read not cheaper than the function");
+}
+
+int main(void) {
+    for (unsigned i = 0; i < 4; i++) {
+        address_map[i] = (uint32)(uintptr_t)&host_ports[i];
+        if ((uintptr_t)address_map[i] != (uintptr_t)&host_ports[i]) {
+            printf("host ports above 4 GiB, build with -no-pie\n");
+            return 1;
+        }
+    }
+
+    TestSameTraffic();
+    Compare();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
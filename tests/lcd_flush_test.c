@@ -0,0 +1,130 @@
+/**
+ * lcd_flush_test.c
+ *
+ *  Host test for the LCD shadow framebuffer. Counts the controller bus
+ *  transactions (bytes queued for the HD44780) that each refresh costs and
+ *  checks them against the dirty-run rules.
+ *
+ *    gcc -std=gnu11 -Wno-int-to-pointer-cast -Itests/stubs -ILCD -IGpio -IRcc -ITime -IIrq \
+ *        -o lcd_flush_test tests/lcd_flush_test.c && ./lcd_flush_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+// The queue is private to the module; the test empties it in place of the
+// TIM11 interrupt, which would drive GPIO
+#include "../LCD/lcd.c"
+
+TIM_TypeDef host_tim11;
+
+// Only LCD_Init uses these, and the test never calls it
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetHclkHz(void) { return 84000000UL; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultState) {
+    (void)PortName; (void)PinNumber; (void)PinMode; (void)DefaultState;
+}
+void Time_DelayMs(uint32 Delay) { (void)Delay; }
+void Time_DelayUs(uint32 Delay) { (void)Delay; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+typedef struct {
+    unsigned commands;
+    unsigned chars;
+} Transactions;
+
+// Takes everything queued since the last call, as the controller would see it
+static Transactions Drain(void) {
+    Transactions t = {0, 0};
+    while (lcd_tail != lcd_head) {
+        if (lcd_queue[lcd_tail] & LCD_ENTRY_RS) {
+            t.chars++;
+        } else {
+            t.commands++;
+        }
+        lcd_tail = (lcd_tail + 1) & (LCD_QUEUE_SIZE - 1);
+    }
+    lcd_running = 0;
+    return t;
+}
+
+static unsigned Refresh(const char *name, unsigned expected) {
+    unsigned queued = LCD_Flush();
+    Transactions t = Drain();
+
+    printf("%-28s %2u bytes (%u cursor, %u data)\n", name, queued, t.commands, t.chars);
+    CHECK(queued == t.commands + t.chars, "%s: flush reported %u, queue held %u",
+          name, queued, t.commands + t.chars);
+    CHECK(queued == expected, "%s: expected %u bytes, got %u", name, expected, queued);
+    CHECK(memcmp((const char *)lcd_frame, lcd_shown, sizeof(lcd_shown)) == 0,
+          "%s: controller copy differs from the framebuffer", name);
+    return queued;
+}
+
+int main(void) {
+    LCD_Clear();
+    Drain();
+
+    // Same layout as main.c's status screen
+    LCD_FbWrite(LCD_ROW_0, 0, "Object Count: 07");
+    LCD_FbWrite(LCD_ROW_1, 0, "Conv:123 Mot:45%");
+    // Row 0 needs no cursor (home after clear), row 1 one; the single
+    // blanks between words are merged into the runs
+    unsigned full = Refresh("status screen", 16 + 1 + 16);
+
+    Refresh("unchanged", 0);
+
+    LCD_FbWrite(LCD_ROW_0, 14, "8");
+    unsigned one_digit = Refresh("one digit", 2);
+
+    LCD_FbWrite(LCD_ROW_0, 13, "10");
+    Refresh("two adjacent digits", 3);
+
+    // Dirty cells one clean cell apart: one run, one cursor command
+    LCD_FbWrite(LCD_ROW_1, 5, "2");
+    LCD_FbWrite(LCD_ROW_1, 7, "9");
+    unsigned merged = LCD_Flush();
+    Transactions t = Drain();
+    printf("%-28s %2u bytes (%u cursor, %u data)\n", "gap of one, merged", merged, t.commands, t.chars);
+    CHECK(t.commands == 1 && t.chars == 3, "gap of one: %u cursor + %u data", t.commands, t.chars);
+
+    // Two clean cells apart: a second cursor is cheaper than resending both
+    LCD_FbWrite(LCD_ROW_1, 5, "1");
+    LCD_FbWrite(LCD_ROW_1, 8, "0");
+    Refresh("gap of two, split", 4);
+
+    // The cursor is already after the last run: no command needed
+    LCD_FbWrite(LCD_ROW_1, 9, "X");
+    Refresh("continues at cursor", 1);
+
+    // Direct writes overwrite cells behind the framebuffer: the next flush
+    // puts them back, with a cursor command since the cursor has moved
+    LCD_SetCursor(LCD_ROW_0, 2);
+    LCD_PrintString("XY");
+    Drain();
+    Refresh("after direct write", 1 + 2);
+
+    // No LCD_SetCursor: the char lands where the last run left the cursor
+    LCD_PrintChar('Z');
+    Drain();
+    Refresh("after direct char", 1 + 1);
+
+    // The per-field helpers this replaced: cursor, "    ", cursor, digits
+    unsigned old_field = 1 + 4 + 1 + 3;
+    printf("old per-field rewrite        %2u bytes, vs %u now; full screen %u\n",
+           old_field, one_digit, full);
+    CHECK(one_digit * 4 <= old_field, "one-digit refresh is not cheaper than the old rewrite");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
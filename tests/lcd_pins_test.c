@@ -0,0 +1,256 @@
+/**
+ * lcd_pins_test.c
+ *
+ *  Host simulation of the queue-based LCD driver at the pin level. The LCD
+ *  port is a test-owned struct whose BSRR stores are applied to a simulated
+ *  ODR and recorded with a timestamp; TIM11 runs on simulated time, one
+ *  TIM1_TRG_COM_TIM11_IRQHandler call per update event. The recorded trace
+ *  is decoded on the falling edges of E, as the HD44780 latches it, and
+ *  checked for byte order and the controller's timing.
+ *
+ *    gcc -std=gnu11 -Itests/stubs -ILCD -IGpio -IRcc -ITime -IIrq \
+ *        -o lcd_pins_test tests/lcd_pins_test.c && ./lcd_pins_test
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "Std_Types.h"
+#include "Gpio.h"
+#include "Gpio_Private.h"
+
+static GPIO_Device host_port;
+static uint16 host_odr;
+static uint32 host_now_us;
+static uint32 host_store_us;    // when the store still sitting in BSRR happened
+static int host_wrong_port;
+
+typedef struct {
+    uint32 time_us;
+    uint16 odr;
+} Transition;
+
+#define TRACE_SIZE 4096
+static Transition trace[TRACE_SIZE];
+static unsigned trace_len;
+
+// Applies the last BSRR store to the simulated ODR
+static void HostCommit(void) {
+    uint32 bsrr = host_port.GPIO_BSRR;
+    if (bsrr == 0) {
+        return;
+    }
+    host_port.GPIO_BSRR = 0;
+
+    uint16 odr = (uint16)((host_odr | (bsrr & 0xFFFFU)) & ~(bsrr >> 16));
+    if (odr != host_odr && trace_len < TRACE_SIZE) {
+        trace[trace_len].time_us = host_store_us;
+        trace[trace_len].odr = odr;
+        trace_len++;
+    }
+    host_odr = odr;
+}
+
+// Every port access goes through here, so the previous store is committed
+// before the next one lands
+static GPIO_Device* HostPort(uint8 PortName) {
+    HostCommit();
+    host_store_us = host_now_us;
+    if (PortName != GPIO_A) {
+        host_wrong_port++;
+    }
+    return &host_port;
+}
+
+#define GPIO_PORT_DEVICE(PortName) HostPort(PortName)
+
+#include "../LCD/lcd.c"
+
+TIM_TypeDef host_tim11;
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetHclkHz(void) { return 84000000UL; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultState) {
+    (void)PortName; (void)PinNumber; (void)PinMode; (void)DefaultState;
+}
+void Time_DelayMs(uint32 Delay) { host_now_us += Delay * 1000UL; }
+void Time_DelayUs(uint32 Delay) { host_now_us += Delay; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// HD44780 minimums
+#define EXEC_MIN_US     37
+#define CLEAR_MIN_US    1520
+
+// One-pulse TIM11: the update event comes ARR + 1 ticks after arming
+static void RunEngine(unsigned max_events) {
+    while ((host_tim11.CR1 & LCD_TIM_CR1_CEN) && max_events--) {
+        host_now_us += host_tim11.ARR + 1;
+        host_tim11.CR1 &= ~LCD_TIM_CR1_CEN;
+        host_tim11.SR |= LCD_TIM_SR_UIF;
+        TIM1_TRG_COM_TIM11_IRQHandler();
+    }
+    HostCommit();
+}
+
+typedef struct {
+    uint32 time_us;     // falling edge of E
+    uint8 rs;
+    uint8 nibble;
+} Nibble;
+
+static uint8 PortNibble(uint16 odr) {
+    return (uint8)(((odr >> LCD_D4_PIN) & 1U) | ((odr >> LCD_D5_PIN) & 1U) << 1 |
+                   ((odr >> LCD_D6_PIN) & 1U) << 2 | ((odr >> LCD_D7_PIN) & 1U) << 3);
+}
+
+// Nibbles latched between trace entries [from, trace_len)
+static unsigned Decode(unsigned from, Nibble* out, unsigned max) {
+    unsigned count = 0;
+    uint16 prev = from ? trace[from - 1].odr : 0;
+    uint16 rising = 0;
+
+    for (unsigned i = from; i < trace_len && count < max; i++) {
+        uint16 odr = trace[i].odr;
+        CHECK(!(odr & LCD_RW_MASK), "RW driven high at %lu us", (unsigned long)trace[i].time_us);
+        if (!(prev & LCD_E_MASK) && (odr & LCD_E_MASK)) {
+            rising = odr;
+        }
+        if ((prev & LCD_E_MASK) && !(odr & LCD_E_MASK)) {
+            CHECK((rising & (LCD_DATA_MASK | LCD_RS_MASK)) == (odr & (LCD_DATA_MASK | LCD_RS_MASK)),
+                  "bus changed while E was high at %lu us", (unsigned long)trace[i].time_us);
+            out[count].time_us = trace[i].time_us;
+            out[count].rs = (odr & LCD_RS_MASK) ? 1 : 0;
+            out[count].nibble = PortNibble(odr);
+            count++;
+        }
+        prev = odr;
+    }
+    return count;
+}
+
+// Pairs nibbles into bytes and checks each gap against what the previous
+// byte needs; returns the number of bytes matched against expected
+static unsigned CheckBytes(const Nibble* nib, unsigned count, const uint16* expected, unsigned bytes,
+                           uint32 prev_end_us, uint32 prev_need_us) {
+    CHECK(count == bytes * 2, "%u nibbles for %u bytes", count, bytes);
+    if (count != bytes * 2) {
+        return 0;
+    }
+
+    for (unsigned b = 0; b < bytes; b++) {
+        const Nibble* hi = &nib[2 * b];
+        const Nibble* lo = &nib[2 * b + 1];
+        uint16 byte = (uint16)((hi->nibble << 4) | lo->nibble);
+        uint16 want = expected[b] & 0xFF;
+        uint8 rs = (expected[b] & LCD_ENTRY_RS) ? 1 : 0;
+
+        CHECK(byte == want && hi->rs == rs && lo->rs == rs,
+              "byte %u: got 0x%02x rs=%u, expected 0x%02x rs=%u", b, byte, hi->rs, want, rs);
+        CHECK(lo->time_us - hi->time_us >= 1, "byte %u: nibbles %lu us apart", b,
+              (unsigned long)(lo->time_us - hi->time_us));
+        if (prev_need_us) {
+            CHECK(hi->time_us - prev_end_us >= prev_need_us, "byte %u: sent %lu us after the last, needs %lu",
+                  b, (unsigned long)(hi->time_us - prev_end_us), (unsigned long)prev_need_us);
+        }
+        prev_end_us = lo->time_us;
+        prev_need_us = (!rs && (want == LCD_CMD_CLEAR || want == LCD_CMD_RETURN_HOME)) ? CLEAR_MIN_US : EXEC_MIN_US;
+    }
+    return bytes;
+}
+
+static Nibble nibbles[TRACE_SIZE];
+
+static void TestInit(void) {
+    LCD_Init();
+    RunEngine(1000);
+
+    unsigned count = Decode(0, nibbles, TRACE_SIZE);
+    CHECK(count >= 4, "init sent %u nibbles", count);
+    if (count < 4) {
+        return;
+    }
+
+    // Three 0x3 wake-ups and the switch to 4-bit, each a lone nibble
+    const uint8 wake[4] = { 0x3, 0x3, 0x3, 0x2 };
+    const uint32 wait[3] = { 4100, 100, EXEC_MIN_US };
+    CHECK(nibbles[0].time_us >= 15000, "first nibble %lu us after power-up", (unsigned long)nibbles[0].time_us);
+    for (unsigned i = 0; i < 4; i++) {
+        CHECK(nibbles[i].nibble == wake[i] && !nibbles[i].rs, "wake-up %u: 0x%x", i, nibbles[i].nibble);
+        if (i < 3) {
+            CHECK(nibbles[i + 1].time_us - nibbles[i].time_us >= wait[i], "wake-up %u: next after %lu us",
+                  i, (unsigned long)(nibbles[i + 1].time_us - nibbles[i].time_us));
+        }
+    }
+
+    const uint16 config[] = { LCD_CMD_FUNCTION_SET, LCD_CMD_DISPLAY_ON, LCD_CMD_ENTRY_MODE, LCD_CMD_CLEAR };
+    CheckBytes(&nibbles[4], count - 4, config, 4, nibbles[3].time_us, EXEC_MIN_US);
+    CHECK(LCD_IsIdle(), "engine still running after the queue drained");
+}
+
+static void TestLineIsQueued(void) {
+    const char *text = "Conv:123 Mot:45%";
+    unsigned from = trace_len;
+    uint32 start = host_now_us;
+
+    LCD_SetCursor(LCD_ROW_1, 0);
+    LCD_PrintString(text);
+    CHECK(trace_len == from, "queuing a line moved %u pins", trace_len - from);
+    CHECK(host_now_us == start, "queuing a line blocked for %lu us", (unsigned long)(host_now_us - start));
+    CHECK(!LCD_IsIdle(), "engine not started");
+
+    RunEngine(1000);
+
+    uint16 expected[1 + 16];
+    expected[0] = 0x80 | 0x40;
+    for (unsigned i = 0; i < 16; i++) {
+        expected[1 + i] = LCD_ENTRY_RS | (uint8)text[i];
+    }
+    unsigned count = Decode(from, nibbles, TRACE_SIZE);
+    CheckBytes(nibbles, count, expected, 17, 0, 0);
+
+    uint32 line_us = host_now_us - start;
+    printf("16-char line with cursor: %lu us in the background (blocking driver: ~64000 us)\n",
+           (unsigned long)line_us);
+    CHECK(line_us < 2000, "line took %lu us", (unsigned long)line_us);
+}
+
+// An interrupt queues a status line while the main loop's text is still
+// going out; bytes keep their order and nothing is lost
+static void TestProducerMidDrain(void) {
+    unsigned from = trace_len;
+
+    LCD_SetCursor(LCD_ROW_0, 0);
+    LCD_PrintString("AB");
+    RunEngine(3);       // cursor command out, 'A' half sent
+    LCD_SendCommand(LCD_CMD_CLEAR);
+    LCD_PrintString("STOP");
+    RunEngine(1000);
+
+    const uint16 expected[] = {
+        0x80, LCD_ENTRY_RS | 'A', LCD_ENTRY_RS | 'B', LCD_CMD_CLEAR,
+        LCD_ENTRY_RS | 'S', LCD_ENTRY_RS | 'T', LCD_ENTRY_RS | 'O', LCD_ENTRY_RS | 'P',
+    };
+    unsigned count = Decode(from, nibbles, TRACE_SIZE);
+    CheckBytes(nibbles, count, expected, sizeof(expected) / sizeof(expected[0]), 0, 0);
+    CHECK(LCD_GetDroppedCount() == 0, "%lu bytes dropped", (unsigned long)LCD_GetDroppedCount());
+}
+
+int main(void) {
+    TestInit();
+    TestLineIsQueued();
+    TestProducerMidDrain();
+    CHECK(host_wrong_port == 0, "LCD touched a port other than GPIOA");
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
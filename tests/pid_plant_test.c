@@ -0,0 +1,208 @@
+/**
+ * pid_plant_test.c
+ *
+ *  Host test for the conveyor speed loop. Runs Pid_Update() with main.c's
+ *  gains, limits and 5 ms tick against a first-order model of the motor and
+ *  belt (duty in, mm/s out, measured one tick late and to the nearest mm/s
+ *  like the capture path), and checks the step response, the rejection of
+ *  a load step, the slew limit and the recovery from saturation and from
+ *  a slow ramp. Also reports the cost of one Pid_Update() against the
+ *  control tick.
+ *
+ *    gcc -std=gnu11 -O2 -IPid -o pid_plant_test tests/pid_plant_test.c Pid/Pid.c -lm && ./pid_plant_test
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <time.h>
+
+#include "Pid.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// main.c's loop configuration; the period is PWM_Configure's at its
+// 20 kHz default from the 84 MHz timer clock
+#define CONTROL_PERIOD_MS 5
+#define CONVEYOR_MAX_SPEED_MM_S 400
+#define SPEED_KP_Q16 (2L << PID_Q)
+#define SPEED_KI_Q16 ((1L << PID_Q) / 20)
+#define SPEED_GAIN_PERIOD 1000L
+#define SPEED_SLEW_DIVISOR 50
+#define PERIOD_TICKS 4200L
+
+// Motor plus belt: 500 mm/s at full duty unloaded, 120 ms time constant
+#define PLANT_FULL_SPEED_MM_S 500.0
+#define PLANT_TAU_MS 120.0
+
+typedef struct {
+    double speed_mm_s;
+    double load_mm_s;       // speed lost to belt load at any duty
+    int32_t measured;       // what the capture reported for the last tick
+} Plant;
+
+// One control tick of the plant, integrated in 1 ms steps
+static void Plant_Step(Plant *plant, int32_t compare) {
+    plant->measured = (int32_t)lround(plant->speed_mm_s);
+    double target = PLANT_FULL_SPEED_MM_S * compare / PERIOD_TICKS - plant->load_mm_s;
+    if (target < 0) {
+        target = 0;     // the belt doesn't run backwards under load
+    }
+    for (int ms = 0; ms < CONTROL_PERIOD_MS; ms++) {
+        plant->speed_mm_s += (target - plant->speed_mm_s) / PLANT_TAU_MS;
+    }
+}
+
+static void Speed_PidInit(Pid_t *pid, int32_t slew_max) {
+    Pid_Config_t config = {
+        .kp_q16 = (int32_t)(SPEED_KP_Q16 * PERIOD_TICKS / SPEED_GAIN_PERIOD),
+        .ki_q16 = (int32_t)(SPEED_KI_Q16 * PERIOD_TICKS / SPEED_GAIN_PERIOD),
+        .kd_q16 = 0,
+        .out_min = 0,
+        .out_max = (int32_t)PERIOD_TICKS,
+        .slew_max = slew_max,
+    };
+    Pid_Init(pid, &config);
+}
+
+typedef struct {
+    double peak_mm_s;
+    double low_mm_s;
+    int settle_ms;          // last time outside the band, -1 if never inside
+    int32_t worst_slew;
+} Response;
+
+// Runs `ms` of control at `setpoint`, tracking the excursions after `from_ms`
+static Response Run(Pid_t *pid, Plant *plant, int32_t setpoint, int ms, int from_ms, double band) {
+    Response r = { 0.0, 1e9, 0, 0 };
+    int32_t last = Pid_GetOutput(pid);
+    for (int t = 0; t < ms; t += CONTROL_PERIOD_MS) {
+        int32_t compare = Pid_Update(pid, setpoint, plant->measured);
+        int32_t slew = compare > last ? compare - last : last - compare;
+        if (slew > r.worst_slew) {
+            r.worst_slew = slew;
+        }
+        last = compare;
+        Plant_Step(plant, compare);
+        if (t >= from_ms) {
+            if (plant->speed_mm_s > r.peak_mm_s) {
+                r.peak_mm_s = plant->speed_mm_s;
+            }
+            if (plant->speed_mm_s < r.low_mm_s) {
+                r.low_mm_s = plant->speed_mm_s;
+            }
+        }
+        if (fabs(plant->speed_mm_s - setpoint) > band) {
+            r.settle_ms = t + CONTROL_PERIOD_MS;
+        }
+    }
+    return r;
+}
+
+static void Test_Step(void) {
+    Pid_t pid;
+    Plant plant = { 0.0, 0.0, 0 };
+    Speed_PidInit(&pid, PERIOD_TICKS / SPEED_SLEW_DIVISOR);
+
+    int32_t setpoint = 300;
+    Response r = Run(&pid, &plant, setpoint, 3000, 0, setpoint * 0.02);
+    printf("step 0 -> %d mm/s: peak %.1f, settled to 2%% in %d ms, final %.1f\n",
+           (int)setpoint, r.peak_mm_s, r.settle_ms, plant.speed_mm_s);
+    CHECK(r.peak_mm_s <= setpoint * 1.10, "overshoot %.1f mm/s above %d", r.peak_mm_s - setpoint, (int)setpoint);
+    CHECK(r.settle_ms <= 1500, "took %d ms to settle", r.settle_ms);
+    CHECK(fabs(plant.speed_mm_s - setpoint) < 1.0, "steady-state error %.2f mm/s", plant.speed_mm_s - setpoint);
+    CHECK(r.worst_slew <= PERIOD_TICKS / SPEED_SLEW_DIVISOR, "compare moved %d ticks in one tick", (int)r.worst_slew);
+
+    // Belt load: the integral has to take the extra duty up with no
+    // steady-state error left
+    plant.load_mm_s = 60.0;
+    r = Run(&pid, &plant, setpoint, 3000, 0, setpoint * 0.02);
+    printf("load step -60 mm/s: dipped to %.1f, back within 2%% after %d ms, final %.1f\n",
+           r.low_mm_s, r.settle_ms, plant.speed_mm_s);
+    CHECK(r.low_mm_s >= setpoint - 40.0, "load dip to %.1f mm/s", r.low_mm_s);
+    CHECK(r.settle_ms <= 1500, "took %d ms to reject the load", r.settle_ms);
+    CHECK(fabs(plant.speed_mm_s - setpoint) < 1.0, "steady-state error under load %.2f mm/s",
+          plant.speed_mm_s - setpoint);
+}
+
+static void Test_Saturation(void) {
+    Pid_t pid;
+    Plant plant = { 0.0, 0.0, 0 };
+    Speed_PidInit(&pid, PERIOD_TICKS / SPEED_SLEW_DIVISOR);
+
+    // Heavy load: full duty only reaches 340 mm/s, so the output sits at
+    // the rail for two seconds with a large error
+    plant.load_mm_s = 160.0;
+    Run(&pid, &plant, CONVEYOR_MAX_SPEED_MM_S, 2000, 0, 1.0);
+    CHECK(Pid_GetOutput(&pid) == PERIOD_TICKS, "output %d not at the rail", (int)Pid_GetOutput(&pid));
+
+    // Setpoint back inside the reach: without anti-windup the stored
+    // integral would hold full duty and overshoot
+    int32_t setpoint = 250;
+    int leave_ms = -1;
+    for (int t = 0; t < 100 && leave_ms < 0; t += CONTROL_PERIOD_MS) {
+        Plant_Step(&plant, Pid_Update(&pid, setpoint, plant.measured));
+        if (Pid_GetOutput(&pid) < PERIOD_TICKS) {
+            leave_ms = t;
+        }
+    }
+    Response r = Run(&pid, &plant, setpoint, 3000, 0, setpoint * 0.02);
+    printf("saturated at %.1f mm/s -> %d mm/s: off the rail after %d ms, low %.1f, settled in %d ms\n",
+           plant.speed_mm_s, (int)setpoint, leave_ms, r.low_mm_s, r.settle_ms);
+    CHECK(leave_ms == 0, "output stayed at the rail for %d ms", leave_ms);
+    CHECK(r.low_mm_s >= setpoint * 0.90, "undershoot to %.1f mm/s", r.low_mm_s);
+    CHECK(r.settle_ms <= 1500, "took %d ms to settle after saturation", r.settle_ms);
+}
+
+static void Test_SlowSlew(void) {
+    Pid_t pid;
+    Plant plant = { 0.0, 0.0, 0 };
+    // 5 ticks per tick: the ramp takes seconds, and an integral that kept
+    // accumulating behind it would overshoot once it caught up
+    Speed_PidInit(&pid, 5);
+
+    int32_t setpoint = 200;
+    Response r = Run(&pid, &plant, setpoint, 8000, 0, setpoint * 0.02);
+    printf("step 0 -> %d mm/s at 5 ticks/tick: peak %.1f, settled in %d ms\n",
+           (int)setpoint, r.peak_mm_s, r.settle_ms);
+    CHECK(r.peak_mm_s <= setpoint * 1.05, "overshoot %.1f mm/s behind the slew limit", r.peak_mm_s - setpoint);
+    CHECK(r.settle_ms <= 4000, "took %d ms to settle behind the slew limit", r.settle_ms);
+    CHECK(r.worst_slew <= 5, "compare moved %d ticks in one tick", (int)r.worst_slew);
+}
+
+static void Bench_Update(void) {
+    Pid_t pid;
+    Speed_PidInit(&pid, PERIOD_TICKS / SPEED_SLEW_DIVISOR);
+
+    const int rounds = 10000000;
+    volatile int32_t sink = 0;
+    struct timespec t0, t1;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < rounds; i++) {
+        // Measurements that keep the output moving between the limits
+        sink = Pid_Update(&pid, 300, 200 + (i & 255));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+    printf("Pid_Update: %.2f ns on the host, %.5f%% of the %d ms control tick\n",
+           ns, ns * 100.0 / (CONTROL_PERIOD_MS * 1e6), CONTROL_PERIOD_MS);
+}
+
+int main(void) {
+    Test_Step();
+    Test_Saturation();
+    Test_SlowSlew();
+    Bench_Update();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,157 @@
+/**
+ * pwm_channels_test.c
+ *
+ *  Register-mock test for the PWM channel table and batched updates. The
+ *  timers and GPIO ports are test-owned structs; the test models the CCR
+ *  preload itself, latching each timer's CCRs into its "active" copy at an
+ *  update event unless UDIS holds it off. Checks the pin and channel setup,
+ *  that a batch lands on one update event, and that an e-stop inside an
+ *  open batch still zeroes every output.
+ *
+ *    gcc -std=gnu11 -Itests/stubs -IPWM -IGpio -IRcc -IIrq \
+ *        -o pwm_channels_test tests/pwm_channels_test.c && ./pwm_channels_test
+ */
+
+#include <stdio.h>
+
+#include "pwm.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+
+static PWM_TypeDef host_timers[3];
+static GPIO_Device host_gpio[4];
+Irq_NvicRegs irq_host_nvic;
+
+#undef TIMER1
+#undef TIMER3
+#undef TIMER4
+#define TIMER1 (&host_timers[0])
+#define TIMER3 (&host_timers[1])
+#define TIMER4 (&host_timers[2])
+#undef GPIO_PORT_DEVICE
+#define GPIO_PORT_DEVICE(PortName) (&host_gpio[(PortName) - GPIO_A])
+
+#include "../PWM/pwm.c"
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultState) {
+    (void)PortName; (void)PinNumber; (void)PinMode; (void)DefaultState;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// What each channel's output is actually doing, i.e. the latched CCR
+static uint32 active[PWM_CHANNEL_COUNT];
+
+static void UpdateEvent(uint8 Timer) {
+    if (pwm_timers[Timer].Regs->CR1 & TIM_CR1_UDIS) {
+        return;
+    }
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        if (pwm_channels[i].Timer == Timer) {
+            active[i] = *PWM_Ccr(i);
+        }
+    }
+}
+
+static void UpdateAll(void) {
+    UpdateEvent(PWM_TIM3);
+    UpdateEvent(PWM_TIM4);
+}
+
+static void TestInit(void) {
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        const PWM_ChannelDesc* ch = &pwm_channels[i];
+        const GPIO_Device* gpio = &host_gpio[ch->Port - GPIO_A];
+        PWM_TypeDef* tim = pwm_timers[ch->Timer].Regs;
+        uint32 afr = ch->Pin < 8 ? gpio->GPIO_AFRL : gpio->GPIO_AFRH;
+        uint32 ccmr = ch->Channel <= 2 ? tim->CCMR1 : tim->CCMR2;
+
+        CHECK(((afr >> ((ch->Pin & 7) * 4)) & 0xF) == ch->AltFunc,
+              "channel %u: pin %u not on AF%u", i, ch->Pin, ch->AltFunc);
+        CHECK((ccmr & TIM_CCMR_OC_MASK(ch->Channel)) ==
+              (TIM_CCMR_OCM_PWM1(ch->Channel) | TIM_CCMR_OCPE(ch->Channel)),
+              "channel %u: CCMR not PWM1 with preload", i);
+        CHECK(tim->CCER & TIM_CCER_CCE(ch->Channel), "channel %u: output not enabled", i);
+        CHECK(*PWM_Ccr(i) == 0, "channel %u: starts at %lu", i, (unsigned long)*PWM_Ccr(i));
+    }
+    CHECK(TIMER3->CCER == (TIM_CCER_CCE(1) | TIM_CCER_CCE(2) | TIM_CCER_CCE(3) | TIM_CCER_CCE(4)),
+          "TIM3 should drive all four channels, CCER = 0x%lx", (unsigned long)TIMER3->CCER);
+    CHECK(TIMER1->CR1 == 0, "unused TIM1 was started");
+    CHECK(TIMER3->CR1 & TIM_CR1_CEN && TIMER4->CR1 & TIM_CR1_CEN, "timers not running");
+    CHECK(!(TIMER3->CR1 & TIM_CR1_UDIS) && !(TIMER4->CR1 & TIM_CR1_UDIS), "UDIS left set by init");
+}
+
+static void TestBatch(void) {
+    PWM_BeginUpdate();
+    PWM_SetChannelPermille(PWM_CH_DIVERTER, 250);
+    UpdateAll();
+    PWM_SetChannelPermille(PWM_CH_BELT2, 500);
+    PWM_SetChannelPermille(PWM_CH_AUX1, 750);
+    UpdateAll();
+    CHECK(active[PWM_CH_DIVERTER] == 0 && active[PWM_CH_BELT2] == 0 && active[PWM_CH_AUX1] == 0,
+          "batch: a channel latched before PWM_EndUpdate");
+    PWM_EndUpdate();
+    UpdateAll();
+
+    uint32 period3 = PWM_GetChannelPeriodTicks(PWM_CH_DIVERTER);
+    uint32 period4 = PWM_GetChannelPeriodTicks(PWM_CH_BELT2);
+    CHECK(active[PWM_CH_DIVERTER] == period3 / 4, "batch: diverter %lu", (unsigned long)active[PWM_CH_DIVERTER]);
+    CHECK(active[PWM_CH_BELT2] == period4 / 2, "batch: belt 2 %lu", (unsigned long)active[PWM_CH_BELT2]);
+    CHECK(active[PWM_CH_AUX1] == period3 * 3 / 4, "batch: aux 1 %lu", (unsigned long)active[PWM_CH_AUX1]);
+}
+
+static void TestStopInsideBatch(void) {
+    PWM_SetChannelPermille(PWM_CH_MOTOR, 600);
+    PWM_SetChannelPermille(PWM_CH_AUX2, 900);
+    UpdateAll();
+
+    // Main is half way through a batch when the e-stop interrupt lands
+    PWM_BeginUpdate();
+    PWM_SetChannelPermille(PWM_CH_DIVERTER, 1000);
+    PWM_Stop();
+    CHECK(!(TIMER3->CR1 & TIM_CR1_UDIS) && !(TIMER4->CR1 & TIM_CR1_UDIS),
+          "stop: UDIS still set, the zeros would never latch");
+    UpdateAll();
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        CHECK(active[i] == 0, "stop: channel %u still at %lu", i, (unsigned long)active[i]);
+    }
+
+    // The rest of main's batch runs after the stop and must change nothing
+    PWM_SetChannelPermille(PWM_CH_BELT2, 800);
+    PWM_SetRaw(100);
+    PWM_RampTo(PWM_GetPeriodTicks());
+    PWM_EndUpdate();
+    UpdateAll();
+    for (uint8 i = 0; i < PWM_CHANNEL_COUNT; i++) {
+        CHECK(active[i] == 0, "stop: channel %u restarted at %lu", i, (unsigned long)active[i]);
+    }
+    CHECK(!PWM_IsRamping(), "stop: ramp started while stopped");
+
+    PWM_Release();
+    PWM_SetChannelPermille(PWM_CH_BELT2, 100);
+    UpdateAll();
+    CHECK(active[PWM_CH_BELT2] == PWM_GetChannelPeriodTicks(PWM_CH_BELT2) / 10,
+          "release: belt 2 at %lu", (unsigned long)active[PWM_CH_BELT2]);
+}
+
+int main(void) {
+    PWM_Init();
+    UpdateAll();
+
+    TestInit();
+    TestBatch();
+    TestStopInsideBatch();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
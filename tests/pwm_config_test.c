@@ -0,0 +1,341 @@
+/**
+ * pwm_config_test.c
+ *
+ *  Register-mock test for the motor PWM configuration. TIM3/TIM4 and the
+ *  GPIO ports are test-owned structs, and the test runs TIM3 itself one
+ *  84 MHz clock at a time: prescaler, up-counter, the PSC/ARR/CCR shadow
+ *  registers (latched at an update event unless UDIS holds it off, or
+ *  followed live where ARPE/OCxPE is clear) and the PWM mode 1 output.
+ *  Checks PWM_Configure()'s prescaler, period and frequency choices, the
+ *  PWM_SetDutyPermille()/PWM_SetRaw() scaling, that a duty change never
+ *  lands inside a running period, and that a frequency change made at any
+ *  point of a period finishes that period unchanged and switches cleanly
+ *  at the next one, or inside a batch at the first one after
+ *  PWM_EndUpdate().
+ *
+ *    gcc -std=gnu11 -O2 -Itests/stubs -IPWM -IGpio -IRcc -IIrq \
+ *        -o pwm_config_test tests/pwm_config_test.c && ./pwm_config_test
+ */
+
+#include <stdio.h>
+
+#include "pwm.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+
+static PWM_TypeDef host_timers[3];
+static GPIO_Device host_gpio[4];
+Irq_NvicRegs irq_host_nvic;
+
+#undef TIMER1
+#undef TIMER3
+#undef TIMER4
+#define TIMER1 (&host_timers[0])
+#define TIMER3 (&host_timers[1])
+#define TIMER4 (&host_timers[2])
+#undef GPIO_PORT_DEVICE
+#define GPIO_PORT_DEVICE(PortName) (&host_gpio[(PortName) - GPIO_A])
+
+#include "../PWM/pwm.c"
+
+#define HOST_TIMER_CLOCK_HZ 84000000UL
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return HOST_TIMER_CLOCK_HZ; }
+void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultState) {
+    (void)PortName; (void)PinNumber; (void)PinMode; (void)DefaultState;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// TIM3's internal state: what the counter and the outputs actually use
+static struct {
+    uint32 psc;
+    uint32 arr;
+    uint32 ccr3;
+    uint32 prescale_count;
+    uint32 cnt;
+} tim3;
+
+// The motor output, one entry per finished counter period
+#define MAX_PERIODS 16
+static struct {
+    uint32 clocks;
+    uint32 high;
+} periods[MAX_PERIODS];
+static unsigned period_count;
+static uint32 period_clocks;
+static uint32 period_high;
+
+static uint32 ActiveArr(void) {
+    return (TIMER3->CR1 & TIM_CR1_ARPE) ? tim3.arr : TIMER3->ARR;
+}
+
+static uint32 ActiveCcr3(void) {
+    return (TIMER3->CCMR2 & TIM_CCMR_OCPE(3)) ? tim3.ccr3 : TIMER3->CCR3;
+}
+
+// PSC is always preloaded; ARR and CCR3 only with ARPE and OC3PE
+static void Latch(void) {
+    tim3.psc = TIMER3->PSC;
+    tim3.arr = TIMER3->ARR;
+    tim3.ccr3 = TIMER3->CCR3;
+    tim3.prescale_count = 0;
+}
+
+// One timer clock. The counter wraps at the active ARR, or at 0xFFFF if it
+// is already past it; only the ARR match is an update event
+static void Clock(void) {
+    period_clocks++;
+    if (tim3.cnt < ActiveCcr3()) {
+        period_high++;
+    }
+    if (++tim3.prescale_count <= tim3.psc) {
+        return;
+    }
+    tim3.prescale_count = 0;
+    if (tim3.cnt == ActiveArr()) {
+        tim3.cnt = 0;
+        if (!(TIMER3->CR1 & TIM_CR1_UDIS)) {
+            Latch();
+        }
+        if (period_count < MAX_PERIODS) {
+            periods[period_count].clocks = period_clocks;
+            periods[period_count].high = period_high;
+            period_count++;
+        }
+        period_clocks = 0;
+        period_high = 0;
+    } else {
+        tim3.cnt = (tim3.cnt + 1) & 0xFFFF;
+    }
+}
+
+// Runs to the start of the next period and forgets the ones recorded so far
+static void SyncToPeriod(void) {
+    unsigned n = period_count;
+    while (period_count == n) {
+        Clock();
+    }
+    period_count = 0;
+}
+
+// A whole timer-clock count of one period at the current shadow setting
+static uint32 PeriodClocks(uint32 psc, uint32 arr) {
+    return (psc + 1) * (arr + 1);
+}
+
+static void RunPeriods(unsigned n) {
+    while (period_count < n) {
+        Clock();
+    }
+}
+
+static void TestInit(void) {
+    CHECK(TIMER3->CR1 & TIM_CR1_ARPE, "ARR not preloaded");
+    CHECK(TIMER3->CCMR2 & TIM_CCMR_OCPE(3), "CCR3 not preloaded");
+    CHECK(TIMER3->PSC == 0 && TIMER3->ARR == 4199, "default PSC %lu ARR %lu",
+          (unsigned long)TIMER3->PSC, (unsigned long)TIMER3->ARR);
+    CHECK(PWM_GetPeriodTicks() == 4200 && PWM_GetFrequency() == PWM_DEFAULT_FREQ_HZ,
+          "default %lu ticks at %lu Hz", (unsigned long)PWM_GetPeriodTicks(),
+          (unsigned long)PWM_GetFrequency());
+}
+
+static void TestConfigure(void) {
+    static const struct {
+        uint32 freq_hz;
+        uint32 min_steps;
+        uint8 result;
+        uint32 psc;
+        uint32 period;
+        uint32 actual_hz;
+    } cases[] = {
+        { 20000, 500, PWM_OK, 0, 4200, 20000 },
+        { 1000, 1000, PWM_OK, 1, 42000, 1000 },     // 84000 ticks: needs /2
+        { 50, 1000, PWM_OK, 25, 64615, 50 },        // /26, 64615.4 rounded
+        { 1282, 1, PWM_OK, 0, 65523, 1281 },        // just fits undivided
+        { 84000, 1000, PWM_OK, 0, 1000, 84000 },
+        { 30000, 2000, PWM_OK, 0, 2800, 30000 },
+        { 30000, 3000, PWM_NOK, 0, 0, 0 },          // 2800 steps
+        { 42000000, 2, PWM_OK, 0, 2, 42000000 },
+        { 84000000, 2, PWM_NOK, 0, 0, 0 },          // one tick is no PWM
+        { 100000, 1000, PWM_NOK, 0, 0, 0 },         // 840 steps is too coarse
+        { 0, 1, PWM_NOK, 0, 0, 0 },
+    };
+
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32 psc = TIMER3->PSC, arr = TIMER3->ARR, period = PWM_GetPeriodTicks();
+        uint8 result = PWM_Configure(cases[i].freq_hz, cases[i].min_steps);
+        CHECK(result == cases[i].result, "%lu Hz / %lu steps: result %u",
+              (unsigned long)cases[i].freq_hz, (unsigned long)cases[i].min_steps, result);
+        if (cases[i].result != PWM_OK) {
+            CHECK(TIMER3->PSC == psc && TIMER3->ARR == arr && PWM_GetPeriodTicks() == period,
+                  "%lu Hz: a refused setting changed the timer", (unsigned long)cases[i].freq_hz);
+            continue;
+        }
+        CHECK(TIMER3->PSC == cases[i].psc && TIMER3->ARR == cases[i].period - 1,
+              "%lu Hz: PSC %lu ARR %lu", (unsigned long)cases[i].freq_hz,
+              (unsigned long)TIMER3->PSC, (unsigned long)TIMER3->ARR);
+        CHECK(PWM_GetPeriodTicks() == cases[i].period && PWM_GetFrequency() == cases[i].actual_hz,
+              "%lu Hz: %lu ticks at %lu Hz", (unsigned long)cases[i].freq_hz,
+              (unsigned long)PWM_GetPeriodTicks(), (unsigned long)PWM_GetFrequency());
+        CHECK(!(TIMER3->CR1 & TIM_CR1_UDIS), "%lu Hz: UDIS left set", (unsigned long)cases[i].freq_hz);
+    }
+}
+
+static void TestDutyScaling(void) {
+    static const uint32 freqs[] = { 20000, 1000, 50, 30000 };
+    for (unsigned f = 0; f < sizeof(freqs) / sizeof(freqs[0]); f++) {
+        PWM_Configure(freqs[f], 1);
+        uint32 period = PWM_GetPeriodTicks();
+
+        unsigned bad = 0;
+        for (uint32 permille = 0; permille <= 1000; permille++) {
+            PWM_SetDutyPermille((uint16)permille);
+            uint32 expected = (permille * period + 500) / 1000;
+            uint32 got = PWM_GetRaw();
+            if (got != expected) {
+                if (!bad) {
+                    printf("%lu Hz: %lu permille -> %lu, expected %lu\n", (unsigned long)freqs[f],
+                           (unsigned long)permille, (unsigned long)got, (unsigned long)expected);
+                }
+                bad++;
+            }
+        }
+        CHECK(bad == 0, "%lu Hz: %u permille values off the nearest tick", (unsigned long)freqs[f], bad);
+
+        PWM_SetDutyPermille(1000);
+        CHECK(PWM_GetRaw() == period, "%lu Hz: 1000 permille is %lu of %lu", (unsigned long)freqs[f],
+              (unsigned long)PWM_GetRaw(), (unsigned long)period);
+        PWM_SetDutyPermille(1500);
+        CHECK(PWM_GetRaw() == period, "%lu Hz: 1500 permille not clamped", (unsigned long)freqs[f]);
+        PWM_SetDutyCycle(25);
+        CHECK(PWM_GetRaw() == (period + 2) / 4, "%lu Hz: 25%% is %lu", (unsigned long)freqs[f],
+              (unsigned long)PWM_GetRaw());
+
+        // Raw is full timer resolution: every tick is its own duty
+        PWM_SetRaw(1);
+        CHECK(PWM_GetRaw() == 1, "%lu Hz: raw 1 is %lu", (unsigned long)freqs[f], (unsigned long)PWM_GetRaw());
+        PWM_SetRaw(period - 1);
+        CHECK(PWM_GetRaw() == period - 1, "%lu Hz: raw %lu is %lu", (unsigned long)freqs[f],
+              (unsigned long)(period - 1), (unsigned long)PWM_GetRaw());
+        PWM_SetRaw(period + 100);
+        CHECK(PWM_GetRaw() == period, "%lu Hz: raw past the period not clamped", (unsigned long)freqs[f]);
+    }
+    PWM_Configure(PWM_DEFAULT_FREQ_HZ, PWM_DEFAULT_MIN_STEPS);
+}
+
+// A new duty written part way through a period only shows from the next one
+static void TestDutyPreload(void) {
+    static const uint32 phases[] = { 1, 1000, 2099, 2100, 3000, 4199 };
+    for (unsigned p = 0; p < sizeof(phases) / sizeof(phases[0]); p++) {
+        PWM_SetRaw(2100);
+        SyncToPeriod();
+        SyncToPeriod();
+        for (uint32 c = 0; c < phases[p]; c++) {
+            Clock();
+        }
+        PWM_SetRaw(1050);
+        RunPeriods(2);
+        CHECK(periods[0].clocks == 4200 && periods[0].high == 2100,
+              "duty at clock %lu: running period became %lu/%lu", (unsigned long)phases[p],
+              (unsigned long)periods[0].high, (unsigned long)periods[0].clocks);
+        CHECK(periods[1].clocks == 4200 && periods[1].high == 1050,
+              "duty at clock %lu: next period %lu/%lu", (unsigned long)phases[p],
+              (unsigned long)periods[1].high, (unsigned long)periods[1].clocks);
+    }
+}
+
+// At any point of a period the change finishes the old one untouched, then
+// every later period is the new frequency at the same duty fraction
+static void TestFrequencyChange(uint32 from_hz, uint32 to_hz) {
+    unsigned glitches = 0;
+    for (uint32 phase = 0; phase < 4200; phase += 97) {
+        PWM_Configure(from_hz, 1);
+        PWM_SetDutyPermille(300);
+        uint32 old_ccr = PWM_GetRaw();
+        SyncToPeriod();
+        SyncToPeriod();
+        uint32 old_clocks = PeriodClocks(tim3.psc, tim3.arr);
+        uint32 old_high = old_ccr * (tim3.psc + 1);
+
+        uint32 start = period_clocks;
+        while (period_clocks - start < phase * old_clocks / 4200) {
+            Clock();
+        }
+        CHECK(PWM_Configure(to_hz, 1) == PWM_OK, "%lu Hz refused", (unsigned long)to_hz);
+        uint32 new_clocks = PeriodClocks(TIMER3->PSC, TIMER3->ARR);
+        uint32 new_high = PWM_GetRaw() * (TIMER3->PSC + 1);
+        RunPeriods(4);
+
+        int ok = periods[0].clocks == old_clocks && periods[0].high == old_high;
+        for (unsigned i = 1; i < 4; i++) {
+            ok = ok && periods[i].clocks == new_clocks && periods[i].high == new_high;
+        }
+        if (!ok) {
+            if (!glitches) {
+                printf("%lu -> %lu Hz at %lu/4200 of a period:", (unsigned long)from_hz,
+                       (unsigned long)to_hz, (unsigned long)phase);
+                for (unsigned i = 0; i < 4; i++) {
+                    printf(" %lu/%lu", (unsigned long)periods[i].high, (unsigned long)periods[i].clocks);
+                }
+                printf(" (expected %lu/%lu then %lu/%lu)\n", (unsigned long)old_high,
+                       (unsigned long)old_clocks, (unsigned long)new_high, (unsigned long)new_clocks);
+            }
+            glitches++;
+        }
+    }
+    printf("%lu -> %lu Hz: %u glitched periods\n", (unsigned long)from_hz, (unsigned long)to_hz, glitches);
+    CHECK(glitches == 0, "%lu -> %lu Hz: %u changes glitched", (unsigned long)from_hz,
+          (unsigned long)to_hz, glitches);
+}
+
+// Reconfiguring inside a batch leaves the batch open
+static void TestConfigureInBatch(void) {
+    PWM_Configure(PWM_DEFAULT_FREQ_HZ, 1);
+    PWM_SetRaw(2100);
+    SyncToPeriod();
+
+    PWM_BeginUpdate();
+    PWM_Configure(10000, 1);
+    PWM_SetRaw(6300);
+    CHECK(TIMER3->CR1 & TIM_CR1_UDIS, "batch: PWM_Configure ended the batch");
+    RunPeriods(2);
+    CHECK(periods[1].clocks == 4200 && periods[1].high == 2100,
+          "batch: period %lu/%lu latched before PWM_EndUpdate", (unsigned long)periods[1].high,
+          (unsigned long)periods[1].clocks);
+    PWM_EndUpdate();
+    SyncToPeriod();
+    RunPeriods(1);
+    CHECK(periods[0].clocks == 8400 && periods[0].high == 6300,
+          "batch: period %lu/%lu after PWM_EndUpdate", (unsigned long)periods[0].high,
+          (unsigned long)periods[0].clocks);
+}
+
+int main(void) {
+    PWM_Init();
+    if (TIMER3->EGR & TIM_EGR_UG) {
+        Latch();
+        TIMER3->EGR = 0;
+    }
+
+    TestInit();
+    TestConfigure();
+    TestDutyScaling();
+    TestDutyPreload();
+    TestFrequencyChange(20000, 40000);
+    TestFrequencyChange(20000, 1000);
+    TestFrequencyChange(1000, 20000);
+    TestConfigureInBatch();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,221 @@
+/**
+ * pwm_ramp_test.c
+ *
+ *  Host simulation of the motor ramp generator. TIM3/TIM4 and the GPIO
+ *  ports are test-owned structs, and each PWM period is one call of
+ *  TIM3_IRQHandler with UIF set. Checks the linear and S-curve shapes, that
+ *  the interrupt switches itself off when the ramp lands, the stop latch,
+ *  and reports the per-step ISR cost.
+ *
+ *    gcc -std=gnu11 -O2 -Itests/stubs -IPWM -IGpio -IRcc -IIrq \
+ *        -o pwm_ramp_test tests/pwm_ramp_test.c && ./pwm_ramp_test
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "pwm.h"
+#include "Gpio_Pins.h"
+#include "Irq.h"
+
+static PWM_TypeDef host_timers[3];
+static GPIO_Device host_gpio[4];
+Irq_NvicRegs irq_host_nvic;
+
+#undef TIMER1
+#undef TIMER3
+#undef TIMER4
+#define TIMER1 (&host_timers[0])
+#define TIMER3 (&host_timers[1])
+#define TIMER4 (&host_timers[2])
+#undef GPIO_PORT_DEVICE
+#define GPIO_PORT_DEVICE(PortName) (&host_gpio[(PortName) - GPIO_A])
+
+#include "../PWM/pwm.c"
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Gpio_Init(uint8 PortName, uint8 PinNumber, uint8 PinMode, uint8 DefaultState) {
+    (void)PortName; (void)PinNumber; (void)PinMode; (void)DefaultState;
+}
+
+#define RAMP_MS 250UL
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// One PWM period: the update event latches CCR and raises UIF
+static void UpdateEvent(void) {
+    TIMER3->SR |= TIM_SR_UIF;
+    if (TIMER3->DIER & TIM_DIER_UIE) {
+        TIM3_IRQHandler();
+    }
+}
+
+// Runs a ramp to completion; returns the update events it took and keeps
+// the CCR3 trace
+static uint32 RunRamp(uint32 *trace, uint32 max_steps) {
+    uint32 steps = 0;
+    while (PWM_IsRamping() && steps < max_steps) {
+        UpdateEvent();
+        trace[steps++] = TIMER3->CCR3;
+    }
+    return steps;
+}
+
+static void TestLinear(uint32 *trace) {
+    uint32 period = PWM_GetPeriodTicks();
+    uint32 expected = RAMP_MS * PWM_GetFrequency() / 1000;
+
+    PWM_ConfigureRamp(RAMP_MS, PWM_RAMP_LINEAR);
+    PWM_SetRaw(0);
+    PWM_RampTo(period);
+    CHECK(TIMER3->DIER & TIM_DIER_UIE, "linear: update interrupt not enabled");
+    uint32 steps = RunRamp(trace, 2 * expected);
+
+    printf("linear 0..%lu: %lu steps (expected %lu)\n",
+           (unsigned long)period, (unsigned long)steps, (unsigned long)expected);
+    CHECK(steps >= expected - 1 && steps <= expected + 1, "linear: %lu steps", (unsigned long)steps);
+    CHECK(trace[steps - 1] == period, "linear: ended at %lu", (unsigned long)trace[steps - 1]);
+    CHECK(!(TIMER3->DIER & TIM_DIER_UIE), "linear: interrupt left on after landing");
+
+    uint32 max_step = 0;
+    for (uint32 i = 1; i < steps; i++) {
+        CHECK(trace[i] >= trace[i - 1], "linear: step %lu went backwards", (unsigned long)i);
+        uint32 d = trace[i] - trace[i - 1];
+        if (d > max_step) max_step = d;
+    }
+    CHECK(max_step <= period / expected + 2, "linear: largest step %lu ticks", (unsigned long)max_step);
+    CHECK(abs((int)trace[steps / 2] - (int)(period / 2)) <= (int)(period / 100),
+          "linear: half way at %lu", (unsigned long)trace[steps / 2]);
+}
+
+static void TestSCurve(uint32 *trace) {
+    uint32 period = PWM_GetPeriodTicks();
+    uint32 expected = RAMP_MS * PWM_GetFrequency() / 1000;
+
+    PWM_ConfigureRamp(RAMP_MS, PWM_RAMP_SCURVE);
+    PWM_SetRaw(period);
+    PWM_RampTo(0);
+    uint32 steps = RunRamp(trace, 2 * expected);
+
+    uint32 first_tenth = period - trace[steps / 10];
+    uint32 middle_tenth = trace[steps * 9 / 20] - trace[steps * 11 / 20];
+    printf("s-curve %lu..0: %lu steps, first 10%% of the time moves %lu ticks, middle 10%% moves %lu\n",
+           (unsigned long)period, (unsigned long)steps, (unsigned long)first_tenth,
+           (unsigned long)middle_tenth);
+    CHECK(steps >= expected - 1 && steps <= expected + 1, "s-curve: %lu steps", (unsigned long)steps);
+    CHECK(trace[steps - 1] == 0, "s-curve: ended at %lu", (unsigned long)trace[steps - 1]);
+    for (uint32 i = 1; i < steps; i++) {
+        CHECK(trace[i] <= trace[i - 1], "s-curve: step %lu went backwards", (unsigned long)i);
+    }
+    // Smoothstep: 2.8% of the distance in the first tenth, ~15% in the middle one
+    CHECK(first_tenth < period * 4 / 100, "s-curve: start not eased (%lu)", (unsigned long)first_tenth);
+    CHECK(middle_tenth > period * 13 / 100, "s-curve: middle too flat (%lu)", (unsigned long)middle_tenth);
+    CHECK(abs((int)trace[steps / 2] - (int)(period / 2)) <= (int)(period / 100),
+          "s-curve: half way at %lu", (unsigned long)trace[steps / 2]);
+}
+
+// A new target part way through continues from the current CCR
+static void TestRetarget(uint32 *trace) {
+    uint32 period = PWM_GetPeriodTicks();
+
+    PWM_ConfigureRamp(RAMP_MS, PWM_RAMP_SCURVE);
+    PWM_SetRaw(0);
+    PWM_RampTo(period);
+    for (int i = 0; i < 1000; i++) {
+        UpdateEvent();
+    }
+    uint32 before = TIMER3->CCR3;
+    PWM_RampTo(period / 4);
+    UpdateEvent();
+    CHECK(abs((int)TIMER3->CCR3 - (int)before) <= (int)(period / 100),
+          "retarget: jumped from %lu to %lu", (unsigned long)before, (unsigned long)TIMER3->CCR3);
+    uint32 steps = RunRamp(trace, 10000);
+    CHECK(trace[steps - 1] == period / 4, "retarget: ended at %lu", (unsigned long)trace[steps - 1]);
+
+    // A direct write wins over a running ramp
+    PWM_RampTo(period);
+    UpdateEvent();
+    PWM_SetRaw(123);
+    UpdateEvent();
+    CHECK(TIMER3->CCR3 == 123 && !PWM_IsRamping(), "direct write did not cancel the ramp");
+}
+
+static void TestStopLatch(void) {
+    uint32 period = PWM_GetPeriodTicks();
+
+    PWM_SetRaw(0);
+    PWM_RampTo(period);
+    for (int i = 0; i < 100; i++) {
+        UpdateEvent();
+    }
+    PWM_Stop();
+    CHECK(TIMER3->CCR3 == 0, "stop: CCR3 = %lu", (unsigned long)TIMER3->CCR3);
+    CHECK(!(TIMER3->DIER & TIM_DIER_UIE) && !PWM_IsRamping(), "stop: ramp still running");
+
+    // An update already pending when the stop landed must not write CCR3
+    TIMER3->SR |= TIM_SR_UIF;
+    TIM3_IRQHandler();
+    CHECK(TIMER3->CCR3 == 0, "stop: stale update wrote %lu", (unsigned long)TIMER3->CCR3);
+
+    // A control step that was under way when the stop landed
+    PWM_RampTo(period);
+    PWM_SetRaw(period / 2);
+    PWM_SetDutyPermille(500);
+    CHECK(TIMER3->CCR3 == 0 && !PWM_IsRamping(), "stop: latched motor was written");
+
+    PWM_Release();
+    PWM_SetRaw(77);
+    CHECK(TIMER3->CCR3 == 77, "release: CCR3 = %lu", (unsigned long)TIMER3->CCR3);
+}
+
+// Host nanoseconds per ramp step, as a relative figure: the step is a
+// table lookup, one multiply and a shift, no division
+static void ReportIsrCost(void) {
+    uint32 period = PWM_GetPeriodTicks();
+    const uint32 rounds = 2000;
+    uint32 calls = 0;
+    struct timespec t0, t1;
+
+    PWM_ConfigureRamp(RAMP_MS, PWM_RAMP_SCURVE);
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32 r = 0; r < rounds; r++) {
+        PWM_SetRaw(0);
+        PWM_RampTo(period);
+        while (PWM_IsRamping()) {
+            TIMER3->SR |= TIM_SR_UIF;
+            TIM3_IRQHandler();
+            calls++;
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / calls;
+    printf("ISR cost: %.1f ns per step on the host over %lu steps\n", ns, (unsigned long)calls);
+    CHECK(ns < 200.0, "ISR step took %.1f ns", ns);
+}
+
+int main(void) {
+    static uint32 trace[20000];
+
+    PWM_Init();
+    CHECK(irq_host_nvic.ISER[0] & (1UL << PWM_IRQ_NUM), "TIM3 interrupt not enabled in the NVIC");
+    CHECK(TIMER3->DIER == 0, "update interrupt on before any ramp");
+
+    TestLinear(trace);
+    TestSCurve(trace);
+    TestRetarget(trace);
+    TestStopLatch();
+    ReportIsrCost();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,352 @@
+/**
+ * rcc_clock_test.c
+ *
+ *  Register-mock test for the clock tree setup. RCC_CR, RCC_PLLCFGR,
+ *  RCC_CFGR and FLASH_ACR are test-owned words reached through a function,
+ *  so every access first commits the store the previous one made: the mock
+ *  raises the ready flags (HSE and PLL can be told to fail), follows SW
+ *  with SWS once the source is ready, and checks the hardware rules at
+ *  every step. SYSCLK must stay within the flash wait states and PCLK1
+ *  within 42 MHz, the PLL is only reprogrammed while off and only started
+ *  with legal VCO and output frequencies, and SYSCLK only switches to a
+ *  source that is ready. Also checks the PLL factors, wait states,
+ *  prescalers and published bus frequencies for the F401's targets, and
+ *  what an HSE or PLL failure leaves behind.
+ *
+ *    gcc -std=gnu11 -Itests/stubs -IRcc -o rcc_clock_test tests/rcc_clock_test.c && ./rcc_clock_test
+ */
+
+#include <stdio.h>
+
+#include "Std_Types.h"
+#include "Rcc_Private.h"
+
+enum { HOST_CR, HOST_PLLCFGR, HOST_CFGR, HOST_ACR, HOST_REG_COUNT };
+static const char* const host_reg_names[HOST_REG_COUNT] = { "RCC_CR", "RCC_PLLCFGR", "RCC_CFGR", "FLASH_ACR" };
+
+static volatile uint32 host_regs[HOST_REG_COUNT];
+static uint32 host_seen[HOST_REG_COUNT];
+static unsigned host_writes;
+static unsigned host_violations;
+static int host_hse_works;
+static int host_pll_locks;
+static uint32 host_hse_hz;
+
+static volatile uint32* HostReg(unsigned Reg);
+
+#undef RCC_CR
+#undef RCC_PLLCFGR
+#undef RCC_CFGR
+#undef FLASH_ACR
+#define RCC_CR (*HostReg(HOST_CR))
+#define RCC_PLLCFGR (*HostReg(HOST_PLLCFGR))
+#define RCC_CFGR (*HostReg(HOST_CFGR))
+#define FLASH_ACR (*HostReg(HOST_ACR))
+
+#include "../Rcc/Rcc.c"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define VIOLATION(...) do { \
+    if (!host_violations) { printf("  rule broken: "); printf(__VA_ARGS__); printf("\n"); } \
+    host_violations++; \
+} while (0)
+
+#define CR_BIT(bit) (1UL << (bit))
+
+static uint32 PllInputHz(uint32 Pllcfgr) {
+    uint32 SourceHz = (Pllcfgr & CR_BIT(RCC_PLLCFGR_SRC)) ? host_hse_hz : RCC_HSI_HZ;
+    uint32 M = (Pllcfgr >> RCC_PLLCFGR_M_POS) & 0x3F;
+    return M ? SourceHz / M : 0;
+}
+
+static uint32 PllVcoHz(uint32 Pllcfgr) {
+    return PllInputHz(Pllcfgr) * ((Pllcfgr >> RCC_PLLCFGR_N_POS) & 0x1FF);
+}
+
+static uint32 PllOutHz(uint32 Pllcfgr) {
+    return PllVcoHz(Pllcfgr) / ((((Pllcfgr >> RCC_PLLCFGR_P_POS) & 0x3) + 1) * 2);
+}
+
+// What the core is running from right now
+static uint32 HostSysclkHz(void) {
+    switch (host_regs[HOST_CFGR] & RCC_CFGR_SWS_MSK) {
+        case 0x0UL << 2: return RCC_HSI_HZ;
+        case 0x1UL << 2: return host_hse_hz;
+        case RCC_CFGR_SWS_PLL: return PllOutHz(host_regs[HOST_PLLCFGR]);
+        default: return 0;
+    }
+}
+
+static uint32 HostApbHz(unsigned Pos) {
+    uint32 Ppre = (host_regs[HOST_CFGR] >> Pos) & RCC_CFGR_PPRE_MSK;
+    return (Ppre & 0x4) ? HostSysclkHz() >> ((Ppre & 0x3) + 1) : HostSysclkHz();
+}
+
+// The store the previous access made, as the hardware sees it
+static void HostCommit(void) {
+    for (unsigned r = 0; r < HOST_REG_COUNT; r++) {
+        uint32 Old = host_seen[r];
+        uint32 New = host_regs[r];
+        if (New == Old) {
+            continue;
+        }
+        host_writes++;
+
+        if (r == HOST_PLLCFGR && (host_regs[HOST_CR] & CR_BIT(RCC_CR_PLLON))) {
+            VIOLATION("PLLCFGR 0x%08lx written with the PLL on", (unsigned long)New);
+        }
+        if (r == HOST_CR) {
+            uint32 Cr = New;
+            Cr = (Cr & CR_BIT(RCC_CR_HSION)) ? Cr | CR_BIT(RCC_CR_HSIRDY) : Cr & ~CR_BIT(RCC_CR_HSIRDY);
+            Cr = ((Cr & CR_BIT(RCC_CR_HSEON)) && host_hse_works) ? Cr | CR_BIT(RCC_CR_HSERDY)
+                                                                : Cr & ~CR_BIT(RCC_CR_HSERDY);
+            if ((Cr & CR_BIT(RCC_CR_PLLON)) && !(Old & CR_BIT(RCC_CR_PLLON))) {
+                uint32 Pll = host_regs[HOST_PLLCFGR];
+                if (PllInputHz(Pll) < 1000000UL || PllInputHz(Pll) > 2000000UL) {
+                    VIOLATION("PLL started with a %lu Hz input", (unsigned long)PllInputHz(Pll));
+                }
+                if (PllVcoHz(Pll) < RCC_VCO_MIN_HZ || PllVcoHz(Pll) > RCC_VCO_MAX_HZ) {
+                    VIOLATION("PLL started with a %lu Hz VCO", (unsigned long)PllVcoHz(Pll));
+                }
+                if (PllOutHz(Pll) > RCC_MAX_SYSCLK_HZ) {
+                    VIOLATION("PLL started at %lu Hz", (unsigned long)PllOutHz(Pll));
+                }
+                uint32 Q = (Pll >> RCC_PLLCFGR_Q_POS) & 0xF;
+                if (Q < 2 || PllVcoHz(Pll) / Q > RCC_USB_HZ) {
+                    VIOLATION("PLL48CK at Q = %lu", (unsigned long)Q);
+                }
+                if ((Pll & CR_BIT(RCC_PLLCFGR_SRC)) && !(Cr & CR_BIT(RCC_CR_HSERDY))) {
+                    VIOLATION("PLL started from an HSE that isn't ready");
+                }
+            }
+            uint8 Locks = host_pll_locks &&
+                          (!(host_regs[HOST_PLLCFGR] & CR_BIT(RCC_PLLCFGR_SRC)) || (Cr & CR_BIT(RCC_CR_HSERDY)));
+            Cr = ((Cr & CR_BIT(RCC_CR_PLLON)) && Locks) ? Cr | CR_BIT(RCC_CR_PLLRDY)
+                                                         : Cr & ~CR_BIT(RCC_CR_PLLRDY);
+            host_regs[HOST_CR] = Cr;
+        }
+        if (r == HOST_CFGR) {
+            // The switch only happens once the selected source is ready
+            uint32 Sw = New & RCC_CFGR_SW_MSK;
+            static const uint8 ReadyBit[3] = { RCC_CR_HSIRDY, RCC_CR_HSERDY, RCC_CR_PLLRDY };
+            if (Sw < 3 && (host_regs[HOST_CR] & CR_BIT(ReadyBit[Sw]))) {
+                host_regs[HOST_CFGR] = (New & ~RCC_CFGR_SWS_MSK) | (Sw << 2);
+            } else if (Sw != ((Old & RCC_CFGR_SW_MSK))) {
+                VIOLATION("SYSCLK switched to source %lu before it was ready", (unsigned long)Sw);
+            }
+        }
+        host_seen[r] = host_regs[r];
+
+        // The rules that hold after every store
+        uint32 Latency = host_regs[HOST_ACR] & FLASH_ACR_LATENCY_MSK;
+        if (HostSysclkHz() > (Latency + 1) * RCC_FLASH_WS_STEP_HZ) {
+            VIOLATION("%s write: SYSCLK %lu Hz on %lu wait state(s)", host_reg_names[r],
+                      (unsigned long)HostSysclkHz(), (unsigned long)Latency);
+        }
+        if (HostApbHz(RCC_CFGR_PPRE1_POS) > RCC_MAX_PCLK1_HZ) {
+            VIOLATION("%s write: PCLK1 at %lu Hz", host_reg_names[r], (unsigned long)HostApbHz(RCC_CFGR_PPRE1_POS));
+        }
+        if (host_regs[HOST_CFGR] & RCC_CFGR_HPRE_MSK) {
+            VIOLATION("AHB prescaler 0x%lx", (unsigned long)((host_regs[HOST_CFGR] >> 4) & 0xF));
+        }
+    }
+}
+
+static volatile uint32* HostReg(unsigned Reg) {
+    HostCommit();
+    return &host_regs[Reg];
+}
+
+// Reset values, with the getters back to their power-on state
+static void HostReset(void) {
+    host_regs[HOST_CR] = CR_BIT(RCC_CR_HSION) | CR_BIT(RCC_CR_HSIRDY);
+    host_regs[HOST_PLLCFGR] = 0x24003010UL;
+    host_regs[HOST_CFGR] = 0;
+    host_regs[HOST_ACR] = 0;
+    for (unsigned r = 0; r < HOST_REG_COUNT; r++) {
+        host_seen[r] = host_regs[r];
+    }
+    host_hse_works = 1;
+    host_pll_locks = 1;
+    host_hse_hz = 8000000UL;
+    rcc_sysclk_hz = RCC_HSI_HZ;
+    rcc_pclk1_hz = RCC_HSI_HZ;
+    rcc_pclk2_hz = RCC_HSI_HZ;
+    rcc_apb1_divided = 0;
+    rcc_apb2_divided = 0;
+}
+
+static uint8 Configure(uint8 Source, uint32 SourceHz, uint32 SysclkHz) {
+    Rcc_ClockConfig Config = { .Source = Source, .SourceHz = SourceHz, .SysclkHz = SysclkHz };
+    host_hse_hz = (Source == RCC_CLOCK_HSE) ? SourceHz : host_hse_hz;
+    host_violations = 0;
+    host_writes = 0;
+    uint8 Result = Rcc_ConfigureClocks(&Config);
+    HostCommit();
+    return Result;
+}
+
+// Hardware state and published frequencies for a clock that came up
+static void CheckRunning(const char* Name, uint32 SysclkHz, uint32 Latency) {
+    uint32 Cfgr = host_regs[HOST_CFGR];
+    uint32 Acr = host_regs[HOST_ACR];
+    uint32 Pclk1 = HostApbHz(RCC_CFGR_PPRE1_POS);
+    uint32 Pclk2 = HostApbHz(RCC_CFGR_PPRE2_POS);
+
+    CHECK(host_violations == 0, "%s: %u rule(s) broken on the way", Name, host_violations);
+    CHECK((Cfgr & RCC_CFGR_SWS_MSK) == RCC_CFGR_SWS_PLL, "%s: SYSCLK not on the PLL", Name);
+    CHECK(HostSysclkHz() == SysclkHz, "%s: PLL gives %lu Hz", Name, (unsigned long)HostSysclkHz());
+    CHECK((Acr & FLASH_ACR_LATENCY_MSK) == Latency, "%s: %lu wait state(s), expected %lu", Name,
+          (unsigned long)(Acr & FLASH_ACR_LATENCY_MSK), (unsigned long)Latency);
+    CHECK((Acr & (CR_BIT(FLASH_ACR_PRFTEN) | CR_BIT(FLASH_ACR_ICEN) | CR_BIT(FLASH_ACR_DCEN))) ==
+          (CR_BIT(FLASH_ACR_PRFTEN) | CR_BIT(FLASH_ACR_ICEN) | CR_BIT(FLASH_ACR_DCEN)),
+          "%s: prefetch and caches not on, ACR 0x%lx", Name, (unsigned long)Acr);
+    CHECK(Pclk1 == (SysclkHz > RCC_MAX_PCLK1_HZ ? SysclkHz / 2 : SysclkHz),
+          "%s: PCLK1 %lu Hz, slower than it needs to be", Name, (unsigned long)Pclk1);
+    CHECK(Pclk2 == SysclkHz, "%s: PCLK2 %lu Hz", Name, (unsigned long)Pclk2);
+
+    CHECK(Rcc_GetSysclkHz() == SysclkHz && Rcc_GetHclkHz() == SysclkHz,
+          "%s: published SYSCLK %lu HCLK %lu", Name, (unsigned long)Rcc_GetSysclkHz(),
+          (unsigned long)Rcc_GetHclkHz());
+    CHECK(Rcc_GetPclk1Hz() == Pclk1 && Rcc_GetPclk2Hz() == Pclk2, "%s: published PCLK1 %lu PCLK2 %lu",
+          Name, (unsigned long)Rcc_GetPclk1Hz(), (unsigned long)Rcc_GetPclk2Hz());
+    uint32 Tim1 = (Pclk1 == HostSysclkHz()) ? Pclk1 : Pclk1 * 2;
+    CHECK(Rcc_GetTimerClockHz(RCC_APB1) == Tim1 && Rcc_GetTimerClockHz(RCC_APB2) == Pclk2,
+          "%s: timer clocks %lu/%lu", Name, (unsigned long)Rcc_GetTimerClockHz(RCC_APB1),
+          (unsigned long)Rcc_GetTimerClockHz(RCC_APB2));
+}
+
+static void TestInit(void) {
+    HostReset();
+    host_violations = 0;
+    Rcc_Init();
+    HostCommit();
+    CheckRunning("Rcc_Init", 84000000UL, 2);
+
+    // HSI 16 MHz / 8 = 2 MHz, x168 = 336 MHz, /4 = 84 MHz, /7 = 48 MHz
+    uint32 Pll = host_regs[HOST_PLLCFGR];
+    CHECK((Pll & 0x3F) == 8 && ((Pll >> RCC_PLLCFGR_N_POS) & 0x1FF) == 168 &&
+          ((Pll >> RCC_PLLCFGR_P_POS) & 0x3) == 1 && ((Pll >> RCC_PLLCFGR_Q_POS) & 0xF) == 7 &&
+          !(Pll & CR_BIT(RCC_PLLCFGR_SRC)), "Rcc_Init: PLLCFGR 0x%08lx", (unsigned long)Pll);
+    printf("Rcc_Init: %u register writes, PLLCFGR 0x%08lx, CFGR 0x%08lx, ACR 0x%lx\n", host_writes,
+           (unsigned long)Pll, (unsigned long)host_regs[HOST_CFGR], (unsigned long)host_regs[HOST_ACR]);
+}
+
+static void TestTargets(void) {
+    static const struct {
+        uint8 source;
+        uint32 source_hz;
+        uint32 sysclk_hz;
+        uint32 latency;     // RM0368 table 5, 2.7-3.6 V
+    } cases[] = {
+        { RCC_CLOCK_HSE, 8000000UL, 84000000UL, 2 },
+        { RCC_CLOCK_HSE, 25000000UL, 84000000UL, 2 },   // 1 MHz PLL input
+        { RCC_CLOCK_HSI, 0, 60000000UL, 1 },
+        { RCC_CLOCK_HSI, 0, 48000000UL, 1 },
+        { RCC_CLOCK_HSI, 0, 42000000UL, 1 },            // APB1 undivided
+        { RCC_CLOCK_HSI, 0, 30000000UL, 0 },
+        { RCC_CLOCK_HSI, 0, 24000000UL, 0 },
+    };
+
+    HostReset();
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        char Name[48];
+        snprintf(Name, sizeof(Name), "%s %lu MHz -> %lu MHz", cases[i].source == RCC_CLOCK_HSE ? "HSE" : "HSI",
+                 (unsigned long)((cases[i].source == RCC_CLOCK_HSE ? cases[i].source_hz : RCC_HSI_HZ) / 1000000UL),
+                 (unsigned long)(cases[i].sysclk_hz / 1000000UL));
+        // Each from the previous one's clock, so the down steps are covered
+        CHECK(Configure(cases[i].source, cases[i].source_hz, cases[i].sysclk_hz) == RCC_OK, "%s: refused", Name);
+        CheckRunning(Name, cases[i].sysclk_hz, cases[i].latency);
+    }
+
+    // Back up to full speed from the slowest setting
+    CHECK(Configure(RCC_CLOCK_HSI, 0, 84000000UL) == RCC_OK, "24 -> 84 MHz: refused");
+    CheckRunning("24 -> 84 MHz", 84000000UL, 2);
+}
+
+static void TestRefused(void) {
+    static const struct {
+        uint8 source;
+        uint32 source_hz;
+        uint32 sysclk_hz;
+    } cases[] = {
+        { RCC_CLOCK_HSI, 0, 100000000UL },      // over the F401's limit
+        { RCC_CLOCK_HSI, 0, 0 },
+        { RCC_CLOCK_HSE, 2500000UL, 84000000UL },   // no whole-MHz PLL input
+        { RCC_CLOCK_HSE, 1000000UL, 84000000UL },
+        { RCC_CLOCK_HSI, 0, 84500000UL },
+    };
+
+    HostReset();
+    Configure(RCC_CLOCK_HSI, 0, 84000000UL);
+    for (unsigned i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        uint32 Before[HOST_REG_COUNT];
+        for (unsigned r = 0; r < HOST_REG_COUNT; r++) {
+            Before[r] = host_regs[r];
+        }
+        CHECK(Configure(cases[i].source, cases[i].source_hz, cases[i].sysclk_hz) == RCC_NOK,
+              "%lu Hz from %lu Hz accepted", (unsigned long)cases[i].sysclk_hz, (unsigned long)cases[i].source_hz);
+        CHECK(host_writes == 0, "%lu Hz: refused, but wrote %u register(s)", (unsigned long)cases[i].sysclk_hz,
+              host_writes);
+        for (unsigned r = 0; r < HOST_REG_COUNT; r++) {
+            CHECK(host_regs[r] == Before[r], "%lu Hz: %s changed", (unsigned long)cases[i].sysclk_hz,
+                  host_reg_names[r]);
+        }
+        CHECK(Rcc_GetSysclkHz() == 84000000UL, "%lu Hz: published SYSCLK %lu", (unsigned long)cases[i].sysclk_hz,
+              (unsigned long)Rcc_GetSysclkHz());
+    }
+}
+
+static void TestFailures(void) {
+    // A dead crystal: the HSI PLL setting keeps running
+    HostReset();
+    Configure(RCC_CLOCK_HSI, 0, 84000000UL);
+    host_hse_works = 0;
+    CHECK(Configure(RCC_CLOCK_HSE, 8000000UL, 84000000UL) == RCC_NOK, "dead HSE: accepted");
+    CHECK(host_violations == 0, "dead HSE: %u rule(s) broken", host_violations);
+    CHECK(!(host_regs[HOST_CR] & CR_BIT(RCC_CR_HSEON)), "dead HSE: left HSEON set");
+    CHECK((host_regs[HOST_CFGR] & RCC_CFGR_SWS_MSK) == RCC_CFGR_SWS_PLL && HostSysclkHz() == 84000000UL,
+          "dead HSE: SYSCLK moved to %lu Hz", (unsigned long)HostSysclkHz());
+    CHECK(Rcc_GetSysclkHz() == 84000000UL, "dead HSE: published SYSCLK %lu", (unsigned long)Rcc_GetSysclkHz());
+
+    // A PLL that won't lock: plain HSI, and the getters say so
+    host_hse_works = 1;
+    host_pll_locks = 0;
+    CHECK(Configure(RCC_CLOCK_HSE, 8000000UL, 84000000UL) == RCC_NOK, "no lock: accepted");
+    CHECK(host_violations == 0, "no lock: %u rule(s) broken", host_violations);
+    CHECK((host_regs[HOST_CFGR] & RCC_CFGR_SWS_MSK) == 0, "no lock: SYSCLK not on HSI");
+    CHECK(!(host_regs[HOST_CR] & (CR_BIT(RCC_CR_PLLON) | CR_BIT(RCC_CR_HSEON))), "no lock: PLL or HSE left on");
+    CHECK(Rcc_GetSysclkHz() == RCC_HSI_HZ && Rcc_GetHclkHz() == RCC_HSI_HZ,
+          "no lock: published SYSCLK %lu", (unsigned long)Rcc_GetSysclkHz());
+    CHECK(Rcc_GetPclk1Hz() == HostApbHz(RCC_CFGR_PPRE1_POS) && Rcc_GetPclk2Hz() == HostApbHz(RCC_CFGR_PPRE2_POS),
+          "no lock: published PCLK1 %lu PCLK2 %lu, bus runs %lu/%lu", (unsigned long)Rcc_GetPclk1Hz(),
+          (unsigned long)Rcc_GetPclk2Hz(), (unsigned long)HostApbHz(RCC_CFGR_PPRE1_POS),
+          (unsigned long)HostApbHz(RCC_CFGR_PPRE2_POS));
+    uint32 Tim1 = HostApbHz(RCC_CFGR_PPRE1_POS) == RCC_HSI_HZ ? RCC_HSI_HZ : HostApbHz(RCC_CFGR_PPRE1_POS) * 2;
+    CHECK(Rcc_GetTimerClockHz(RCC_APB1) == Tim1, "no lock: APB1 timer clock %lu, runs at %lu",
+          (unsigned long)Rcc_GetTimerClockHz(RCC_APB1), (unsigned long)Tim1);
+
+    // And it recovers once the PLL does
+    host_pll_locks = 1;
+    CHECK(Configure(RCC_CLOCK_HSI, 0, 84000000UL) == RCC_OK, "after no lock: refused");
+    CheckRunning("after no lock", 84000000UL, 2);
+}
+
+int main(void) {
+    TestInit();
+    TestTargets();
+    TestRefused();
+    TestFailures();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,113 @@
+/**
+ * sched_idle_test.c
+ *
+ *  Host test for the idle path: the unchanged Sched.c and Power.c with
+ *  WFI stubbed out. The stub advances the simulated clock to the next
+ *  SysTick (1 ms), which is what wakes the core on target. Checks the
+ *  utilization the scheduler reports for a known load, and that Power_Idle
+ *  never sleeps while the pending predicate reports work.
+ *
+ *    gcc -std=gnu11 -Itests/stubs -ISched -IPower -IIrq \
+ *        -o sched_idle_test tests/sched_idle_test.c Sched/Sched.c Power/Power.c && ./sched_idle_test
+ */
+
+#include <stdio.h>
+
+#include "Power.h"
+#include "Sched.h"
+
+#define TICK_US 1000UL
+
+static uint32_t sim_now;
+static uint32_t wfi_count = 0;
+static uint8 work_pending = 0;
+static int failures = 0;
+
+#define CHECK_EQ(what, actual, expected) do { \
+    unsigned long a_ = (unsigned long)(actual), e_ = (unsigned long)(expected); \
+    if (a_ != e_) { printf("FAIL %s:%d: %s = %lu, expected %lu\n", __FILE__, __LINE__, what, a_, e_); failures++; } \
+} while (0)
+
+// WFI stand-in: sleep until the next SysTick
+void Power_HostWaitForInterrupt(void) {
+    wfi_count++;
+    sim_now = (sim_now / TICK_US + 1) * TICK_US;
+}
+
+static uint32_t SimClock(void) {
+    return sim_now;
+}
+
+static uint8 WorkPending(void) {
+    return work_pending;
+}
+
+static void IdleTask(void) {
+    Power_Idle(WorkPending);
+}
+
+// 100 us every 1 ms and 400 us every 5 ms: 10% + 8% = 180 permille
+static void InputTask(void) {
+    sim_now += 100;
+}
+
+static void ControlTask(void) {
+    sim_now += 400;
+}
+
+static void TestUtilization(void) {
+    sim_now = 0;
+    wfi_count = 0;
+    work_pending = 0;
+    Sched_Init(SimClock);
+    Sched_SetIdleHook(IdleTask);
+    Sched_AddTask("input", InputTask, 1000, 0);
+    Sched_AddTask("control", ControlTask, 5000, 0);
+
+    while (sim_now < 1000000UL) {
+        Sched_RunOnce();
+    }
+
+    printf("utilization %u permille, idle %lu of %lu us, %lu WFIs\n",
+           (unsigned)Sched_GetUtilizationPermille(), (unsigned long)Sched_GetIdleUs(),
+           (unsigned long)Sched_GetElapsedUs(), (unsigned long)wfi_count);
+
+    CHECK_EQ("utilization", Sched_GetUtilizationPermille(), 180);
+    CHECK_EQ("elapsed", Sched_GetElapsedUs(), 1000000UL);
+    CHECK_EQ("idle", Sched_GetIdleUs(), 820000UL);
+    CHECK_EQ("one WFI per tick", wfi_count, 1000);
+
+    Sched_ResetStats();
+    CHECK_EQ("utilization after reset", Sched_GetUtilizationPermille(), 0);
+}
+
+static void TestNoSleepWhilePending(void) {
+    wfi_count = 0;
+
+    work_pending = 1;
+    uint32_t before = sim_now;
+    for (int i = 0; i < 10; i++) {
+        Power_Idle(WorkPending);
+    }
+    CHECK_EQ("WFIs with work pending", wfi_count, 0);
+    CHECK_EQ("clock held with work pending", sim_now - before, 0);
+
+    work_pending = 0;
+    Power_Idle(WorkPending);
+    CHECK_EQ("WFIs once drained", wfi_count, 1);
+
+    Power_Idle(0);
+    CHECK_EQ("WFIs without a predicate", wfi_count, 2);
+}
+
+int main(void) {
+    TestUtilization();
+    TestNoSleepWhilePending();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
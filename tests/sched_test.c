@@ -0,0 +1,136 @@
+/**
+ * sched_test.c
+ *
+ *  Host test for the cooperative scheduler, built from the unchanged
+ *  Sched.c against a simulated microsecond clock. Tasks advance the clock
+ *  by their execution time and the idle hook jumps it to the next
+ *  release, so schedules and overrun accounting are exact.
+ *
+ *    gcc -std=gnu11 -ISched -o sched_test tests/sched_test.c Sched/Sched.c && ./sched_test
+ */
+
+#include <stdio.h>
+
+#include "Sched.h"
+
+static uint32_t sim_now;
+static int failures = 0;
+
+#define CHECK_EQ(what, actual, expected) do { \
+    unsigned long a_ = (unsigned long)(actual), e_ = (unsigned long)(expected); \
+    if (a_ != e_) { printf("FAIL %s:%d: %s = %lu, expected %lu\n", __FILE__, __LINE__, what, a_, e_); failures++; } \
+} while (0)
+
+static uint32_t SimClock(void) {
+    return sim_now;
+}
+
+static void SimIdle(void) {
+    sim_now += Sched_TimeToNextRelease();
+}
+
+// 1 kHz task, 100 us each
+static void FastTask(void) {
+    sim_now += 100;
+}
+
+// 10 Hz task whose first run takes 3.5 ms, then 100 us
+static uint32_t slow_runs = 0;
+static void SlowTask(void) {
+    sim_now += (slow_runs++ == 0) ? 3500 : 100;
+}
+
+static char order[8];
+static uint8_t order_len = 0;
+static void TaskA(void) { order[order_len++] = 'A'; }
+static void TaskB(void) { order[order_len++] = 'B'; }
+static void TaskC(void) { order[order_len++] = 'C'; }
+
+static void RunFor(uint32_t start, uint32_t duration_us) {
+    while ((int32_t)(sim_now - (start + duration_us)) < 0) {
+        Sched_RunOnce();
+    }
+}
+
+/*
+ * One second: the fast task releases every 1 ms, the slow one at 50 ms
+ * and every 100 ms after. The slow task's first run (50.1-53.6 ms) holds
+ * the fast task past its 51 ms release and its 52 ms deadline: one
+ * deadline miss, and the 52 and 53 ms releases are skipped (overruns).
+ */
+static void TestOverrunAccounting(uint32_t start) {
+    sim_now = start;
+    slow_runs = 0;
+    Sched_Init(SimClock);
+    Sched_SetIdleHook(SimIdle);
+    int8_t fast = Sched_AddTask("fast", FastTask, 1000, 0);
+    int8_t slow = Sched_AddTask("slow", SlowTask, 100000, 50000);
+
+    RunFor(start, 1000000);
+
+    const Sched_Task_t *f = Sched_GetTask(fast);
+    const Sched_Task_t *s = Sched_GetTask(slow);
+    printf("start 0x%08lX: fast %lu runs, %lu overruns, %lu misses; slow %lu runs, max %lu us, avg %lu us\n",
+           (unsigned long)start, (unsigned long)f->runs, (unsigned long)f->overruns,
+           (unsigned long)f->deadline_misses, (unsigned long)s->runs,
+           (unsigned long)s->exec_max_us, (unsigned long)Sched_GetAverageExecUs(slow));
+
+    CHECK_EQ("fast runs", f->runs, 1000 - 2);
+    CHECK_EQ("fast overruns", f->overruns, 2);
+    CHECK_EQ("fast deadline misses", f->deadline_misses, 1);
+    CHECK_EQ("fast max exec", f->exec_max_us, 100);
+    CHECK_EQ("fast avg exec", Sched_GetAverageExecUs(fast), 100);
+    CHECK_EQ("fast next release", f->release_us - start, 1000000);
+    CHECK_EQ("slow runs", s->runs, 10);
+    CHECK_EQ("slow overruns", s->overruns, 0);
+    CHECK_EQ("slow deadline misses", s->deadline_misses, 0);
+    CHECK_EQ("slow max exec", s->exec_max_us, 3500);
+    CHECK_EQ("slow avg exec", Sched_GetAverageExecUs(slow), (3500 + 9 * 100) / 10);
+}
+
+// Tasks due together run in registration order, one per Sched_RunOnce
+static void TestPriorityOrder(void) {
+    sim_now = 0;
+    order_len = 0;
+    Sched_Init(SimClock);
+    Sched_AddTask("a", TaskA, 1000, 0);
+    Sched_AddTask("b", TaskB, 1000, 0);
+    Sched_AddTask("c", TaskC, 1000, 0);
+
+    CHECK_EQ("first pass ran", Sched_RunOnce(), 1);
+    CHECK_EQ("second pass ran", Sched_RunOnce(), 1);
+    CHECK_EQ("third pass ran", Sched_RunOnce(), 1);
+    CHECK_EQ("nothing left due", Sched_RunOnce(), 0);
+    order[order_len] = '\0';
+    CHECK_EQ("order ABC", order[0] == 'A' && order[1] == 'B' && order[2] == 'C' && order_len == 3, 1);
+}
+
+static void TestTableAndReset(void) {
+    sim_now = 0;
+    Sched_Init(SimClock);
+    CHECK_EQ("period 0 rejected", Sched_AddTask("zero", TaskA, 0, 0), -1);
+    for (uint8_t i = 0; i < SCHED_MAX_TASKS; i++) {
+        CHECK_EQ("task id", Sched_AddTask("t", TaskA, 1000, 0), i);
+    }
+    CHECK_EQ("table full", Sched_AddTask("extra", TaskA, 1000, 0), -1);
+    CHECK_EQ("task count", Sched_GetTaskCount(), SCHED_MAX_TASKS);
+    CHECK_EQ("bad id", Sched_GetTask(SCHED_MAX_TASKS) == NULL, 1);
+
+    Sched_RunOnce();
+    Sched_ResetStats();
+    CHECK_EQ("runs after reset", Sched_GetTask(0)->runs, 0);
+}
+
+int main(void) {
+    TestOverrunAccounting(0);
+    TestOverrunAccounting(0xFFFFFFFFUL - 500000UL);   // wraps half way through
+    TestPriorityOrder();
+    TestTableAndReset();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,230 @@
+/**
+ * speed_filter_test.c
+ *
+ *  Replays encoder period traces through every SpeedFilter mode. Each
+ *  median and EMA output is checked against a naive reference (sort the
+ *  window, or the EMA recurrence in 64 bits); outlier rejection is checked
+ *  on single-edge glitches and on a real speed step. Reports the cost per
+ *  sample of each mode.
+ *
+ *  The built-in traces are synthetic: a steady belt with capture jitter,
+ *  missed and doubled edges, and a speed step. A recorded trace (one
+ *  period in ticks per line) can be replayed by passing its path.
+ *
+ *    gcc -std=gnu11 -O2 -ISpeed -o speed_filter_test tests/speed_filter_test.c Speed/SpeedFilter.c \
+ *        && ./speed_filter_test [trace.txt]
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "SpeedFilter.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define TRACE_MAX 100000
+
+static uint32_t trace[TRACE_MAX];
+static unsigned trace_len;
+
+static uint32_t lcg_state = 12345;
+
+static uint32_t Random(void) {
+    lcg_state = lcg_state * 1664525UL + 1013904223UL;
+    return lcg_state >> 8;
+}
+
+// 50 ms nominal period at 1 MHz, +-0.5% jitter; every 97th edge is missed
+// (period doubles) and every 131st doubled by a glitch (period halves);
+// the belt speeds up 25% two thirds of the way through
+static void SyntheticTrace(void) {
+    trace_len = 30000;
+    for (unsigned i = 0; i < trace_len; i++) {
+        uint32_t nominal = (i < trace_len * 2 / 3) ? 50000 : 40000;
+        uint32_t period = nominal - nominal / 200 + Random() % (nominal / 100 + 1);
+        if (i % 97 == 50) {
+            period *= 2;
+        } else if (i % 131 == 70) {
+            period /= 2;
+        }
+        trace[i] = period;
+    }
+}
+
+static int LoadTrace(const char *path) {
+    FILE *f = fopen(path, "r");
+    if (f == NULL) {
+        printf("cannot open %s\n", path);
+        return 0;
+    }
+    unsigned long value;
+    trace_len = 0;
+    while (trace_len < TRACE_MAX && fscanf(f, "%lu", &value) == 1) {
+        trace[trace_len++] = (uint32_t)value;
+    }
+    fclose(f);
+    return trace_len > 0;
+}
+
+static int CompareU32(const void *a, const void *b) {
+    uint32_t x = *(const uint32_t *)a, y = *(const uint32_t *)b;
+    return (x > y) - (x < y);
+}
+
+// Median of the last min(n, window) samples before `end`
+static uint32_t NaiveMedian(const uint32_t *samples, unsigned end, uint8_t window) {
+    uint32_t copy[SPEED_FILTER_MAX_WINDOW];
+    unsigned n = (end < window) ? end : window;
+    memcpy(copy, &samples[end - n], n * sizeof(copy[0]));
+    qsort(copy, n, sizeof(copy[0]), CompareU32);
+    return copy[n / 2];
+}
+
+static void TestMedianMatchesReference(void) {
+    for (uint8_t window = 1; window <= SPEED_FILTER_MAX_WINDOW; window += 2) {
+        SpeedFilter_Config_t config = { SPEED_FILTER_MEDIAN, window, 0, 0, 0 };
+        SpeedFilter_t filter;
+        SpeedFilter_Init(&filter, &config);
+
+        unsigned bad = 0;
+        for (unsigned i = 0; i < trace_len; i++) {
+            uint32_t got = SpeedFilter_Update(&filter, trace[i]);
+            uint32_t want = NaiveMedian(trace, i + 1, window);
+            if (got != want && bad++ == 0) {
+                CHECK(0, "median %u, sample %u: %lu, reference %lu", window, i,
+                      (unsigned long)got, (unsigned long)want);
+            }
+        }
+        CHECK(bad == 0, "median %u: %u mismatches", window, bad);
+    }
+}
+
+static void TestEmaMatchesReference(void) {
+    for (uint8_t shift = 1; shift <= 8; shift++) {
+        SpeedFilter_Config_t config = { SPEED_FILTER_EMA, 1, shift, 0, 0 };
+        SpeedFilter_t filter;
+        SpeedFilter_Init(&filter, &config);
+
+        int64_t state_q8 = (int64_t)trace[0] << 8;
+        unsigned bad = 0;
+        for (unsigned i = 0; i < trace_len; i++) {
+            if (i > 0) {
+                int64_t step = ((int64_t)trace[i] << 8) - state_q8;
+                // The filter shifts the magnitude, so it rounds toward the old state
+                state_q8 += (step >= 0) ? (step >> shift) : -((-step) >> shift);
+            }
+            uint32_t want = (uint32_t)((state_q8 + 0x80) >> 8);
+            uint32_t got = SpeedFilter_Update(&filter, trace[i]);
+            if (got != want && bad++ == 0) {
+                CHECK(0, "EMA shift %u, sample %u: %lu, reference %lu", shift, i,
+                      (unsigned long)got, (unsigned long)want);
+            }
+        }
+        CHECK(bad == 0, "EMA shift %u: %u mismatches", shift, bad);
+    }
+}
+
+// Glitches are dropped, a real step gets through after outlier_max_run
+static void TestOutliers(void) {
+    SpeedFilter_Config_t config = { SPEED_FILTER_MEDIAN, 5, 0, 25, 3 };
+    SpeedFilter_t filter;
+    SpeedFilter_Init(&filter, &config);
+
+    for (unsigned i = 0; i < 20; i++) {
+        SpeedFilter_Update(&filter, 50000 + (i % 3) * 100);
+    }
+    uint32_t steady = SpeedFilter_Get(&filter);
+    CHECK(SpeedFilter_Update(&filter, 100000) == steady, "missed edge moved the estimate");
+    CHECK(SpeedFilter_Update(&filter, 50100) == steady, "estimate moved after the glitch");
+    CHECK(SpeedFilter_Update(&filter, 25000) == steady, "doubled edge moved the estimate");
+    CHECK(SpeedFilter_Update(&filter, 50000) == steady, "estimate moved after the glitch");
+    CHECK(filter.rejected_total == 2, "%lu samples rejected, expected 2", (unsigned long)filter.rejected_total);
+
+    // Belt really slowed down: three drops, then the fourth is taken
+    for (unsigned i = 0; i < 3; i++) {
+        CHECK(SpeedFilter_Update(&filter, 80000) == steady, "step accepted after %u samples", i + 1);
+    }
+    CHECK(SpeedFilter_Update(&filter, 80000) == 80000, "step never accepted");
+    uint32_t after = SpeedFilter_Update(&filter, 80200);
+    CHECK(after >= 80000 && after <= 80200, "estimate %lu lost track after the step", (unsigned long)after);
+}
+
+// Jitter seen on the output: how far the estimate strays from the nominal
+static void Replay(const char *name, const SpeedFilter_Config_t *config) {
+    SpeedFilter_t filter;
+    SpeedFilter_Init(&filter, config);
+
+    const int rounds = 20;
+    struct timespec t0, t1;
+    volatile uint32_t sink = 0;
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int r = 0; r < rounds; r++) {
+        SpeedFilter_Reset(&filter);
+        for (unsigned i = 0; i < trace_len; i++) {
+            sink += SpeedFilter_Update(&filter, trace[i]);
+        }
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+
+    // Largest sample-to-sample move of the estimate, a proxy for LCD redraws
+    SpeedFilter_Reset(&filter);
+    filter.rejected_total = 0;
+    uint32_t last = 0, max_move = 0;
+    for (unsigned i = 0; i < trace_len; i++) {
+        uint32_t estimate = SpeedFilter_Update(&filter, trace[i]);
+        if (i > 16) {
+            uint32_t move = (estimate > last) ? estimate - last : last - estimate;
+            if (move > max_move) {
+                max_move = move;
+            }
+        }
+        last = estimate;
+    }
+
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / ((double)rounds * trace_len);
+    printf("%-26s %6.1f ns/sample, largest step %6lu ticks, %5lu rejected\n",
+           name, ns, (unsigned long)max_move, (unsigned long)filter.rejected_total);
+}
+
+int main(int argc, char **argv) {
+    if (argc > 1) {
+        if (!LoadTrace(argv[1])) {
+            return 1;
+        }
+        printf("replaying %u periods from %s\n", trace_len, argv[1]);
+    } else {
+        SyntheticTrace();
+        printf("replaying %u synthetic periods\n", trace_len);
+    }
+
+    TestMedianMatchesReference();
+    TestEmaMatchesReference();
+    TestOutliers();
+
+    const SpeedFilter_Config_t none = { SPEED_FILTER_NONE, 1, 0, 0, 0 };
+    const SpeedFilter_Config_t median5 = { SPEED_FILTER_MEDIAN, 5, 0, 0, 0 };
+    const SpeedFilter_Config_t median15 = { SPEED_FILTER_MEDIAN, 15, 0, 0, 0 };
+    const SpeedFilter_Config_t ema = { SPEED_FILTER_EMA, 1, 3, 0, 0 };
+    const SpeedFilter_Config_t ema_outlier = { SPEED_FILTER_EMA, 1, 3, 25, 3 };
+    const SpeedFilter_Config_t median_outlier = { SPEED_FILTER_MEDIAN, 5, 0, 25, 3 };
+    Replay("raw", &none);
+    Replay("median 5", &median5);
+    Replay("median 15", &median15);
+    Replay("EMA 1/8", &ema);
+    Replay("EMA 1/8 + outliers 25%", &ema_outlier);
+    Replay("median 5 + outliers 25%", &median_outlier);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,131 @@
+/**
+ * speed_test.c
+ *
+ *  Host test for the integer speed conversion. Every result is compared
+ *  with the exact quotient rounded to nearest, computed in 128 bits, over
+ *  every period up to 2^18 ticks and a geometric sweep up to 2^32 - 1, for
+ *  the conveyor's configuration and a few that stress the reductions.
+ *  Also reports the cost per conversion against the double-precision
+ *  formula it replaced (the host has a double FPU, the F401 does not, so
+ *  the target gap is larger).
+ *
+ *    gcc -std=gnu11 -O2 -ISpeed -o speed_test tests/speed_test.c Speed/Speed.c && ./speed_test
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Speed.h"
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+typedef unsigned __int128 u128;
+
+// Nearest, ties up, saturated to 32 bits
+static uint32_t Exact(u128 num, u128 den) {
+    u128 q = (2 * num + den) / (2 * den);
+    return (q > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)q;
+}
+
+static unsigned CheckPeriod(const Speed_Config_t *c, uint32_t period) {
+    unsigned bad = 0;
+    uint32_t mhz = Exact((u128)c->tick_hz * 1000U, period);
+    uint32_t rpm = Exact((u128)c->tick_hz * 60U, (u128)period * c->pulses_per_rev);
+    uint32_t mms = Exact((u128)c->tick_hz * c->circumference_um, (u128)period * c->pulses_per_rev * 1000U);
+
+    if (Speed_PeriodToMilliHz(period) != mhz) {
+        bad++;
+    }
+    if (Speed_PeriodToRpm(period) != rpm) {
+        bad++;
+    }
+    if (Speed_PeriodToMmPerSec(period) != mms) {
+        bad++;
+    }
+    if (bad && failures < 10) {
+        CHECK(0, "tick %lu ppr %u circ %lu period %lu: mHz %lu/%lu rpm %lu/%lu mm/s %lu/%lu",
+              (unsigned long)c->tick_hz, c->pulses_per_rev, (unsigned long)c->circumference_um,
+              (unsigned long)period, (unsigned long)Speed_PeriodToMilliHz(period), (unsigned long)mhz,
+              (unsigned long)Speed_PeriodToRpm(period), (unsigned long)rpm,
+              (unsigned long)Speed_PeriodToMmPerSec(period), (unsigned long)mms);
+    }
+    return bad;
+}
+
+static void TestAccuracy(const Speed_Config_t *c) {
+    unsigned long checked = 0;
+    unsigned bad = 0;
+
+    Speed_Init(c);
+    for (uint32_t period = 1; period <= (1UL << 18); period++) {
+        bad += CheckPeriod(c, period);
+        checked++;
+    }
+    for (uint64_t period = (1UL << 18); period <= 0xFFFFFFFFUL; period += period / 97 + 1) {
+        bad += CheckPeriod(c, (uint32_t)period);
+        checked++;
+    }
+    bad += CheckPeriod(c, 0xFFFFFFFFUL);
+    printf("tick %8lu Hz, ppr %3u, circ %7lu um: %lu periods, %u mismatches\n",
+           (unsigned long)c->tick_hz, c->pulses_per_rev, (unsigned long)c->circumference_um,
+           checked + 1, bad);
+    CHECK(bad == 0, "%u mismatches", bad);
+}
+
+// The conversion the speed module replaced, with the real tick rate
+static volatile double double_tick_hz;
+static volatile double double_circ_um;
+
+static uint32_t DoubleMmPerSec(uint32_t period) {
+    return (uint32_t)(double_tick_hz * double_circ_um / ((double)period * 1000.0) + 0.5);
+}
+
+static void CompareCost(const Speed_Config_t *c) {
+    const uint32_t rounds = 20000000UL;
+    volatile uint32_t sink = 0;
+    struct timespec t0, t1, t2;
+
+    Speed_Init(c);
+    double_tick_hz = c->tick_hz;
+    double_circ_um = c->circumference_um;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (uint32_t i = 0; i < rounds; i++) {
+        sink += Speed_PeriodToMmPerSec(2000 + (i & 0xFFFF));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    for (uint32_t i = 0; i < rounds; i++) {
+        sink += DoubleMmPerSec(2000 + (i & 0xFFFF));
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t2);
+
+    double fixed_ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+    double double_ns = ((t2.tv_sec - t1.tv_sec) * 1e9 + (t2.tv_nsec - t1.tv_nsec)) / rounds;
+    printf("mm/s per conversion: integer %.2f ns, double %.2f ns on the host\n", fixed_ns, double_ns);
+    (void)sink;
+}
+
+int main(void) {
+    const Speed_Config_t configs[] = {
+        { 1000000UL, 1, 157080UL },     // the conveyor: 1 MHz capture tick, 50 mm pulley
+        { 84000000UL, 1, 157080UL },    // undivided APB1 timer clock: 64-bit numerators
+        { 1000000UL, 600, 314159UL },   // encoder with many edges per turn
+        { 16000000UL, 7, 1000UL },      // reductions that don't divide evenly
+    };
+
+    for (unsigned i = 0; i < sizeof(configs) / sizeof(configs[0]); i++) {
+        TestAccuracy(&configs[i]);
+    }
+    CompareCost(&configs[0]);
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
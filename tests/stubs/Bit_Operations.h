@@ -0,0 +1,14 @@
+/**
+ * Bit_Operations.h
+ *
+ *  Host stand-in for the toolchain's Bit_Operations.h.
+ */
+
+#ifndef BIT_OPERATIONS_H
+#define BIT_OPERATIONS_H
+
+#define SET_BIT(REG, BIT)   ((REG) |= (1UL << (BIT)))
+#define CLEAR_BIT(REG, BIT) ((REG) &= ~(1UL << (BIT)))
+#define READ_BIT(REG, BIT)  (((REG) >> (BIT)) & 1UL)
+
+#endif /* BIT_OPERATIONS_H */
@@ -0,0 +1,8 @@
+/**
+ * GPIO.h
+ *
+ *  The firmware is built on a case-insensitive filesystem, where this name
+ *  and Gpio/Gpio.h are the same file.
+ */
+
+#include "Gpio.h"
@@ -0,0 +1,8 @@
+/**
+ * GPIO_Private.h
+ *
+ *  The firmware is built on a case-insensitive filesystem, where this name
+ *  and Gpio/Gpio_Private.h are the same file.
+ */
+
+#include "Gpio_Private.h"
@@ -0,0 +1,15 @@
+/**
+ * Std_Types.h
+ *
+ *  Host stand-in for the toolchain's Std_Types.h.
+ */
+
+#ifndef STD_TYPES_H
+#define STD_TYPES_H
+#include <stdint.h>
+
+typedef uint8_t uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+
+#endif /* STD_TYPES_H */
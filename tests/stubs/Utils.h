@@ -0,0 +1,12 @@
+/**
+ * Utils.h
+ *
+ *  Host stand-in for the toolchain's Utils.h.
+ */
+
+#ifndef UTILS_H
+#define UTILS_H
+
+#define REG32(addr) (*(volatile uint32 *)(addr))
+
+#endif /* UTILS_H */
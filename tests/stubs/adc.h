@@ -0,0 +1,8 @@
+/**
+ * adc.h
+ *
+ *  The firmware is built on a case-insensitive filesystem, where this name
+ *  and Adc/Adc.h are the same file.
+ */
+
+#include "Adc.h"
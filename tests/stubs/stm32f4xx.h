@@ -0,0 +1,40 @@
+/**
+ * stm32f4xx.h
+ *
+ *  Host stand-in for the CMSIS device header: just what the LCD and
+ *  TimeCapture modules touch, with TIM11 and GPIOA backed by test-owned
+ *  structs.
+ */
+
+#ifndef STM32F4XX_H
+#define STM32F4XX_H
+#include <stdint.h>
+
+typedef struct {
+    volatile uint32_t CR1, CR2, SMCR, DIER, SR, EGR, CCMR1, CCMR2, CCER, CNT, PSC, ARR;
+} TIM_TypeDef;
+
+typedef struct {
+    volatile uint32_t MODER, OTYPER, OSPEEDR, PUPDR, IDR, ODR, BSRR, LCKR, AFR[2];
+} GPIO_TypeDef;
+
+typedef enum {
+    DMA1_Stream5_IRQn = 16,
+    TIM1_TRG_COM_TIM11_IRQn = 26,
+    TIM2_IRQn = 28,
+} IRQn_Type;
+
+extern TIM_TypeDef host_tim11;
+#define TIM11 (&host_tim11)
+
+extern GPIO_TypeDef host_gpioa;
+#define GPIOA (&host_gpioa)
+
+#define GPIO_MODER_MODER5       (0x3UL << 10)
+#define GPIO_MODER_MODER5_1     (0x2UL << 10)
+#define TIM_CCMR1_CC1S_0        (0x1UL << 0)
+
+static inline void NVIC_EnableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+static inline void NVIC_DisableIRQ(IRQn_Type IRQn) { (void)IRQn; }
+
+#endif /* STM32F4XX_H */
@@ -0,0 +1,319 @@
+/**
+ * telemetry_loopback_test.c
+ *
+ *  Host loopback for the telemetry stream. The unchanged Telemetry.c runs
+ *  against a simulated USART/DMA: a started transfer reads its buffer one
+ *  byte per character time, as the DMA does, and signals completion after
+ *  the last byte. The bytes on the "wire" go through the decoder from
+ *  tools/telemetry_decode.c and every decoded row is compared with the
+ *  record published under that sequence number. Checks clean streaming
+ *  at the configured rate and at the highest rate Telemetry_Init()
+ *  accepts, that a producer outrunning the link only replaces waiting
+ *  frames and never tears the one on the wire, that the decoder resyncs
+ *  after line noise and a corrupted frame, and that a refused DMA start
+ *  loses only its own frame. Reports link throughput and encode cost.
+ *
+ *    gcc -std=gnu11 -O2 -Itests/stubs -ITelemetry -IUsart -IIrq \
+ *        -o telemetry_loopback_test tests/telemetry_loopback_test.c Telemetry/Telemetry.c && ./telemetry_loopback_test
+ */
+
+#include <stdio.h>
+#include <time.h>
+
+#include "Telemetry.h"
+#include "Usart.h"
+
+// The decoder, minus its serial-port main
+#define main telemetry_decode_main
+#include "../tools/telemetry_decode.c"
+#undef main
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+#define BAUD 115200UL
+
+// Simulated USART1 + DMA2 stream 7, time in ns
+static uint64_t sim_now;
+static uint64_t byte_ns;
+static uint64_t link_free_at;       // the shift register takes the next byte
+static Usart_TxDoneFn tx_done;
+static const uint8* tx_data;
+static uint16 tx_length;
+static uint16 tx_index;
+static int tx_busy;
+static int refuse_next;
+static unsigned long wire_bytes;
+static uint64_t wire_busy_ns;
+
+uint8 Usart_Init(uint8 Usart, uint32 Baud, Usart_TxDoneFn TxDone) {
+    (void)Usart;
+    tx_done = TxDone;
+    tx_busy = 0;
+    byte_ns = 10ULL * 1000000000ULL / Baud;     // 8N1
+    return USART_OK;
+}
+
+uint8 Usart_WriteDma(uint8 Usart, const uint8* Data, uint16 Length) {
+    (void)Usart;
+    if (tx_busy || refuse_next) {
+        refuse_next = 0;
+        return USART_NOK;
+    }
+    tx_data = Data;
+    tx_length = Length;
+    tx_index = 0;
+    tx_busy = 1;
+    return USART_OK;
+}
+
+uint8 Usart_IsTxBusy(uint8 Usart) { (void)Usart; return (uint8)tx_busy; }
+uint32 Usart_GetBaud(uint8 Usart) { (void)Usart; return BAUD; }
+
+static struct decoder dec;
+
+// What the receiving end does with a byte
+static void Wire(uint8 Byte) {
+    wire_bytes++;
+    feed(&dec, Byte);
+}
+
+// Runs the link up to `Until`: each byte is read from the buffer when the
+// shift register frees, and the last read completes the transfer
+static void RunTo(uint64_t Until) {
+    while (tx_busy) {
+        uint64_t at = link_free_at > sim_now ? link_free_at : sim_now;
+        if (at > Until) {
+            break;
+        }
+        sim_now = at;
+        Wire(tx_data[tx_index++]);
+        link_free_at = at + byte_ns;
+        wire_busy_ns += byte_ns;
+        if (tx_index == tx_length) {
+            tx_busy = 0;
+            tx_done(USART_1);
+        }
+    }
+    sim_now = Until;
+}
+
+// Published records, indexed by publish order
+#define MAX_RECORDS 20000
+static Telemetry_Record published[MAX_RECORDS];
+static unsigned published_count;
+static uint32 rng = 12345;
+
+static uint32 Next(void) {
+    rng = rng * 1664525UL + 1013904223UL;
+    return rng;
+}
+
+static void Publish(void) {
+    Telemetry_Record* r = &published[published_count++];
+    r->TimestampUs = (uint32)(sim_now / 1000);
+    // Sync bytes inside the payload every few frames, to tempt the decoder
+    r->ObjectCount = (published_count % 7 == 0) ? 0x5AA5A55AUL : Next();
+    r->PeriodTicks = Next();
+    r->SpeedMmS = (uint16)Next();
+    r->Duty = (published_count % 5 == 0) ? 0x5AA5 : (uint16)Next();
+    r->AdcRaw = (uint16)(Next() & 0xFFF);
+    r->Faults = (uint8)(Next() & 0x0F);
+    Telemetry_Publish(r);
+}
+
+typedef struct {
+    unsigned decoded;
+    unsigned mismatched;
+    unsigned torn;      // decoded rows that match no published record
+    unsigned next;      // publish index after the last decoded row
+} Match;
+
+// Walks the decoder's CSV against the records: each row must be the
+// newest record published under its sequence number, in publish order
+static Match Compare(FILE* Csv, unsigned First) {
+    Match m = { 0, 0, 0, First };
+    unsigned seq, ts, count, period, speed, duty, adc, faults;
+    unsigned cursor = First;
+
+    rewind(Csv);
+    while (fscanf(Csv, "%u,%u,%u,%u,%u,%u,%u,0x%X\n", &seq, &ts, &count, &period, &speed, &duty,
+                  &adc, &faults) == 8) {
+        m.decoded++;
+        while (cursor < published_count && (cursor & 0xFF) != seq) {
+            cursor++;
+        }
+        if (cursor >= published_count) {
+            m.torn++;
+            continue;
+        }
+        const Telemetry_Record* r = &published[cursor++];
+        if (ts != r->TimestampUs || count != r->ObjectCount || period != r->PeriodTicks ||
+            speed != r->SpeedMmS || duty != r->Duty || adc != r->AdcRaw || faults != r->Faults) {
+            m.mismatched++;
+        }
+        m.next = cursor;
+    }
+    return m;
+}
+
+static FILE* Start(uint32 RateHz) {
+    CHECK(Telemetry_Init(USART_1, BAUD, RateHz) == TELEMETRY_OK, "%lu Hz refused", (unsigned long)RateHz);
+    struct decoder fresh = { .last_seq = -1 };
+    dec = fresh;
+    dec.out = tmpfile();
+    wire_bytes = 0;
+    wire_busy_ns = 0;
+    return dec.out;
+}
+
+// `Frames` publishes `PeriodNs` apart, then lets the link drain
+static void Stream(unsigned Frames, uint64_t PeriodNs) {
+    for (unsigned i = 0; i < Frames; i++) {
+        RunTo(sim_now + PeriodNs);
+        Publish();
+    }
+    RunTo(sim_now + 100 * byte_ns * TELEMETRY_FRAME_SIZE);
+}
+
+static void TestRate(const char* Name, uint32 RateHz, unsigned Frames) {
+    FILE* csv = Start(RateHz);
+    unsigned first = published_count;
+    uint32 sent = Telemetry_GetSent();
+    uint32 replaced = Telemetry_GetReplaced();
+    Stream(Frames, 1000000000ULL / RateHz);
+
+    Match m = Compare(csv, first);
+    double seconds = (double)Frames / RateHz;
+    printf("%-20s %u frames in %.2f s: %.0f frames/s, %.0f bytes/s, link %.0f%% busy\n", Name, m.decoded,
+           seconds, m.decoded / seconds, wire_bytes / seconds, 100.0 * wire_busy_ns / 1e9 / seconds);
+    CHECK(m.decoded == Frames && m.mismatched == 0 && m.torn == 0,
+          "%s: %u of %u decoded, %u mismatched, %u torn", Name, m.decoded, Frames, m.mismatched, m.torn);
+    CHECK(dec.crc_errors == 0 && dec.gaps == 0 && dec.skipped == 0,
+          "%s: %lu CRC errors, %lu gaps, %lu skipped", Name, dec.crc_errors, dec.gaps, dec.skipped);
+    CHECK(Telemetry_GetSent() - sent == Frames && Telemetry_GetReplaced() == replaced,
+          "%s: %lu sent, %lu replaced", Name, (unsigned long)(Telemetry_GetSent() - sent),
+          (unsigned long)(Telemetry_GetReplaced() - replaced));
+    fclose(csv);
+}
+
+static void TestLimits(void) {
+    uint32 max_hz = BAUD / (TELEMETRY_FRAME_SIZE * 10U);
+    CHECK(Telemetry_Init(USART_1, BAUD, max_hz + 1) == TELEMETRY_NOK, "%lu Hz accepted over a %lu baud link",
+          (unsigned long)(max_hz + 1), (unsigned long)BAUD);
+    CHECK(Telemetry_Init(USART_1, BAUD, 0) == TELEMETRY_NOK, "0 Hz accepted");
+    TestRate("at the link limit", max_hz, 2000);
+}
+
+// Publishing every 0.5 ms on a 2.2 ms frame: Publish never waits, the
+// waiting frame is replaced, and the one on the wire always arrives whole
+static void TestOverrun(void) {
+    FILE* csv = Start(100);
+    unsigned first = published_count;
+    uint32 sent = Telemetry_GetSent();
+    uint32 replaced = Telemetry_GetReplaced();
+    unsigned frames = 4000;
+
+    Stream(frames, 500000);
+
+    Match m = Compare(csv, first);
+    unsigned lost = frames - m.decoded;
+    printf("%-20s %u of %u frames decoded, %lu missing by sequence, %lu replaced\n",
+           "overrun x4.3", m.decoded, frames, dec.gaps, (unsigned long)(Telemetry_GetReplaced() - replaced));
+    CHECK(m.mismatched == 0 && m.torn == 0 && dec.crc_errors == 0,
+          "overrun: %u mismatched, %u torn, %lu CRC errors", m.mismatched, m.torn, dec.crc_errors);
+    CHECK(Telemetry_GetReplaced() - replaced == lost && Telemetry_GetSent() - sent == m.decoded,
+          "overrun: %u lost, %lu replaced, %lu sent", lost, (unsigned long)(Telemetry_GetReplaced() - replaced),
+          (unsigned long)(Telemetry_GetSent() - sent));
+    CHECK(wire_busy_ns >= (uint64_t)frames * 500000 * 95 / 100, "overrun: link busy %.0f%% of the time",
+          100.0 * wire_busy_ns / ((double)frames * 500000));
+    // Replacing keeps the newest: the last record published is the last one out
+    CHECK(m.next == published_count, "overrun: last frame out was publish %u of %u", m.next, published_count);
+    fclose(csv);
+}
+
+// Line noise between frames and a flipped bit inside one: the decoder
+// loses the damaged frame and nothing else
+static void TestResync(void) {
+    FILE* csv = Start(100);
+    unsigned first = published_count;
+
+    Stream(10, 10000000);
+    static const uint8 noise[] = { 0xA5, 0x00, 0xA5, 0x5A, 0x13, 0xFF, 0xA5, 0x5A, TELEMETRY_PAYLOAD_SIZE, 0x01 };
+    for (unsigned i = 0; i < sizeof(noise); i++) {
+        Wire(noise[i]);
+    }
+    Stream(10, 10000000);
+
+    // Corrupt a frame on its way: a bit of its ObjectCount flips
+    uint8 frame[TELEMETRY_FRAME_SIZE];
+    Telemetry_Record bad = { 1, 2, 3, 4, 5, 6, 7 };
+    Telemetry_Encode(&bad, 0x77, frame);
+    frame[8] ^= 0x10;
+    for (unsigned i = 0; i < sizeof(frame); i++) {
+        Wire(frame[i]);
+    }
+    Stream(10, 10000000);
+
+    Match m = Compare(csv, first);
+    CHECK(m.decoded == 30 && m.mismatched == 0 && m.torn == 0, "resync: %u of 30 decoded, %u mismatched, %u torn",
+          m.decoded, m.mismatched, m.torn);
+    CHECK(dec.crc_errors >= 1, "resync: corrupted frame passed the CRC");
+    fclose(csv);
+}
+
+// A DMA start the driver refuses: that frame is dropped, the next one goes
+static void TestRefusedStart(void) {
+    FILE* csv = Start(100);
+    unsigned first = published_count;
+    uint32 sent = Telemetry_GetSent();
+
+    Stream(5, 10000000);
+    refuse_next = 1;
+    Stream(5, 10000000);
+
+    Match m = Compare(csv, first);
+    CHECK(m.decoded == 9 && m.mismatched == 0 && Telemetry_GetSent() - sent == 9,
+          "refused start: %u decoded, %lu sent", m.decoded, (unsigned long)(Telemetry_GetSent() - sent));
+    fclose(csv);
+}
+
+static void BenchEncode(void) {
+    const int rounds = 5000000;
+    uint8 frame[TELEMETRY_FRAME_SIZE];
+    Telemetry_Record r = { 123456789UL, 4242, 98765, 250, 2100, 2048, 0 };
+    volatile uint8 sink = 0;
+    struct timespec t0, t1;
+
+    clock_gettime(CLOCK_MONOTONIC, &t0);
+    for (int i = 0; i < rounds; i++) {
+        r.TimestampUs = (uint32)i;
+        Telemetry_Encode(&r, (uint8)i, frame);
+        sink ^= frame[TELEMETRY_FRAME_SIZE - 1];
+    }
+    clock_gettime(CLOCK_MONOTONIC, &t1);
+    (void)sink;
+
+    double ns = ((t1.tv_sec - t0.tv_sec) * 1e9 + (t1.tv_nsec - t0.tv_nsec)) / rounds;
+    printf("Telemetry_Encode: %.1f ns per frame on the host, vs %.0f us on the wire\n", ns,
+           TELEMETRY_FRAME_SIZE * 10 * 1e6 / BAUD);
+}
+
+int main(void) {
+    TestRate("100 Hz", 100, 1000);
+    TestLimits();
+    TestOverrun();
+    TestResync();
+    TestRefusedStart();
+    BenchEncode();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,189 @@
+/**
+ * time_capture_dma_test.c
+ *
+ *  Host simulation of the TimeCapture DMA mode. A synthetic edge source
+ *  writes counter values into the circular capture buffer the way DMA1
+ *  stream 5 would, keeping NDTR and raising the half/full transfer
+ *  interrupts at the buffer midpoint and end. Checks the period extraction
+ *  across batches, early pickup through TimeCapture_PollDma, and periods
+ *  that span the 32-bit counter wrap.
+ *
+ *    gcc -std=gnu11 -Wno-pointer-to-int-cast -Itests/stubs -ITimeCapture -IDma -IRcc \
+ *        -o time_capture_dma_test tests/time_capture_dma_test.c && ./time_capture_dma_test
+ */
+
+#include <stdio.h>
+
+#include "TimeCapture.h"
+
+static TIMER_TypeDef host_tim2;
+GPIO_TypeDef host_gpioa;
+
+#undef TIMER2
+#define TIMER2 (&host_tim2)
+
+#include "../TimeCapture/TimeCapture.c"
+
+static uint32_t dma_pos;        // next buffer index DMA writes
+static uint8_t dma_flags;
+static int dma_running;
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config) {
+    (void)Controller; (void)Stream; (void)Config;
+}
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count) {
+    (void)Controller; (void)Stream; (void)PeriphAddr; (void)MemAddr; (void)Count;
+    dma_pos = 0;
+    dma_flags = 0;
+    dma_running = 1;
+}
+void Dma_Stop(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; dma_running = 0; }
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream) {
+    (void)Controller; (void)Stream;
+    return (uint16)(TIMECAPTURE_DMA_SIZE - dma_pos);
+}
+uint8 Dma_GetFlags(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; return dma_flags; }
+void Dma_ClearFlags(uint8 Controller, uint8 Stream, uint8 Flags) {
+    (void)Controller; (void)Stream;
+    dma_flags &= (uint8_t)~Flags;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+static uint32_t counter;        // free-running TIM2 count
+
+// One rising edge: CCR1 latches the counter and DMA moves it to the buffer
+static void Edge(uint32_t period_ticks) {
+    counter += period_ticks;
+    capture_dma_buffer[dma_pos++] = counter;
+    if (dma_pos == TIMECAPTURE_DMA_SIZE / 2) {
+        dma_flags |= DMA_FLAG_HT;
+    } else if (dma_pos == TIMECAPTURE_DMA_SIZE) {
+        dma_flags |= DMA_FLAG_TC;
+        dma_pos = 0;      // circular: NDTR reloads
+    }
+    if (dma_flags) {
+        DMA1_Stream5_IRQHandler();
+    }
+}
+
+// Synthetic pattern that never repeats within a buffer
+static uint32_t PatternPeriod(uint32_t i) {
+    return 900U + (i % 7U) * 50U + (i % 3U);
+}
+
+static unsigned Expect(uint32_t first, unsigned count, const char *what) {
+    uint32_t value = 0;
+    unsigned got = 0;
+    for (unsigned i = 0; i < count; i++) {
+        if (!TimeCapture_ReadPeriod(&value)) {
+            break;
+        }
+        CHECK(value == PatternPeriod(first + i), "%s: period %u is %lu, expected %lu", what, first + i,
+              (unsigned long)value, (unsigned long)PatternPeriod(first + i));
+        got++;
+    }
+    CHECK(got == count, "%s: %u periods available, expected %u", what, got, count);
+    CHECK(!TimeCapture_ReadPeriod(&value), "%s: more periods than edges", what);
+    return got;
+}
+
+static void TestSetup(void) {
+    TimeCapture_InitDma();
+    CHECK(dma_running, "DMA not started");
+    CHECK(host_tim2.DIER == CC1DE, "DIER = 0x%lx, expected CC1DE only", (unsigned long)host_tim2.DIER);
+    CHECK(host_tim2.DCR == ((DCR_DBA_CCR1 << DCR_DBA_POS) | (0UL << DCR_DBL_POS)), "DCR = 0x%lx",
+          (unsigned long)host_tim2.DCR);
+    CHECK(host_tim2.SMCR == 0, "slave mode left on");
+}
+
+// Batches land at the half and full points; the reader keeps up
+static void TestBatches(void) {
+    uint32_t edge = 0;
+
+    counter = 5000;
+    Edge(0);            // first capture only sets the reference
+    for (unsigned half = 0; half < 8; half++) {
+        uint32_t first = edge;
+        // The ring holds 16, so drain every 12 edges
+        for (unsigned i = 0; i < TIMECAPTURE_DMA_SIZE / 2; i++) {
+            Edge(PatternPeriod(edge++));
+            if (i % 12 == 11 || i == TIMECAPTURE_DMA_SIZE / 2 - 1) {
+                if (half == 0 && i == 11) {
+                    CHECK(TimeCapture_GetPeriodCount() == 0, "periods appeared before the half-transfer");
+                }
+                TimeCapture_PollDma();
+                unsigned n = (i % 12 == 11) ? 12 : (i % 12) + 1;
+                Expect(first, n, "batch");
+                first += n;
+            }
+        }
+    }
+    CHECK(TimeCapture_GetLostCount() == 0, "%lu periods lost", (unsigned long)TimeCapture_GetLostCount());
+    CHECK(TimeCapture_GetPeriodCount() == edge, "%lu periods for %lu edges",
+          (unsigned long)TimeCapture_GetPeriodCount(), (unsigned long)edge);
+}
+
+// PollDma picks up a partial half; the interrupt later must not repeat it
+static void TestPollThenInterrupt(void) {
+    uint32_t start = TimeCapture_GetPeriodCount();
+    uint32_t edge = 100;
+    uint32_t unread = edge;
+
+    for (unsigned i = 0; i < 5; i++) {
+        Edge(PatternPeriod(edge++));
+    }
+    TimeCapture_PollDma();
+    Expect(unread, 5, "poll");
+    unread += 5;
+
+    while (dma_pos != 0) {       // run on through the transfer-complete point
+        Edge(PatternPeriod(edge++));
+        if (edge - unread == 12) {
+            TimeCapture_PollDma();
+            Expect(unread, 12, "poll then interrupt");
+            unread += 12;
+        }
+    }
+    TimeCapture_PollDma();
+    Expect(unread, edge - unread, "poll then interrupt tail");
+    CHECK(TimeCapture_GetPeriodCount() - start == edge - 100, "duplicated or missing periods: %lu for %lu edges",
+          (unsigned long)(TimeCapture_GetPeriodCount() - start), (unsigned long)(edge - 100));
+}
+
+// The counter wraps between two edges
+static void TestCounterWrap(void) {
+    uint32_t value = 0;
+
+    counter = 0xFFFFFFFFUL - 300;
+    Edge(0);            // period from the previous edge is discarded here
+    TimeCapture_PollDma();
+    TimeCapture_ReadPeriod(&value);
+
+    Edge(1000);         // lands at 699 after the wrap
+    Edge(1000);
+    TimeCapture_PollDma();
+    CHECK(TimeCapture_ReadPeriod(&value) && value == 1000, "period across the wrap: %lu", (unsigned long)value);
+    CHECK(TimeCapture_ReadPeriod(&value) && value == 1000, "period after the wrap: %lu", (unsigned long)value);
+    CHECK(TimeCapture_GetAveragePeriod() > 0, "average broken by the wrap");
+}
+
+int main(void) {
+    TestSetup();
+    TestBatches();
+    TestPollThenInterrupt();
+    TestCounterWrap();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
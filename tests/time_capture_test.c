@@ -0,0 +1,142 @@
+/**
+ * time_capture_test.c
+ *
+ *  Register-mock test for the TIM2 capture modes. TIM2 and GPIOA are
+ *  test-owned structs and each edge is one call of TIM2_IRQHandler with the
+ *  capture registers and SR set up the way the hardware would leave them.
+ *  Checks that PWM-input mode feeds the period ring the readers use, and
+ *  that switching back to interrupt mode undoes CH2 and the slave-mode reset.
+ *
+ *    gcc -std=gnu11 -Wno-pointer-to-int-cast -Itests/stubs -ITimeCapture -IDma -IRcc \
+ *        -o time_capture_test tests/time_capture_test.c && ./time_capture_test
+ */
+
+#include <stdio.h>
+
+#include "TimeCapture.h"
+
+static TIMER_TypeDef host_tim2;
+GPIO_TypeDef host_gpioa;
+
+#undef TIMER2
+#define TIMER2 (&host_tim2)
+
+#include "../TimeCapture/TimeCapture.c"
+
+void Rcc_Enable(uint8 PeripheralId) { (void)PeripheralId; }
+uint32 Rcc_GetTimerClockHz(uint8 Bus) { (void)Bus; return 84000000UL; }
+void Dma_Init(uint8 Controller, uint8 Stream, const Dma_Config* Config) {
+    (void)Controller; (void)Stream; (void)Config;
+}
+void Dma_Start(uint8 Controller, uint8 Stream, uint32 PeriphAddr, uint32 MemAddr, uint16 Count) {
+    (void)Controller; (void)Stream; (void)PeriphAddr; (void)MemAddr; (void)Count;
+}
+void Dma_Stop(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; }
+uint16 Dma_GetRemaining(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; return 0; }
+uint8 Dma_GetFlags(uint8 Controller, uint8 Stream) { (void)Controller; (void)Stream; return 0; }
+void Dma_ClearFlags(uint8 Controller, uint8 Stream, uint8 Flags) {
+    (void)Controller; (void)Stream; (void)Flags;
+}
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// PWM input: a rising edge latches the period into CCR1 and the high time
+// of the cycle before it into CCR2
+static void PwmCycle(uint32_t period_ticks, uint32_t high_ticks) {
+    host_tim2.CCR1 = period_ticks;
+    host_tim2.CCR2 = high_ticks;
+    host_tim2.SR = CC1_IF;
+    TIM2_IRQHandler();
+}
+
+static void Stall(void) {
+    host_tim2.SR = UIF | CC1_IF;
+    TIM2_IRQHandler();
+}
+
+// Interrupt mode: free-running counter value at the edge
+static void Edge(uint32_t count) {
+    host_tim2.CCR1 = count;
+    host_tim2.SR = CC1_IF;
+    TIM2_IRQHandler();
+}
+
+static void TestPwmInputSetup(void) {
+    TimeCapture_InitPwmInput();
+    CHECK(host_tim2.SMCR == ((SMCR_TS_TI1FP1 << SMCR_TS_POS) | (SMCR_SMS_RESET << SMCR_SMS_POS)),
+          "SMCR = 0x%lx, expected reset mode on TI1FP1", (unsigned long)host_tim2.SMCR);
+    CHECK((host_tim2.CCMR1 & CC2S_MSK) == (0x2UL << CC2S_POS), "CC2 not mapped to TI1");
+    CHECK((host_tim2.CCER & (CC2E_MSK | CC2P_MSK)) == (CC2E_MSK | CC2P_MSK), "IC2 not on the falling edge");
+    CHECK(host_tim2.CR1 & URS_MSK, "slave resets would raise UIF");
+    CHECK(host_tim2.ARR == TIMECAPTURE_PWM_TIMEOUT, "ARR = %lu", (unsigned long)host_tim2.ARR);
+}
+
+static void TestPwmInputFeedsRing(void) {
+    uint32_t value = 0;
+
+    PwmCycle(700, 100);    // partial: measured from the start, not an edge
+    CHECK(!TimeCapture_ReadPeriod(&value), "first partial capture reached the ring");
+    CHECK(TimeCapture_GetDutyPermille() == 0, "duty reported before a full cycle");
+
+    const uint32_t cycles[] = { 1000, 1004, 996, 1000 };
+    for (unsigned i = 0; i < sizeof(cycles) / sizeof(cycles[0]); i++) {
+        PwmCycle(cycles[i], 250);
+        CHECK(host_tim2.DIER & CC1IE, "CC1 interrupt switched off, later periods would be lost");
+    }
+
+    for (unsigned i = 0; i < sizeof(cycles) / sizeof(cycles[0]); i++) {
+        CHECK(TimeCapture_ReadPeriod(&value) && value == cycles[i],
+              "period %u: read %lu, expected %lu", i, (unsigned long)value, (unsigned long)cycles[i]);
+    }
+    CHECK(!TimeCapture_ReadPeriod(&value), "ring holds more periods than edges");
+    CHECK(TimeCapture_GetAveragePeriod() == 1000, "average %lu", (unsigned long)TimeCapture_GetAveragePeriod());
+    CHECK(TimeCapture_GetPeriodCount() == 4, "count %lu", (unsigned long)TimeCapture_GetPeriodCount());
+    CHECK(TimeCapture_GetDutyPermille() == 250, "duty %u", TimeCapture_GetDutyPermille());
+
+    // After a stall the first capture is partial again
+    Stall();
+    CHECK(TimeCapture_GetPeriod() == 0, "period survived a stall");
+    PwmCycle(40000, 100);
+    CHECK(!TimeCapture_ReadPeriod(&value), "partial capture after a stall reached the ring");
+    PwmCycle(1000, 250);
+    CHECK(TimeCapture_ReadPeriod(&value) && value == 1000, "no period after the stall cleared");
+}
+
+static void TestBackToIrqMode(void) {
+    TimeCapture_Stop();
+    TimeCapture_Init();
+
+    CHECK(host_tim2.SMCR == 0, "slave-mode reset left on: SMCR = 0x%lx", (unsigned long)host_tim2.SMCR);
+    CHECK((host_tim2.CCMR1 & CC2S_MSK) == 0, "CC2 still mapped");
+    CHECK((host_tim2.CCER & (CC2E_MSK | CC2P_MSK)) == 0, "IC2 still enabled");
+    CHECK((host_tim2.CCMR1 & CC1S_MSK) == TIM_CCMR1_CC1S_0, "CC1 not on TI1");
+    CHECK(host_tim2.CCER & CAPTURE_ENABLE_MSK, "IC1 disabled");
+    CHECK(!(host_tim2.CR1 & URS_MSK), "URS left set, overflows would be filtered");
+    CHECK(host_tim2.ARR == 0xFFFFFFFFUL, "ARR = 0x%lx", (unsigned long)host_tim2.ARR);
+    CHECK(host_tim2.DIER == (CC1IE | UIE), "DIER = 0x%lx", (unsigned long)host_tim2.DIER);
+
+    uint32_t value = 0;
+    uint32_t before = TimeCapture_GetPeriodCount();
+    Edge(5000);     // stale PWM-input state must not turn this into a period
+    CHECK(TimeCapture_GetPeriodCount() == before, "first interrupt-mode edge produced a period");
+    Edge(5500);
+    CHECK(TimeCapture_GetPeriod() == 500, "period %lu", (unsigned long)TimeCapture_GetPeriod());
+    CHECK(TimeCapture_ReadPeriod(&value) && value == 500, "interrupt-mode period not queued");
+}
+
+int main(void) {
+    TestPwmInputSetup();
+    TestPwmInputFeedsRing();
+    TestBackToIrqMode();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
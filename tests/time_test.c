@@ -0,0 +1,162 @@
+/**
+ * time_test.c
+ *
+ *  Host test of the SysTick timebase. The SysTick registers are test-owned
+ *  variables and a simulated tick source counts CVR down at HCLK, calling
+ *  SysTick_Handler on every reload. Checks Time_GetMs, Time_GetUs (including
+ *  a tick landing between its two reads), Time_Elapsed and deadlines across
+ *  the 32-bit millisecond wrap.
+ *
+ *    gcc -std=gnu11 -Itests/stubs -ITime -IRcc \
+ *        -o time_test tests/time_test.c && ./time_test
+ */
+
+#include <stdio.h>
+
+#include "Time.h"
+#include "Time_Private.h"
+
+#define HOST_HCLK_HZ 84000000UL
+
+static uint32 host_csr;
+static uint32 host_rvr;
+static uint32 host_cvr;
+static int host_tick_on_read;   // fire the tick interrupt on the next CVR read
+
+static void SysTick_Step(uint32 Ticks);
+
+// Models the tick interrupt running after Time_GetUs has read time_ms but
+// before it reads CVR, so the count it sees belongs to the next millisecond
+static volatile uint32* HostCvr(void) {
+    if (host_tick_on_read) {
+        host_tick_on_read = 0;
+        SysTick_Step(1);
+    }
+    return &host_cvr;
+}
+
+#undef SYSTICK_CSR
+#undef SYSTICK_RVR
+#undef SYSTICK_CVR
+#define SYSTICK_CSR   host_csr
+#define SYSTICK_RVR   host_rvr
+#define SYSTICK_CVR   (*HostCvr())
+
+#include "../Time/Time.c"
+
+uint32 Rcc_GetHclkHz(void) { return HOST_HCLK_HZ; }
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { printf("FAIL %s:%d: ", __FILE__, __LINE__); printf(__VA_ARGS__); printf("\n"); failures++; } \
+} while (0)
+
+// Count SysTick down by Ticks HCLK cycles, reloading from RVR at zero
+static void SysTick_Step(uint32 Ticks) {
+    while (Ticks--) {
+        if (host_cvr == 0) {
+            host_cvr = host_rvr;
+            if (READ_BIT(host_csr, SYSTICK_ENABLE) && READ_BIT(host_csr, SYSTICK_TICKINT)) {
+                SysTick_Handler();
+            }
+        } else {
+            host_cvr--;
+        }
+    }
+}
+
+static void AdvanceMs(uint32 Ms) {
+    SysTick_Step(Ms * (HOST_HCLK_HZ / TIME_TICK_HZ));
+}
+
+static void TestInit(void) {
+    Time_Init();
+    CHECK(host_rvr == HOST_HCLK_HZ / TIME_TICK_HZ - 1, "RVR = %lu", (unsigned long)host_rvr);
+    CHECK(READ_BIT(host_csr, SYSTICK_ENABLE) && READ_BIT(host_csr, SYSTICK_TICKINT) &&
+          READ_BIT(host_csr, SYSTICK_CLKSOURCE), "CSR = 0x%lx", (unsigned long)host_csr);
+    CHECK(Time_GetMs() == 0, "ms starts at %lu", (unsigned long)Time_GetMs());
+}
+
+static void TestGetMs(void) {
+    uint32 start = Time_GetMs();
+    AdvanceMs(25);
+    CHECK(Time_GetMs() - start == 25, "25 ms of ticks gave %lu", (unsigned long)(Time_GetMs() - start));
+}
+
+static void TestGetUs(void) {
+    const uint32 ticks_per_us = HOST_HCLK_HZ / 1000000UL;
+    uint32 last = Time_GetUs();
+    uint32 elapsed_ticks = 0;
+    uint32 start = last;
+
+    // Odd step so the samples land all over the tick
+    for (int i = 0; i < 5000; i++) {
+        SysTick_Step(37);
+        elapsed_ticks += 37;
+        uint32 now = Time_GetUs();
+        CHECK(now >= last, "us went backwards: %lu after %lu", (unsigned long)now, (unsigned long)last);
+        uint32 expected = elapsed_ticks / ticks_per_us;
+        uint32 got = now - start;
+        CHECK(got + 1 >= expected && got <= expected + 1,
+              "after %lu ticks: %lu us, expected %lu", (unsigned long)elapsed_ticks,
+              (unsigned long)got, (unsigned long)expected);
+        if (failures) {
+            return;
+        }
+        last = now;
+    }
+
+    // Tick interrupt between the two reads: the reloaded count must not be
+    // paired with the old millisecond
+    while (host_cvr != 0) {
+        SysTick_Step(1);
+    }
+    uint32 before = Time_GetUs();
+    host_tick_on_read = 1;
+    uint32 across = Time_GetUs();
+    CHECK(across >= before && across - before <= 2,
+          "us jumped from %lu to %lu across a tick", (unsigned long)before, (unsigned long)across);
+}
+
+static void TestWrap(void) {
+    Time_Deadline deadline;
+
+    time_ms = 0xFFFFFFF0UL;    // 16 ms before the counter wraps
+    uint32 since = Time_GetMs();
+    Time_DeadlineStart(&deadline, 20);
+
+    AdvanceMs(15);
+    CHECK(!Time_Elapsed(since, 20), "20 ms interval elapsed after 15 ms");
+    CHECK(!Time_DeadlineExpired(&deadline), "deadline expired early");
+
+    AdvanceMs(4);
+    CHECK(Time_GetMs() < since, "counter did not wrap");
+    CHECK(!Time_DeadlineExpired(&deadline), "deadline expired after 19 ms across the wrap");
+
+    AdvanceMs(1);
+    CHECK(Time_Elapsed(since, 20), "20 ms interval not elapsed across the wrap");
+    CHECK(Time_DeadlineExpired(&deadline), "deadline missed across the wrap");
+    CHECK(Time_Elapsed(since, 0), "zero interval should always have elapsed");
+
+    // Microseconds wrap with the millisecond counter
+    time_ms = 0xFFFFFFFFUL;
+    uint32 at = Time_GetUs();
+    AdvanceMs(1);
+    uint32 after = Time_GetUs();
+    CHECK(after - at == 1000, "us step across the ms wrap: %lu", (unsigned long)(after - at));
+}
+
+int main(void) {
+    TestInit();
+    TestGetMs();
+    TestGetUs();
+    TestWrap();
+
+    if (failures) {
+        printf("%d check(s) failed\n", failures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
@@ -0,0 +1,212 @@
+/**
+ * telemetry_decode.c
+ *
+ *  Linux decoder for the Telemetry frames (see Telemetry/Telemetry.h).
+ *  Prints one CSV row per valid frame and, at EOF or Ctrl-C, a summary of
+ *  CRC errors, sequence gaps and throughput.
+ *
+ *    gcc -O2 -o telemetry_decode tools/telemetry_decode.c
+ *    ./telemetry_decode /dev/ttyUSB0 [baud]      # serial port, raw 8N1
+ *    ./telemetry_decode - < capture.bin          # recorded stream
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+#define SYNC0           0xA5
+#define SYNC1           0x5A
+#define PAYLOAD_SIZE    19U
+#define FRAME_SIZE      (4U + PAYLOAD_SIZE + 2U)
+
+static volatile sig_atomic_t stop = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static uint16_t crc16_ccitt_false(const uint8_t *data, size_t length) {
+    uint16_t crc = 0xFFFF;
+    for (size_t i = 0; i < length; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 0x8000) ? (uint16_t)((crc << 1) ^ 0x1021) : (uint16_t)(crc << 1);
+        }
+    }
+    return crc;
+}
+
+static uint16_t get16(const uint8_t *p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return (uint32_t)get16(p) | ((uint32_t)get16(p + 2) << 16);
+}
+
+struct decoder {
+    FILE *out;                  // CSV rows
+    uint8_t frame[FRAME_SIZE];
+    size_t have;
+    int last_seq;
+    unsigned long frames, crc_errors, gaps, skipped;
+};
+
+static void emit(struct decoder *d) {
+    const uint8_t *f = d->frame;
+    const uint8_t *p = f + 4;
+    uint8_t seq = f[3];
+
+    if (d->last_seq >= 0) {
+        d->gaps += (uint8_t)(seq - d->last_seq - 1);
+    }
+    d->last_seq = seq;
+    d->frames++;
+
+    fprintf(d->out, "%u,%u,%u,%u,%u,%u,%u,0x%02X\n", seq, get32(p), get32(p + 4), get32(p + 8),
+           get16(p + 12), get16(p + 14), get16(p + 16), p[18]);
+}
+
+static void feed(struct decoder *d, uint8_t byte) {
+    d->frame[d->have++] = byte;
+
+    // Hunt for sync and a plausible length before collecting the rest
+    if ((d->have == 1 && byte != SYNC0) ||
+        (d->have == 2 && byte != SYNC1) ||
+        (d->have == 3 && byte != PAYLOAD_SIZE)) {
+        d->skipped++;
+        d->have = 0;
+        if (byte == SYNC0) {
+            d->frame[d->have++] = byte;
+        }
+        return;
+    }
+    if (d->have < FRAME_SIZE) {
+        return;
+    }
+    d->have = 0;
+
+    if (crc16_ccitt_false(d->frame + 2, FRAME_SIZE - 4) == get16(d->frame + FRAME_SIZE - 2)) {
+        emit(d);
+        return;
+    }
+
+    // False sync or a corrupted frame: look for the real start in what was read
+    uint8_t rest[FRAME_SIZE - 1];
+    memcpy(rest, d->frame + 1, sizeof(rest));
+    d->crc_errors++;
+    for (size_t i = 0; i < sizeof(rest); i++) {
+        feed(d, rest[i]);
+    }
+}
+
+static speed_t baud_constant(long baud) {
+    switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    default: return 0;
+    }
+}
+
+static int open_input(const char *path, long baud) {
+    if (strcmp(path, "-") == 0) {
+        return STDIN_FILENO;
+    }
+
+    int fd = open(path, O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return -1;
+    }
+
+    struct termios tio;
+    if (tcgetattr(fd, &tio) == 0) {   // not a tty: read it as a file
+        speed_t speed = baud_constant(baud);
+        if (speed == 0) {
+            fprintf(stderr, "unsupported baud rate %ld\n", baud);
+            close(fd);
+            return -1;
+        }
+        cfmakeraw(&tio);
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tio.c_cflag |= CLOCAL | CREAD;
+        tio.c_cflag &= ~(CSTOPB | PARENB);
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        tcsetattr(fd, TCSANOW, &tio);
+        tcflush(fd, TCIFLUSH);
+    }
+    return fd;
+}
+
+static double now_s(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + (double)ts.tv_nsec * 1e-9;
+}
+
+int main(int argc, char **argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <tty|file|-> [baud]\n", argv[0]);
+        return 2;
+    }
+
+    long baud = (argc > 2) ? strtol(argv[2], NULL, 10) : 115200;
+    int fd = open_input(argv[1], baud);
+    if (fd < 0) {
+        return 1;
+    }
+
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+
+    struct decoder d = {.out = stdout, .last_seq = -1};
+    unsigned long bytes = 0;
+    double start = now_s();
+
+    printf("seq,timestamp_us,object_count,period_ticks,speed_mm_s,duty,adc_raw,faults\n");
+
+    while (!stop) {
+        uint8_t chunk[256];
+        ssize_t n = read(fd, chunk, sizeof(chunk));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            break;
+        }
+        bytes += (unsigned long)n;
+
+        for (ssize_t i = 0; i < n; i++) {
+            feed(&d, chunk[i]);
+        }
+        fflush(stdout);
+    }
+
+    double elapsed = now_s() - start;
+    fprintf(stderr, "%lu frames, %lu CRC errors, %lu missing by sequence, %lu bytes skipped\n",
+            d.frames, d.crc_errors, d.gaps, d.skipped);
+    if (elapsed > 0) {
+        fprintf(stderr, "%.1f s, %.1f frames/s, %.0f bytes/s\n", elapsed, d.frames / elapsed, bytes / elapsed);
+    }
+
+    if (fd != STDIN_FILENO) {
+        close(fd);
+    }
+    return d.crc_errors != 0;
+}